@@ -0,0 +1,255 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Splits a FLAC image into tracks with the in-process decoder, the way a cue sheet is split in "direct" mode,
+ * and checks that every track holds exactly the samples of its range. Every track is decoded through a pipeline
+ * that is flushed to a file, so the pipeline has to complete although the source stops before the end of the image.
+ * Every track but the first one starts with a seek, so the seek has to be sample-accurate.
+ */
+
+//Internal
+#include "../../src/Decoder_LibFLAC.h"
+#include "../../src/Tool_StreamPipeline.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QDir>
+#include <QFile>
+#include <QVector>
+#include <QtEndian>
+
+//libFLAC
+#include <FLAC/stream_encoder.h>
+
+//CRT
+#include <stdio.h>
+#include <float.h>
+#include <limits>
+
+#define SAMPLERATE 44100
+#define CHANNELS 2
+#define IMAGE_FRAMES (SAMPLERATE * 12)
+#define ENCODE_BLOCK_FRAMES 4096
+
+//Track offsets in seconds, as given by a cue sheet (multiples of 1/75 s); the last track extends to the end of the image
+static const double TRACKS[] = { 0.0, 2.0, 4.0 + (13.0 / 75.0), 7.5, 11.0 + (74.0 / 75.0) };
+
+//The in-process decoder does not need any external tools
+const QString lamexp_tools_lookup(const QString& /*toolName*/)
+{
+	return QString();
+}
+
+////////////////////////////////////////////////////////////
+// Test Data
+////////////////////////////////////////////////////////////
+
+/*
+ * Every sample of the image is unique, so that a track that is off by a single frame is detected
+ */
+static inline qint16 sampleValue(const quint64 frame, const int channel)
+{
+	quint32 x = (static_cast<quint32>(frame) * 2654435761U) + (static_cast<quint32>(channel) * 0x9E3779B9U);
+	x ^= x >> 15;
+	return static_cast<qint16>(x & 0xFFFF);
+}
+
+static bool createImage(const QString &imageFile)
+{
+	FLAC__StreamEncoder *const encoder = FLAC__stream_encoder_new();
+	if(!encoder)
+	{
+		return false;
+	}
+
+	FLAC__stream_encoder_set_channels(encoder, CHANNELS);
+	FLAC__stream_encoder_set_bits_per_sample(encoder, 16);
+	FLAC__stream_encoder_set_sample_rate(encoder, SAMPLERATE);
+	FLAC__stream_encoder_set_total_samples_estimate(encoder, IMAGE_FRAMES);
+
+	//The encoder owns the file once it has been initialized, the file must be readable so that the seek table can be written
+	FILE *const file = _wfopen(MUTILS_WCHR(QDir::toNativeSeparators(imageFile)), L"w+b");
+	if((!file) || (FLAC__stream_encoder_init_FILE(encoder, file, NULL, NULL) != FLAC__STREAM_ENCODER_INIT_STATUS_OK))
+	{
+		if(file) fclose(file);
+		FLAC__stream_encoder_delete(encoder);
+		return false;
+	}
+
+	QVector<FLAC__int32> buffer(ENCODE_BLOCK_FRAMES * CHANNELS);
+	bool success = true;
+
+	for(quint64 pos = 0; success && (pos < IMAGE_FRAMES); pos += ENCODE_BLOCK_FRAMES)
+	{
+		const int frames = static_cast<int>(qMin(static_cast<quint64>(ENCODE_BLOCK_FRAMES), IMAGE_FRAMES - pos));
+		for(int i = 0; i < frames; i++)
+		{
+			for(int c = 0; c < CHANNELS; c++)
+			{
+				buffer[(i * CHANNELS) + c] = sampleValue(pos + i, c);
+			}
+		}
+		success = MUTILS_BOOLIFY(FLAC__stream_encoder_process_interleaved(encoder, buffer.constData(), frames));
+	}
+
+	if(!FLAC__stream_encoder_finish(encoder))
+	{
+		success = false;
+	}
+
+	FLAC__stream_encoder_delete(encoder);
+	return success;
+}
+
+////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////
+
+/*
+ * Find the "data" chunk of a RIFF Wave file
+ */
+static bool findData(const QByteArray &wave, int &offset, quint32 &size)
+{
+	if((wave.size() < 12) || (!wave.startsWith("RIFF")) || (wave.mid(8, 4) != "WAVE"))
+	{
+		return false;
+	}
+
+	for(int pos = 12; pos + 8 <= wave.size(); )
+	{
+		const quint32 chunkSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(wave.constData()) + pos + 4);
+		if(wave.mid(pos, 4) == "data")
+		{
+			offset = pos + 8;
+			size = chunkSize;
+			return true;
+		}
+		pos += 8 + static_cast<int>(chunkSize + (chunkSize & 1U));
+	}
+
+	return false;
+}
+
+static int testTrack(const QString &imageFile, const QString &trackFile, const int track, const quint64 firstFrame, const quint64 frameCount)
+{
+	const quint64 expectedFrames = (frameCount > 0U) ? frameCount : (IMAGE_FRAMES - firstFrame);
+	printf("Track %02d: from frame %7llu, %7llu frames ... ", track, firstFrame, expectedFrames);
+
+	LibFLACDecoder *const decoder = new LibFLACDecoder();
+	AbstractDecoder::streamInfo_t info;
+	if(!decoder->openStream(imageFile, info))
+	{
+		printf("FAILED: The image could not be opened!\n");
+		delete decoder;
+		return 1;
+	}
+
+	QAtomicInt abortFlag(0);
+	StreamPipeline pipeline;
+	pipeline.setSource(new DecoderSource(decoder, info, firstFrame, frameCount));
+	if(!pipeline.flush(trackFile, abortFlag))
+	{
+		printf("FAILED: The pipeline did not complete!\n");
+		return 1;
+	}
+
+	QFile file(trackFile);
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		printf("FAILED: The track could not be read!\n");
+		return 1;
+	}
+
+	const QByteArray wave = file.readAll();
+	int offset = 0;
+	quint32 size = 0;
+	if(!findData(wave, offset, size))
+	{
+		printf("FAILED: The track is not a valid Wave file!\n");
+		return 1;
+	}
+
+	if((size != expectedFrames * CHANNELS * sizeof(qint16)) || (static_cast<quint64>(wave.size()) < static_cast<quint64>(offset) + size))
+	{
+		printf("FAILED: The track holds %u bytes, expected %llu bytes!\n", size, expectedFrames * CHANNELS * sizeof(qint16));
+		return 1;
+	}
+
+	const uchar *const data = reinterpret_cast<const uchar*>(wave.constData()) + offset;
+	for(quint64 i = 0; i < expectedFrames; i++)
+	{
+		for(int c = 0; c < CHANNELS; c++)
+		{
+			const qint16 value = qFromLittleEndian<qint16>(data + (((i * CHANNELS) + c) * sizeof(qint16)));
+			if(value != sampleValue(firstFrame + i, c))
+			{
+				printf("FAILED: Frame %llu, channel %d is %d, expected %d!\n", i, c, int(value), int(sampleValue(firstFrame + i, c)));
+				return 1;
+			}
+		}
+	}
+
+	printf("OK\n");
+	return 0;
+}
+
+////////////////////////////////////////////////////////////
+// Main
+////////////////////////////////////////////////////////////
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+	const QString imageFile = QDir::temp().absoluteFilePath("~cuesplit_test.flac");
+	const QString trackFile = QDir::temp().absoluteFilePath("~cuesplit_test.wav");
+
+	printf("CueSplit test, libFLAC %s\n\n", FLAC__VERSION_STRING);
+
+	if(!createImage(imageFile))
+	{
+		printf("FAILED: The image could not be created!\n");
+		QFile::remove(imageFile);
+		return 1;
+	}
+
+	const int trackCount = sizeof(TRACKS) / sizeof(TRACKS[0]);
+	int failures = 0;
+
+	for(int i = 0; i < trackCount; i++)
+	{
+		const double length = ((i + 1) < trackCount) ? (TRACKS[i + 1] - TRACKS[i]) : std::numeric_limits<double>::infinity();
+
+		//Same rounding as the "trim" filter, so that the tracks are contiguous
+		const quint64 firstFrame = static_cast<quint64>(qRound64(TRACKS[i] * SAMPLERATE));
+		const quint64 frameCount = _finite(length) ? (static_cast<quint64>(qRound64((TRACKS[i] + length) * SAMPLERATE)) - firstFrame) : 0ui64;
+
+		failures += testTrack(imageFile, trackFile, i + 1, firstFrame, frameCount);
+		QFile::remove(trackFile);
+	}
+
+	QFile::remove(imageFile);
+
+	printf("\n%s\n", failures ? "Some tests have FAILED!" : "All tests have passed.");
+	return failures ? 1 : 0;
+}
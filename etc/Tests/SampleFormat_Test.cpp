@@ -0,0 +1,429 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Checks the SIMD code paths of SampleFormat against the scalar reference, for every sample format and
+ * every instruction set the CPU supports. All code paths are required to produce bit-identical output.
+ * Run with "--bench" to also measure the throughput of each code path.
+ */
+
+//Internal
+#include "../../src/Tool_SampleFormat.h"
+
+//Qt
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+//CRT
+#include <stdio.h>
+#include <string.h>
+#include <limits>
+
+#define GUARD_SIZE 64
+#define GUARD_BYTE '\xCD'
+#define BENCH_SAMPLES 1048576
+#define BENCH_ROUNDS 64
+
+static const SampleFormat::format_t FORMATS[] =
+{
+	SampleFormat::FORMAT_U8, SampleFormat::FORMAT_S16, SampleFormat::FORMAT_S24, SampleFormat::FORMAT_S32, SampleFormat::FORMAT_F32, SampleFormat::FORMAT_F64
+};
+
+static const char *const FORMAT_NAMES[] = { "U8", "S16", "S24", "S32", "F32", "F64" };
+static const char *const SIMD_NAMES[] = { "Scalar", "SSE2", "AVX", "AVX2" };
+
+//Sample counts around the block sizes of the SIMD loops, so that every tail length is covered
+static const int COUNTS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 10, 11, 15, 16, 17, 18, 19, 23, 24, 25, 31, 32, 33, 63, 64, 65, 1000, 4099 };
+
+////////////////////////////////////////////////////////////
+// Test Data
+////////////////////////////////////////////////////////////
+
+class Random
+{
+public:
+	Random(const quint32 seed) : m_state(seed) {}
+
+	inline quint32 next(void)
+	{
+		m_state ^= m_state << 13;
+		m_state ^= m_state >> 17;
+		m_state ^= m_state << 5;
+		return m_state;
+	}
+
+	inline float nextFloat(const float range)
+	{
+		return ((static_cast<float>(next() & 0xFFFFFF) / 8388608.0f) - 1.0f) * range;
+	}
+
+private:
+	quint32 m_state;
+};
+
+/*
+ * Float samples, mostly in range, with clipping and rounding edge cases mixed in
+ */
+static QVector<float> makeFloatSamples(const int count, Random &random)
+{
+	static const float SCALES[] = { 128.0f, 32768.0f, 8388608.0f, 2147483648.0f };
+
+	QVector<float> edges;
+	edges << 0.0f << -0.0f << 1.0f << -1.0f << 1.0000001f << -1.0000001f << 2.0f << -2.0f << 1e9f << -1e9f;
+	edges << std::numeric_limits<float>::infinity() << -std::numeric_limits<float>::infinity() << std::numeric_limits<float>::quiet_NaN();
+	edges << std::numeric_limits<float>::denorm_min() << -std::numeric_limits<float>::denorm_min();
+	for(size_t s = 0; s < sizeof(SCALES) / sizeof(SCALES[0]); s++)
+	{
+		const float scale = SCALES[s];
+		for(int k = -3; k <= 2; k++)
+		{
+			edges << ((static_cast<float>(k) + 0.5f) / scale); /*exactly half way, rounds to even*/
+		}
+		edges << ((scale - 1.0f) / scale) << ((scale - 0.5f) / scale) << (-(scale + 0.5f) / scale) << (-(scale - 1.0f) / scale);
+	}
+
+	QVector<float> samples(count);
+	for(int i = 0; i < count; i++)
+	{
+		samples[i] = ((random.next() % 4U) == 0U) ? edges.at(random.next() % edges.count()) : random.nextFloat(1.05f);
+	}
+	return samples;
+}
+
+/*
+ * Raw samples in the given format, random bit patterns with the extreme values mixed in
+ */
+static QByteArray makeRawSamples(const SampleFormat::format_t format, const int count, Random &random)
+{
+	const int size = SampleFormat::bytesPerSample(format);
+	QByteArray data(count * size, '\0');
+	uchar *const ptr = reinterpret_cast<uchar*>(data.data());
+
+	for(int i = 0; i < count * size; i++)
+	{
+		ptr[i] = static_cast<uchar>(random.next() & 0xFF);
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		if((random.next() % 4U) != 0U)
+		{
+			continue;
+		}
+		uchar *const sample = ptr + (i * size);
+		const quint32 pick = random.next() % 4U;
+		switch(format)
+		{
+		case SampleFormat::FORMAT_F32:
+			{
+				const float values[] = { 1.0f, -1.0f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN() };
+				memcpy(sample, &values[pick], sizeof(float));
+			}
+			break;
+		case SampleFormat::FORMAT_F64:
+			{
+				const double values[] = { 1.0, 1e300, std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::infinity() };
+				memcpy(sample, &values[pick], sizeof(double));
+			}
+			break;
+		default:
+			{
+				//Most negative, most positive, minus one and zero (little endian, two's complement, U8 is biased)
+				static const uchar patterns[4][4] = { { 0x00, 0x00, 0x00, 0x80 }, { 0xFF, 0xFF, 0xFF, 0x7F }, { 0xFF, 0xFF, 0xFF, 0xFF }, { 0x00, 0x00, 0x00, 0x00 } };
+				if(format == SampleFormat::FORMAT_U8)
+				{
+					static const uchar bytes[4] = { 0x00, 0xFF, 0x7F, 0x80 };
+					sample[0] = bytes[pick];
+				}
+				else
+				{
+					memset(sample, patterns[pick][0], size - 1);
+					sample[size - 1] = patterns[pick][3];
+				}
+			}
+			break;
+		}
+	}
+
+	return data;
+}
+
+////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////
+
+static bool checkGuard(const char *const ptr)
+{
+	for(int i = 0; i < GUARD_SIZE; i++)
+	{
+		if(ptr[i] != GUARD_BYTE)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static int testToFloat(const SampleFormat::format_t format, const SampleFormat::simd_t level, const QByteArray &input, const int count)
+{
+	QByteArray expected((count * sizeof(float)) + GUARD_SIZE, GUARD_BYTE), actual(expected);
+
+	SampleFormat::setSimdLevel(SampleFormat::SIMD_NONE);
+	SampleFormat::toFloat(format, input.constData(), reinterpret_cast<float*>(expected.data()), count);
+	SampleFormat::setSimdLevel(level);
+	SampleFormat::toFloat(format, input.constData(), reinterpret_cast<float*>(actual.data()), count);
+
+	if(!checkGuard(actual.constData() + (count * sizeof(float))))
+	{
+		printf("FAILED: toFloat, %s, %s, count=%d: wrote past the end of the output!\n", FORMAT_NAMES[format], SIMD_NAMES[level], count);
+		return 1;
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		if(memcmp(expected.constData() + (i * sizeof(float)), actual.constData() + (i * sizeof(float)), sizeof(float)) != 0)
+		{
+			const float *const e = reinterpret_cast<const float*>(expected.constData()), *const a = reinterpret_cast<const float*>(actual.constData());
+			printf("FAILED: toFloat, %s, %s, count=%d: sample %d is %.9g, expected %.9g\n", FORMAT_NAMES[format], SIMD_NAMES[level], count, i, a[i], e[i]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int testFromFloat(const SampleFormat::format_t format, const SampleFormat::simd_t level, const QVector<float> &input, const int count)
+{
+	const int size = SampleFormat::bytesPerSample(format);
+	QByteArray expected((count * size) + GUARD_SIZE, GUARD_BYTE), actual(expected);
+
+	SampleFormat::setSimdLevel(SampleFormat::SIMD_NONE);
+	SampleFormat::fromFloat(format, input.constData(), expected.data(), count);
+	SampleFormat::setSimdLevel(level);
+	SampleFormat::fromFloat(format, input.constData(), actual.data(), count);
+
+	if(!checkGuard(actual.constData() + (count * size)))
+	{
+		printf("FAILED: fromFloat, %s, %s, count=%d: wrote past the end of the output!\n", FORMAT_NAMES[format], SIMD_NAMES[level], count);
+		return 1;
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		if(memcmp(expected.constData() + (i * size), actual.constData() + (i * size), size) != 0)
+		{
+			printf("FAILED: fromFloat, %s, %s, count=%d: sample %d (input %.9g) differs from the scalar reference\n", FORMAT_NAMES[format], SIMD_NAMES[level], count, i, input.at(i));
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Values that must come out exactly, independent of the code path
+ */
+static int testEdgeValues(const SampleFormat::simd_t level)
+{
+	static const float input[] = { 1.0f, -1.0f, 2.0f, -2.0f, 0.0f, 8388607.0f / 8388608.0f, -8388608.0f / 8388608.0f, 0.5f / 8388608.0f, 1.5f / 8388608.0f, -0.5f / 8388608.0f };
+	static const qint32 expectedS24[] = { 8388607, -8388608, 8388607, -8388608, 0, 8388607, -8388608, 0, 2, 0 };
+	static const qint16 expectedS16[] = { 32767, -32768, 32767, -32768, 0, 32767, -32768, 0, 0, 0 };
+
+	const int count = sizeof(input) / sizeof(input[0]);
+	int failures = 0;
+
+	//Repeat the values, so that they also go through the SIMD loops
+	QVector<float> samples;
+	for(int r = 0; r < 4; r++)
+	{
+		for(int i = 0; i < count; i++) samples << input[i];
+	}
+
+	SampleFormat::setSimdLevel(level);
+
+	QByteArray s24(samples.count() * 3, '\0');
+	SampleFormat::fromFloat(SampleFormat::FORMAT_S24, samples.constData(), s24.data(), samples.count());
+	for(int i = 0; i < samples.count(); i++)
+	{
+		const uchar *const p = reinterpret_cast<const uchar*>(s24.constData()) + (3 * i);
+		const qint32 value = static_cast<qint32>((quint32(p[0]) << 8) | (quint32(p[1]) << 16) | (quint32(p[2]) << 24)) >> 8;
+		if(value != expectedS24[i % count])
+		{
+			printf("FAILED: Edge value, S24, %s: input %.9g gave %d, expected %d\n", SIMD_NAMES[level], samples.at(i), value, expectedS24[i % count]);
+			failures++;
+		}
+	}
+
+	QVector<qint16> s16(samples.count());
+	SampleFormat::fromFloat(SampleFormat::FORMAT_S16, samples.constData(), s16.data(), samples.count());
+	for(int i = 0; i < samples.count(); i++)
+	{
+		if(s16.at(i) != expectedS16[i % count])
+		{
+			printf("FAILED: Edge value, S16, %s: input %.9g gave %d, expected %d\n", SIMD_NAMES[level], samples.at(i), int(s16.at(i)), int(expectedS16[i % count]));
+			failures++;
+		}
+	}
+
+	//The full 24-Bit range must survive the round trip
+	static const uchar raw[] = { 0x00, 0x00, 0x80, 0xFF, 0xFF, 0x7F, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	QByteArray in24, out24;
+	for(int r = 0; r < 8; r++) in24.append(reinterpret_cast<const char*>(raw), sizeof(raw));
+	QVector<float> decoded(in24.size() / 3);
+	out24.resize(in24.size());
+	SampleFormat::toFloat(SampleFormat::FORMAT_S24, in24.constData(), decoded.data(), decoded.count());
+	SampleFormat::fromFloat(SampleFormat::FORMAT_S24, decoded.constData(), out24.data(), decoded.count());
+	if(in24 != out24)
+	{
+		printf("FAILED: Edge value, S24 round trip, %s\n", SIMD_NAMES[level]);
+		failures++;
+	}
+
+	return failures;
+}
+
+static int testLayout(const SampleFormat::simd_t level, Random &random)
+{
+	int failures = 0;
+	for(int channels = 1; channels <= 3; channels++)
+	{
+		for(size_t n = 0; n < sizeof(COUNTS) / sizeof(COUNTS[0]); n++)
+		{
+			const int frames = COUNTS[n];
+			const QVector<float> input = makeFloatSamples(frames * channels, random);
+			QVector<QVector<float> > planes(channels, QVector<float>(frames));
+			QVector<float*> dst(channels);
+			for(int c = 0; c < channels; c++) dst[c] = planes[c].data();
+			QVector<float> output(frames * channels);
+
+			SampleFormat::setSimdLevel(level);
+			SampleFormat::deinterleave(input.constData(), dst.data(), channels, frames);
+			SampleFormat::interleave(dst.constData(), output.data(), channels, frames);
+
+			bool okay = (memcmp(input.constData(), output.constData(), frames * channels * sizeof(float)) == 0);
+			for(int c = 0; okay && (c < channels); c++)
+			{
+				for(int i = 0; okay && (i < frames); i++)
+				{
+					okay = (memcmp(&planes[c][i], &input[(i * channels) + c], sizeof(float)) == 0);
+				}
+			}
+			if(!okay)
+			{
+				printf("FAILED: Channel layout, %s, channels=%d, frames=%d\n", SIMD_NAMES[level], channels, frames);
+				failures++;
+			}
+		}
+	}
+	return failures;
+}
+
+////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////
+
+static void benchmark(const SampleFormat::simd_t maxLevel)
+{
+	Random random(0x2545F491);
+	const QVector<float> samples = makeFloatSamples(BENCH_SAMPLES, random);
+	QByteArray raw(BENCH_SAMPLES * sizeof(double), '\0');
+	QVector<float> decoded(BENCH_SAMPLES);
+
+	printf("\nThroughput in MSamples/s (%d samples, %d rounds):\n\n%-6s", BENCH_SAMPLES, BENCH_ROUNDS, "");
+	for(int level = SampleFormat::SIMD_NONE; level <= maxLevel; level++)
+	{
+		printf("%12s%12s", QByteArray(SIMD_NAMES[level]).append(" dec").constData(), QByteArray(SIMD_NAMES[level]).append(" enc").constData());
+	}
+	printf("\n");
+
+	for(size_t f = 0; f < sizeof(FORMATS) / sizeof(FORMATS[0]); f++)
+	{
+		printf("%-6s", FORMAT_NAMES[FORMATS[f]]);
+		for(int level = SampleFormat::SIMD_NONE; level <= maxLevel; level++)
+		{
+			SampleFormat::setSimdLevel(static_cast<SampleFormat::simd_t>(level));
+			QElapsedTimer timer;
+
+			timer.start();
+			for(int r = 0; r < BENCH_ROUNDS; r++) SampleFormat::toFloat(FORMATS[f], raw.constData(), decoded.data(), BENCH_SAMPLES);
+			const qint64 decodeTime = qMax(1LL, timer.nsecsElapsed());
+
+			timer.start();
+			for(int r = 0; r < BENCH_ROUNDS; r++) SampleFormat::fromFloat(FORMATS[f], samples.constData(), raw.data(), BENCH_SAMPLES);
+			const qint64 encodeTime = qMax(1LL, timer.nsecsElapsed());
+
+			const double total = static_cast<double>(BENCH_SAMPLES) * static_cast<double>(BENCH_ROUNDS) * 1000.0;
+			printf("%12.1f%12.1f", total / static_cast<double>(decodeTime), total / static_cast<double>(encodeTime));
+		}
+		printf("\n");
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Main
+////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+	const SampleFormat::simd_t maxLevel = SampleFormat::simdLevel();
+	printf("SampleFormat test, the CPU supports up to %s\n\n", SIMD_NAMES[maxLevel]);
+
+	Random random(0x9E3779B9);
+	int failures = 0;
+
+	for(int level = SampleFormat::SIMD_SSE2; level <= maxLevel; level++)
+	{
+		const SampleFormat::simd_t simd = static_cast<SampleFormat::simd_t>(level);
+		int levelFailures = 0;
+
+		for(size_t f = 0; f < sizeof(FORMATS) / sizeof(FORMATS[0]); f++)
+		{
+			for(size_t n = 0; n < sizeof(COUNTS) / sizeof(COUNTS[0]); n++)
+			{
+				for(int round = 0; round < 8; round++)
+				{
+					levelFailures += testToFloat(FORMATS[f], simd, makeRawSamples(FORMATS[f], COUNTS[n], random), COUNTS[n]);
+					levelFailures += testFromFloat(FORMATS[f], simd, makeFloatSamples(COUNTS[n], random), COUNTS[n]);
+				}
+			}
+		}
+
+		levelFailures += testEdgeValues(simd);
+		levelFailures += testLayout(simd, random);
+
+		printf("%-6s %s\n", SIMD_NAMES[level], levelFailures ? "FAILED" : "passed");
+		failures += levelFailures;
+	}
+
+	//The scalar reference must get the edge values right, too
+	failures += testEdgeValues(SampleFormat::SIMD_NONE);
+
+	if((argc > 1) && (strcmp(argv[1], "--bench") == 0))
+	{
+		benchmark(maxLevel);
+	}
+
+	SampleFormat::setSimdLevel(maxLevel);
+	printf("\n%s\n", failures ? "Some tests have FAILED!" : "All tests have passed.");
+	return failures ? 1 : 0;
+}
@@ -86,6 +86,11 @@ bool ADPCMDecoder::decode(const QString &sourceFile, const QString &outputFile,
 	return (result == RESULT_SUCCESS);
 }
 
+bool ADPCMDecoder::supportsWave64(void)
+{
+	return true; /*SoX selects the output format by the file extension*/
+}
+
 bool ADPCMDecoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	if(containerType.compare(QLatin1String("Wave"), Qt::CaseInsensitive) == 0)
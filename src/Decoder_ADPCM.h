@@ -31,6 +31,7 @@ public:
 	~ADPCMDecoder(void);
 
 	virtual bool decode(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag);
+	virtual bool supportsWave64(void);
 	static bool isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion);
 	static const supportedType_t *supportedTypes(void);
 
@@ -22,8 +22,20 @@
 
 #include "Decoder_Abstract.h"
 
+//Internal
+#include "Tool_WaveProperties.h"
+
+//MUtils
 #include <MUtils/Exception.h>
 
+//Qt
+#include <QtEndian>
+#include <QFile>
+#include <QDir>
+
+#define UNKNOWN_SIZE 0xFFFFFFFFui64
+#define DECODE_BLOCK_FRAMES 16384
+
 AbstractDecoder::AbstractDecoder(void)
 {
 }
@@ -49,4 +61,258 @@ bool AbstractDecoder::isDecoderAvailable(void)
 const AbstractDecoder::supportedType_t *AbstractDecoder::supportedTypes(void)
 {
 	MUTILS_THROW("This function must be re-implemented in sub-classes!");
-}
\ No newline at end of file
+}
+
+bool AbstractDecoder::createPipelineStage(const QString& /*sourceFile*/, QString& /*program*/, QStringList& /*args*/)
+{
+	return false; /*decoder can not write to a pipe*/
+}
+
+bool AbstractDecoder::createTrackStage(const QString& /*sourceFile*/, const quint64 /*firstFrame*/, const quint64 /*frameCount*/, QString& /*program*/, QStringList& /*args*/)
+{
+	return false; /*decoder can not skip to the start of a track*/
+}
+
+bool AbstractDecoder::isReadableInPlace(void)
+{
+	return false; /*source needs to be decoded*/
+}
+
+bool AbstractDecoder::supportsWave64(void)
+{
+	return false; /*decoder always writes RIFF Wave*/
+}
+
+bool AbstractDecoder::openStream(const QString& /*sourceFile*/, streamInfo_t& /*info*/)
+{
+	return false; /*decoder does not run in-process*/
+}
+
+int AbstractDecoder::readFrames(float *const /*buffer*/, const int /*frames*/)
+{
+	return -1;
+}
+
+bool AbstractDecoder::seekStream(const quint64 /*frame*/)
+{
+	return false; /*stream can only be read sequentially*/
+}
+
+void AbstractDecoder::closeStream(void)
+{
+}
+
+/*
+ * Helper functions
+ */
+
+static SampleFormat::format_t outputFormat(const quint16 bitsPerSample)
+{
+	if(bitsPerSample <= 8)  return SampleFormat::FORMAT_U8;
+	if(bitsPerSample <= 16) return SampleFormat::FORMAT_S16;
+	if(bitsPerSample <= 24) return SampleFormat::FORMAT_S24;
+	return SampleFormat::FORMAT_S32;
+}
+
+static QByteArray outputHeader(const AbstractDecoder::streamInfo_t &info, const SampleFormat::format_t &format)
+{
+	//Samples are always written in a container of full bytes
+	const int sampleSize = SampleFormat::bytesPerSample(format);
+	const int blockAlign = info.channels * sampleSize;
+
+	QByteArray formatChunk(16, '\0');
+	uchar *const fmt = reinterpret_cast<uchar*>(formatChunk.data());
+	qToLittleEndian<quint16>(0x0001, fmt);
+	qToLittleEndian<quint16>(info.channels, fmt + 2);
+	qToLittleEndian<quint32>(info.samplerate, fmt + 4);
+	qToLittleEndian<quint32>(info.samplerate * blockAlign, fmt + 8);
+	qToLittleEndian<quint16>(static_cast<quint16>(blockAlign), fmt + 12);
+	qToLittleEndian<quint16>(static_cast<quint16>(8 * sampleSize), fmt + 14);
+
+	return WaveProperties::makeHeader(formatChunk, (info.frames > 0U) ? (info.frames * blockAlign) : UNKNOWN_SIZE);
+}
+
+static AbstractDecoder::streamInfo_t rangeInfo(const AbstractDecoder::streamInfo_t &info, const quint64 firstFrame, const quint64 frameCount)
+{
+	AbstractDecoder::streamInfo_t result = info;
+	if(frameCount > 0U)
+	{
+		result.frames = (info.frames > 0U) ? qMin(frameCount, (info.frames > firstFrame) ? (info.frames - firstFrame) : 0ui64) : frameCount;
+	}
+	else if(info.frames > 0U)
+	{
+		result.frames = (info.frames > firstFrame) ? (info.frames - firstFrame) : 0ui64;
+	}
+	return result;
+}
+
+bool AbstractDecoder::decodeStream(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag)
+{
+	streamInfo_t info;
+	if(!openStream(sourceFile, info))
+	{
+		emit messageLogged(QString("Failed to open input file: %1").arg(QDir::toNativeSeparators(sourceFile)));
+		return false;
+	}
+
+	QFile output(outputFile);
+	if(!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		emit messageLogged(QString("Failed to open output file: %1").arg(QDir::toNativeSeparators(outputFile)));
+		closeStream();
+		return false;
+	}
+
+	const SampleFormat::format_t format = outputFormat(info.bitsPerSample);
+	const int blockAlign = info.channels * SampleFormat::bytesPerSample(format);
+	const QByteArray header = outputHeader(info, format);
+
+	QVector<float> buffer(DECODE_BLOCK_FRAMES * info.channels);
+	QByteArray data;
+	quint64 framesDone = 0;
+	int prevProgress = -1;
+
+	bool success = (output.write(header) == header.size());
+	while(success)
+	{
+		if(CHECK_FLAG(abortFlag))
+		{
+			emit messageLogged("\nABORTED BY USER !!!");
+			success = false;
+			break;
+		}
+
+		const int frames = readFrames(buffer.data(), DECODE_BLOCK_FRAMES);
+		if(frames < 0)
+		{
+			emit messageLogged("Failed to decode the input file :-(");
+			success = false;
+			break;
+		}
+		if(frames < 1)
+		{
+			break; /*end of stream*/
+		}
+
+		data.resize(frames * blockAlign);
+		SampleFormat::fromFloat(format, buffer.constData(), data.data(), frames * info.channels);
+		success = (output.write(data) == data.size());
+
+		framesDone += frames;
+		const int newProgress = (info.frames > 0U) ? static_cast<int>(qMin(100ui64, (100ui64 * framesDone) / info.frames)) : 0;
+		if(newProgress > prevProgress)
+		{
+			emit statusUpdated(newProgress);
+			prevProgress = NEXT_PROGRESS(newProgress);
+		}
+	}
+
+	closeStream();
+	output.close();
+
+	//The length given by the stream info may be missing or inexact, so the header is fixed up afterwards
+	if(success && (!WaveProperties::updateHeader(outputFile)))
+	{
+		emit messageLogged("Failed to update the Wave header of the output file :-(");
+		success = false;
+	}
+
+	emit statusUpdated(100);
+	return success;
+}
+
+/*
+ * Decoder Source
+ */
+
+DecoderSource::DecoderSource(AbstractDecoder *const decoder, const AbstractDecoder::streamInfo_t &info, const quint64 firstFrame, const quint64 frameCount)
+:
+	m_decoder(decoder),
+	m_info(rangeInfo(info, firstFrame, frameCount)),
+	m_firstFrame(firstFrame),
+	m_frameCount(frameCount),
+	m_format(outputFormat(info.bitsPerSample)),
+	m_headerDone(false),
+	m_framesRead(0)
+{
+}
+
+DecoderSource::~DecoderSource(void)
+{
+	m_decoder->closeStream();
+	delete m_decoder;
+}
+
+bool DecoderSource::open(void)
+{
+	m_headerDone = false;
+	m_framesRead = 0;
+
+	if((m_info.channels < 1) || (m_info.samplerate < 1))
+	{
+		return false;
+	}
+
+	//Seek to the start of the range, or skip the frames before it, if the decoder can not seek
+	quint64 skipped = ((m_firstFrame > 0U) && m_decoder->seekStream(m_firstFrame)) ? m_firstFrame : 0U;
+	m_buffer.resize(DECODE_BLOCK_FRAMES * m_info.channels);
+	while(skipped < m_firstFrame)
+	{
+		const int frames = m_decoder->readFrames(m_buffer.data(), static_cast<int>(qMin(static_cast<quint64>(DECODE_BLOCK_FRAMES), m_firstFrame - skipped)));
+		if(frames < 1)
+		{
+			qWarning("DecoderSource: Failed to skip to the start of the range!");
+			return false;
+		}
+		skipped += frames;
+	}
+
+	return true;
+}
+
+bool DecoderSource::read(QByteArray &data, const qint64 maxSize, bool &eof)
+{
+	const int blockAlign = m_info.channels * SampleFormat::bytesPerSample(m_format);
+	eof = false;
+
+	if(!m_headerDone)
+	{
+		data = outputHeader(m_info, m_format);
+		m_headerDone = true;
+		return true;
+	}
+
+	//The range has been read completely, the decoder may still have more frames
+	if((m_frameCount > 0U) && (m_framesRead >= m_frameCount))
+	{
+		data.clear();
+		eof = true;
+		return true;
+	}
+
+	int maxFrames = qMax(1, static_cast<int>(maxSize / blockAlign));
+	if(m_frameCount > 0U)
+	{
+		maxFrames = static_cast<int>(qMin(static_cast<quint64>(maxFrames), m_frameCount - m_framesRead));
+	}
+	m_buffer.resize(maxFrames * m_info.channels);
+
+	const int frames = m_decoder->readFrames(m_buffer.data(), maxFrames);
+	if(frames < 0)
+	{
+		qWarning("DecoderSource: Failed to decode the input stream!");
+		return false;
+	}
+
+	data.resize(frames * blockAlign);
+	SampleFormat::fromFloat(m_format, m_buffer.constData(), data.data(), frames * m_info.channels);
+
+	m_framesRead += frames;
+	eof = (frames < 1);
+	return true;
+}
+
+int DecoderSource::progress(void) const
+{
+	return (m_info.frames > 0U) ? static_cast<int>(qMin(100ui64, (100ui64 * m_framesRead) / m_info.frames)) : 0;
+}
@@ -23,6 +23,10 @@
 #pragma once
 
 #include "Tool_Abstract.h"
+#include "Tool_StreamPipeline.h"
+#include "Tool_SampleFormat.h"
+
+#include <QVector>
 
 class AbstractDecoder : public AbstractTool
 {
@@ -40,5 +44,61 @@ public:
 	static bool isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion);
 	static bool isDecoderAvailable(void);
 	static const supportedType_t *supportedTypes(void);
+
+	//Streaming API
+	virtual bool createPipelineStage(const QString &sourceFile, QString &program, QStringList &args);
+
+	//Same as above, but only decodes the given range of frames, e.g. a single track of an image; a count of zero means "until the end"
+	virtual bool createTrackStage(const QString &sourceFile, const quint64 firstFrame, const quint64 frameCount, QString &program, QStringList &args);
+
+	//Can the source be read in place, instead of being decoded to a temporary file?
+	virtual bool isReadableInPlace(void);
+
+	//Does the decoder write Wave64, if the output file name ends with ".w64"?
+	virtual bool supportsWave64(void);
+
+	//Pull API, decodes in-process and yields blocks of interleaved float samples on demand
+	typedef struct
+	{
+		quint16 channels;
+		quint32 samplerate;
+		quint16 bitsPerSample;
+		quint64 frames;		//Zero if unknown
+	}
+	streamInfo_t;
+
+	virtual bool openStream(const QString &sourceFile, streamInfo_t &info);
+	virtual int readFrames(float *const buffer, const int frames);
+	virtual bool seekStream(const quint64 frame);
+	virtual void closeStream(void);
+
+protected:
+	//Implements decode() on top of the pull API, for decoders that only run in-process
+	bool decodeStream(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag);
+};
+
+/*
+ * Feeds the frames of a decoder's pull API into a pipeline as a WAV stream, takes ownership of the decoder.
+ * Optionally, only the given range of frames is fed, e.g. a single track of an image; a count of zero means "until the end".
+ */
+class DecoderSource : public StreamSource
+{
+public:
+	DecoderSource(AbstractDecoder *const decoder, const AbstractDecoder::streamInfo_t &info, const quint64 firstFrame = 0, const quint64 frameCount = 0);
+	virtual ~DecoderSource(void);
+
+	virtual bool open(void);
+	virtual bool read(QByteArray &data, const qint64 maxSize, bool &eof);
+	virtual int progress(void) const;
+
+private:
+	AbstractDecoder *const m_decoder;
+	const AbstractDecoder::streamInfo_t m_info;
+	const quint64 m_firstFrame;
+	const quint64 m_frameCount;
+	const SampleFormat::format_t m_format;
+	bool m_headerDone;
+	quint64 m_framesRead;
+	QVector<float> m_buffer;
 };
 
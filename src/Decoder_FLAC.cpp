@@ -85,6 +85,39 @@ bool FLACDecoder::decode(const QString &sourceFile, const QString &outputFile, Q
 	return (result == RESULT_SUCCESS);
 }
 
+bool FLACDecoder::createPipelineStage(const QString &sourceFile, QString &program, QStringList &args)
+{
+	program = m_binary;
+	args.clear();
+
+	args << "-d" << "-F" << "-c";
+	args << QDir::toNativeSeparators(sourceFile);
+
+	return true;
+}
+
+bool FLACDecoder::createTrackStage(const QString &sourceFile, const quint64 firstFrame, const quint64 frameCount, QString &program, QStringList &args)
+{
+	program = m_binary;
+	args.clear();
+
+	//The decoder seeks to the start of the track, so the image is not decoded from the beginning for every track
+	args << "-d" << "-F" << "-c";
+	args << QString("--skip=%1").arg(QString::number(firstFrame));
+	if(frameCount > 0U)
+	{
+		args << QString("--until=%1").arg(QString::number(firstFrame + frameCount));
+	}
+	args << QDir::toNativeSeparators(sourceFile);
+
+	return true;
+}
+
+bool FLACDecoder::supportsWave64(void)
+{
+	return true; /*output format is selected by the file extension*/
+}
+
 bool FLACDecoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	static const QLatin1String flac("FLAC");
@@ -33,6 +33,9 @@ public:
 	virtual bool decode(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag);
 	static bool isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion);
 	static const supportedType_t *supportedTypes(void);
+	virtual bool createPipelineStage(const QString &sourceFile, QString &program, QStringList &args);
+	virtual bool createTrackStage(const QString &sourceFile, const quint64 firstFrame, const quint64 frameCount, QString &program, QStringList &args);
+	virtual bool supportsWave64(void);
 
 private:
 	const QString m_binary;
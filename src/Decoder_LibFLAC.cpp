@@ -0,0 +1,322 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Decoder_LibFLAC.h"
+
+//Internal
+#include "Global.h"
+#include "Decoder_FLAC.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QDir>
+#include <QVector>
+
+//libFLAC
+#include <FLAC/stream_decoder.h>
+
+//CRT
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+//Static
+bool LibFLACDecoder::m_enabled = true;
+
+////////////////////////////////////////////////////////////
+// Stream
+////////////////////////////////////////////////////////////
+
+/*
+ * Wraps a libFLAC stream decoder, the samples of the most recent frame are buffered until they have been read
+ */
+class LibFLACStream
+{
+public:
+	LibFLACStream(void)
+	:
+		m_decoder(NULL),
+		m_channels(0),
+		m_scale(1.0f),
+		m_bufferFrames(0),
+		m_bufferPos(0),
+		m_errors(0),
+		m_failed(false)
+	{
+		memset(&m_info, 0, sizeof(m_info));
+	}
+
+	~LibFLACStream(void)
+	{
+		close();
+	}
+
+	bool open(const QString &sourceFile, AbstractDecoder::streamInfo_t &info)
+	{
+		close();
+
+		if(!(m_decoder = FLAC__stream_decoder_new()))
+		{
+			return false;
+		}
+
+		//The file is opened here, so that Unicode file names work with every version of libFLAC
+		FILE *const file = _wfopen(MUTILS_WCHR(QDir::toNativeSeparators(sourceFile)), L"rb");
+		if(!file)
+		{
+			close();
+			return false;
+		}
+
+		//Once initialized, the decoder owns the file and closes it when it is finished
+		if(FLAC__stream_decoder_init_FILE(m_decoder, file, writeCallback, metadataCallback, errorCallback, this) != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+		{
+			fclose(file);
+			close();
+			return false;
+		}
+
+		if((!FLAC__stream_decoder_process_until_end_of_metadata(m_decoder)) || m_failed || (m_channels < 1))
+		{
+			close();
+			return false;
+		}
+
+		info = m_info;
+		return true;
+	}
+
+	int read(float *const buffer, const int frames)
+	{
+		int done = 0;
+		while(done < frames)
+		{
+			if(m_bufferPos >= m_bufferFrames)
+			{
+				if(FLAC__stream_decoder_get_state(m_decoder) == FLAC__STREAM_DECODER_END_OF_STREAM)
+				{
+					break;
+				}
+				m_bufferFrames = m_bufferPos = 0;
+				if((!FLAC__stream_decoder_process_single(m_decoder)) || m_failed)
+				{
+					return -1;
+				}
+				continue;
+			}
+
+			const int count = qMin(frames - done, m_bufferFrames - m_bufferPos);
+			memcpy(buffer + (done * m_channels), m_buffer.constData() + (m_bufferPos * m_channels), count * m_channels * sizeof(float));
+			m_bufferPos += count;
+			done += count;
+		}
+		return done;
+	}
+
+	//The decoder passes the frame that contains the target to the write callback, starting exactly at the target
+	bool seek(const quint64 frame)
+	{
+		m_bufferFrames = m_bufferPos = 0;
+		if(FLAC__stream_decoder_seek_absolute(m_decoder, frame) && (!m_failed))
+		{
+			return true;
+		}
+
+		//Start over from the beginning, so that the caller can still skip to the target
+		m_bufferFrames = m_bufferPos = 0;
+		m_failed = false;
+		if(!(FLAC__stream_decoder_reset(m_decoder) && FLAC__stream_decoder_process_until_end_of_metadata(m_decoder)))
+		{
+			m_failed = true;
+		}
+		return false;
+	}
+
+	void close(void)
+	{
+		if(m_decoder)
+		{
+			FLAC__stream_decoder_finish(m_decoder);
+			FLAC__stream_decoder_delete(m_decoder);
+			m_decoder = NULL;
+		}
+		m_channels = 0;
+		m_bufferFrames = m_bufferPos = 0;
+		m_failed = false;
+	}
+
+	//Damaged frames are replaced by silence, like "flac -F" does, the caller is told how many there were
+	quint32 takeErrors(void)
+	{
+		const quint32 errors = m_errors;
+		m_errors = 0;
+		return errors;
+	}
+
+private:
+	static FLAC__StreamDecoderWriteStatus writeCallback(const FLAC__StreamDecoder* /*decoder*/, const FLAC__Frame *frame, const FLAC__int32 *const buffer[], void *clientData)
+	{
+		LibFLACStream *const self = static_cast<LibFLACStream*>(clientData);
+		const int channels = self->m_channels, frames = static_cast<int>(frame->header.blocksize);
+
+		if(static_cast<int>(frame->header.channels) != channels)
+		{
+			self->m_failed = true;
+			return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+		}
+
+		self->m_buffer.resize(frames * channels);
+		float *output = self->m_buffer.data();
+		for(int i = 0; i < frames; i++)
+		{
+			for(int c = 0; c < channels; c++)
+			{
+				*(output++) = static_cast<float>(buffer[c][i]) * self->m_scale;
+			}
+		}
+
+		self->m_bufferFrames = frames;
+		self->m_bufferPos = 0;
+		return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+	}
+
+	static void metadataCallback(const FLAC__StreamDecoder* /*decoder*/, const FLAC__StreamMetadata *metadata, void *clientData)
+	{
+		LibFLACStream *const self = static_cast<LibFLACStream*>(clientData);
+		if(metadata->type == FLAC__METADATA_TYPE_STREAMINFO)
+		{
+			const FLAC__StreamMetadata_StreamInfo &streamInfo = metadata->data.stream_info;
+			self->m_info.channels = static_cast<quint16>(streamInfo.channels);
+			self->m_info.samplerate = streamInfo.sample_rate;
+			self->m_info.bitsPerSample = static_cast<quint16>(streamInfo.bits_per_sample);
+			self->m_info.frames = streamInfo.total_samples;
+			self->m_channels = streamInfo.channels;
+			self->m_scale = static_cast<float>(ldexp(1.0, 1 - static_cast<int>(streamInfo.bits_per_sample)));
+		}
+	}
+
+	static void errorCallback(const FLAC__StreamDecoder* /*decoder*/, FLAC__StreamDecoderErrorStatus /*status*/, void *clientData)
+	{
+		static_cast<LibFLACStream*>(clientData)->m_errors++;
+	}
+
+	FLAC__StreamDecoder *m_decoder;
+	AbstractDecoder::streamInfo_t m_info;
+	int m_channels;
+	float m_scale;
+	QVector<float> m_buffer;
+	int m_bufferFrames;
+	int m_bufferPos;
+	quint32 m_errors;
+	bool m_failed;
+};
+
+////////////////////////////////////////////////////////////
+// Constructor & Destructor
+////////////////////////////////////////////////////////////
+
+LibFLACDecoder::LibFLACDecoder(void)
+:
+	m_stream(NULL)
+{
+}
+
+LibFLACDecoder::~LibFLACDecoder(void)
+{
+	closeStream();
+}
+
+////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////
+
+bool LibFLACDecoder::decode(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag)
+{
+	return decodeStream(sourceFile, outputFile, abortFlag);
+}
+
+bool LibFLACDecoder::openStream(const QString &sourceFile, streamInfo_t &info)
+{
+	closeStream();
+
+	m_stream = new LibFLACStream();
+	if(!m_stream->open(sourceFile, info))
+	{
+		closeStream();
+		return false;
+	}
+
+	emit messageLogged(QString("Decoding FLAC stream with libFLAC %1: %2 Hz, %3 channel(s), %4-Bit").arg(QString::fromLatin1(FLAC__VERSION_STRING), QString::number(info.samplerate), QString::number(info.channels), QString::number(info.bitsPerSample)));
+	return true;
+}
+
+int LibFLACDecoder::readFrames(float *const buffer, const int frames)
+{
+	if(!m_stream)
+	{
+		return -1;
+	}
+
+	const int result = m_stream->read(buffer, frames);
+	if(const quint32 errors = m_stream->takeErrors())
+	{
+		emit messageLogged(QString("WARNING: The stream is damaged, %1 error(s) have been concealed!").arg(QString::number(errors)));
+	}
+	return result;
+}
+
+bool LibFLACDecoder::seekStream(const quint64 frame)
+{
+	if(!(m_stream && m_stream->seek(frame)))
+	{
+		emit messageLogged(QString("Failed to seek to sample %1, going to decode from the start.").arg(QString::number(frame)));
+		return false;
+	}
+	return true;
+}
+
+void LibFLACDecoder::closeStream(void)
+{
+	MUTILS_DELETE(m_stream);
+}
+
+////////////////////////////////////////////////////////////
+// Static Functions
+////////////////////////////////////////////////////////////
+
+bool LibFLACDecoder::isDecoderAvailable(void)
+{
+	return m_enabled;
+}
+
+bool LibFLACDecoder::isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion)
+{
+	//Native FLAC streams only, the stream decoder is not initialized for Ogg
+	if(containerType.compare(QLatin1String("FLAC"), Qt::CaseInsensitive) == 0)
+	{
+		return FLACDecoder::isFormatSupported(containerType, containerProfile, formatType, formatProfile, formatVersion);
+	}
+
+	return false;
+}
@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Decoder_LibMPG123.h"
+
+//Internal
+#include "Global.h"
+#include "Decoder_MP3.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QDir>
+
+//CRT
+#include <stdio.h>
+#include <io.h>
+#include <fcntl.h>
+
+//libmpg123
+#include <mpg123.h>
+
+//Static
+bool LibMPG123Decoder::m_enabled = true;
+
+////////////////////////////////////////////////////////////
+// Stream
+////////////////////////////////////////////////////////////
+
+/*
+ * Wraps a libmpg123 handle, which is set up to always decode to 32-Bit float
+ */
+class LibMPG123Stream
+{
+public:
+	LibMPG123Stream(void)
+	:
+		m_handle(NULL),
+		m_file(-1),
+		m_channels(0)
+	{
+	}
+
+	~LibMPG123Stream(void)
+	{
+		close();
+	}
+
+	bool open(const QString &sourceFile, AbstractDecoder::streamInfo_t &info)
+	{
+		close();
+
+		//Required once per process by older versions of the library, does nothing in newer ones
+		static const int initResult = mpg123_init();
+		if(initResult != MPG123_OK)
+		{
+			return false;
+		}
+
+		int error = MPG123_OK;
+		if(!(m_handle = mpg123_new(NULL, &error)))
+		{
+			return false;
+		}
+
+		mpg123_param(m_handle, MPG123_ADD_FLAGS, MPG123_QUIET, 0.0);
+		mpg123_format_none(m_handle);
+
+		const long *rates = NULL;
+		size_t rateCount = 0;
+		mpg123_rates(&rates, &rateCount);
+		for(size_t i = 0; i < rateCount; i++)
+		{
+			mpg123_format(m_handle, rates[i], MPG123_MONO | MPG123_STEREO, MPG123_ENC_FLOAT_32);
+		}
+
+		//The file is opened here, so that Unicode file names work with every version of libmpg123
+		m_file = _wopen(MUTILS_WCHR(QDir::toNativeSeparators(sourceFile)), _O_RDONLY | _O_BINARY);
+		if((m_file < 0) || (mpg123_open_fd(m_handle, m_file) != MPG123_OK))
+		{
+			close();
+			return false;
+		}
+
+		long samplerate = 0;
+		int channels = 0, encoding = 0;
+		if((mpg123_getformat(m_handle, &samplerate, &channels, &encoding) != MPG123_OK) || (encoding != MPG123_ENC_FLOAT_32) || (channels < 1))
+		{
+			close();
+			return false;
+		}
+
+		//The output format must not change in the middle of the stream
+		mpg123_format_none(m_handle);
+		mpg123_format(m_handle, samplerate, channels, encoding);
+		m_channels = channels;
+
+		//Scanning the whole stream gives the exact length, even without a Xing/Info header
+		const off_t length = (mpg123_scan(m_handle) == MPG123_OK) ? mpg123_length(m_handle) : MPG123_ERR;
+
+		info.channels = static_cast<quint16>(channels);
+		info.samplerate = static_cast<quint32>(samplerate);
+		info.bitsPerSample = 16;
+		info.frames = (length > 0) ? static_cast<quint64>(length) : 0U;
+
+		return true;
+	}
+
+	int read(float *const buffer, const int frames)
+	{
+		const size_t frameSize = m_channels * sizeof(float), total = static_cast<size_t>(qMax(0, frames)) * frameSize;
+		size_t done = 0;
+
+		while(done < total)
+		{
+			size_t count = 0;
+			const int result = mpg123_read(m_handle, reinterpret_cast<unsigned char*>(buffer) + done, total - done, &count);
+			done += count;
+			if(result == MPG123_DONE)
+			{
+				break;
+			}
+			if((result != MPG123_OK) && (result != MPG123_NEW_FORMAT))
+			{
+				qWarning("libmpg123 error: %s", mpg123_strerror(m_handle));
+				return -1;
+			}
+		}
+
+		return static_cast<int>(done / frameSize);
+	}
+
+	//The stream has been scanned when it was opened, so seeking is sample-accurate
+	bool seek(const quint64 frame)
+	{
+		return mpg123_seek(m_handle, static_cast<off_t>(frame), SEEK_SET) == static_cast<off_t>(frame);
+	}
+
+	void close(void)
+	{
+		if(m_handle)
+		{
+			mpg123_close(m_handle);
+			mpg123_delete(m_handle);
+			m_handle = NULL;
+		}
+		//The library never closes a file descriptor that it did not open itself
+		if(m_file >= 0)
+		{
+			_close(m_file);
+			m_file = -1;
+		}
+		m_channels = 0;
+	}
+
+private:
+	mpg123_handle *m_handle;
+	int m_file;
+	int m_channels;
+};
+
+////////////////////////////////////////////////////////////
+// Constructor & Destructor
+////////////////////////////////////////////////////////////
+
+LibMPG123Decoder::LibMPG123Decoder(void)
+:
+	m_stream(NULL)
+{
+}
+
+LibMPG123Decoder::~LibMPG123Decoder(void)
+{
+	closeStream();
+}
+
+////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////
+
+bool LibMPG123Decoder::decode(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag)
+{
+	return decodeStream(sourceFile, outputFile, abortFlag);
+}
+
+bool LibMPG123Decoder::openStream(const QString &sourceFile, streamInfo_t &info)
+{
+	closeStream();
+
+	m_stream = new LibMPG123Stream();
+	if(!m_stream->open(sourceFile, info))
+	{
+		closeStream();
+		return false;
+	}
+
+	emit messageLogged(QString("Decoding MPEG Audio stream with libmpg123: %1 Hz, %2 channel(s)").arg(QString::number(info.samplerate), QString::number(info.channels)));
+	return true;
+}
+
+int LibMPG123Decoder::readFrames(float *const buffer, const int frames)
+{
+	return m_stream ? m_stream->read(buffer, frames) : -1;
+}
+
+bool LibMPG123Decoder::seekStream(const quint64 frame)
+{
+	if(!(m_stream && m_stream->seek(frame)))
+	{
+		emit messageLogged(QString("Failed to seek to sample %1, going to decode from the start.").arg(QString::number(frame)));
+		return false;
+	}
+	return true;
+}
+
+void LibMPG123Decoder::closeStream(void)
+{
+	MUTILS_DELETE(m_stream);
+}
+
+////////////////////////////////////////////////////////////
+// Static Functions
+////////////////////////////////////////////////////////////
+
+bool LibMPG123Decoder::isDecoderAvailable(void)
+{
+	return m_enabled;
+}
+
+bool LibMPG123Decoder::isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion)
+{
+	//Plain MPEG Audio files only, the library does not parse a Wave container
+	if(containerType.compare(QLatin1String("MPEG Audio"), Qt::CaseInsensitive) == 0)
+	{
+		return MP3Decoder::isFormatSupported(containerType, containerProfile, formatType, formatProfile, formatVersion);
+	}
+
+	return false;
+}
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Decoder_Abstract.h"
+
+class LibMPG123Stream;
+
+/*
+ * In-process MPEG Audio decoder, backed by libmpg123. Only provides the pull API, MPEG Audio inside a Wave
+ * container is left to the MP3Decoder.
+ */
+class LibMPG123Decoder : public AbstractDecoder
+{
+public:
+	LibMPG123Decoder(void);
+	~LibMPG123Decoder(void);
+
+	virtual bool decode(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag);
+	static bool isDecoderAvailable(void);
+	static bool isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion);
+
+	virtual bool openStream(const QString &sourceFile, streamInfo_t &info);
+	virtual int readFrames(float *const buffer, const int frames);
+	virtual bool seekStream(const quint64 frame);
+	virtual void closeStream(void);
+
+	static void setEnabled(bool enabled) { m_enabled = enabled; }
+
+private:
+	LibMPG123Stream *m_stream;
+
+	//Options
+	static bool m_enabled;
+};
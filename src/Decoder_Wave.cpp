@@ -23,6 +23,7 @@
 //Internal
 #include "Decoder_Wave.h"
 #include "Global.h"
+#include "Tool_WaveProperties.h"
 
 //MUtils
 #include <MUtils/OSSupport.h>
@@ -39,11 +40,16 @@ typedef struct _callback_t
 callback_t;
 
 WaveDecoder::WaveDecoder(void)
+:
+	m_streamFormat(SampleFormat::FORMAT_UNKNOWN),
+	m_streamChannels(0),
+	m_streamRemaining(0)
 {
 }
 
 WaveDecoder::~WaveDecoder(void)
 {
+	closeStream();
 }
 
 bool WaveDecoder::decode(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag)
@@ -68,6 +74,75 @@ bool WaveDecoder::decode(const QString &sourceFile, const QString &outputFile, Q
 	return okay;
 }
 
+bool WaveDecoder::isReadableInPlace(void)
+{
+	return true; /*source already is PCM Wave, no need to copy it*/
+}
+
+bool WaveDecoder::openStream(const QString &sourceFile, streamInfo_t &info)
+{
+	closeStream();
+
+	m_stream.setFileName(sourceFile);
+	if(!m_stream.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	WaveProperties::header_t header;
+	if(!(WaveProperties::parseHeader(m_stream, header) && (header.channels > 0) && ((header.blockAlign % header.channels) == 0)))
+	{
+		closeStream();
+		return false;
+	}
+
+	m_streamFormat = SampleFormat::fromWaveFormat(header.formatTag, (header.blockAlign / header.channels) * 8);
+	if((m_streamFormat == SampleFormat::FORMAT_UNKNOWN) || (!m_stream.seek(header.dataOffset)))
+	{
+		closeStream();
+		return false;
+	}
+
+	m_streamChannels = header.channels;
+	m_streamRemaining = header.frameCount;
+
+	info.channels = header.channels;
+	info.samplerate = header.samplerate;
+	info.bitsPerSample = header.bitsPerSample;
+	info.frames = header.frameCount;
+
+	return true;
+}
+
+int WaveDecoder::readFrames(float *const buffer, const int frames)
+{
+	const int blockAlign = m_streamChannels * SampleFormat::bytesPerSample(m_streamFormat);
+	const qint64 maxFrames = static_cast<qint64>(qMin(m_streamRemaining, static_cast<quint64>(qMax(0, frames))));
+
+	if((!m_stream.isOpen()) || (blockAlign < 1))
+	{
+		return -1;
+	}
+
+	m_streamBuffer = m_stream.read(maxFrames * blockAlign);
+	const int count = m_streamBuffer.size() / blockAlign;
+
+	SampleFormat::toFloat(m_streamFormat, m_streamBuffer.constData(), buffer, count * m_streamChannels);
+	m_streamRemaining = (count < maxFrames) ? 0U : (m_streamRemaining - count);
+
+	return count;
+}
+
+void WaveDecoder::closeStream(void)
+{
+	if(m_stream.isOpen())
+	{
+		m_stream.close();
+	}
+	m_streamBuffer.clear();
+	m_streamRemaining = 0;
+}
+
 bool WaveDecoder::progressHandler(const double &progress, void *const userData)
 {
 	if(const callback_t *const ptr = reinterpret_cast<callback_t*>(userData))
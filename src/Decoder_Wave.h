@@ -24,6 +24,8 @@
 
 #include "Decoder_Abstract.h"
 
+#include <QFile>
+
 class WaveDecoder : public AbstractDecoder
 {
 public:
@@ -31,10 +33,22 @@ public:
 	~WaveDecoder(void);
 
 	virtual bool decode(const QString &sourceFile, const QString &outputFile, QAtomicInt &abortFlag);
+	virtual bool isReadableInPlace(void);
+
+	virtual bool openStream(const QString &sourceFile, streamInfo_t &info);
+	virtual int readFrames(float *const buffer, const int frames);
+	virtual void closeStream(void);
 	
 	static bool isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion);
 	static const supportedType_t *supportedTypes(void);
 
 	static bool progressHandler(const double &progress, void *const data);
 	void updateProgress(const double &progress);
+
+private:
+	QFile m_stream;
+	SampleFormat::format_t m_streamFormat;
+	int m_streamChannels;
+	quint64 m_streamRemaining;
+	QByteArray m_streamBuffer;
 };
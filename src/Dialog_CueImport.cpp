@@ -54,6 +54,9 @@
 #define SET_FONT_BOLD(WIDGET,BOLD) { QFont _font = WIDGET->font(); _font.setBold(BOLD); WIDGET->setFont(_font); }
 #define EXPAND(STR) QString(STR).leftJustified(96, ' ')
 
+//Tracks are only encoded directly from the image, if they can be cut in a single pipelined pass
+#define DIRECT_MODE(SETTINGS) ((SETTINGS)->cueSheetDirectEncode() && (SETTINGS)->streamingPipelineEnabled())
+
 ////////////////////////////////////////////////////////////
 // Constructor & Destructor
 ////////////////////////////////////////////////////////////
@@ -289,6 +292,14 @@ void CueImportDialog::importButtonClicked(void)
 	static const unsigned __int64 minimumFreeDiskspaceMultiplier = 2ui64;
 	static const char *writeTestBuffer = "LAMEXP_WRITE_TEST";
 	
+	//No intermediate files are written in direct mode, tracks are cut from the source at encode time
+	if(DIRECT_MODE(m_settings))
+	{
+		importCueSheet();
+		accept();
+		return;
+	}
+
 	QDir outputDir(m_outputDir);
 	outputDir.mkpath(".");
 	if(!(outputDir.exists() && outputDir.isReadable()))
@@ -433,6 +444,7 @@ void CueImportDialog::splitFiles(void)
 	connect(progress.data(), SIGNAL(userAbort()), splitter.data(), SLOT(abortProcess()), Qt::DirectConnection);
 
 	DecoderRegistry::configureDecoders(m_settings);
+	splitter->setDirectMode(DIRECT_MODE(m_settings));
 
 	progress->show(tr("Splitting file(s), please wait..."), splitter.data());
 	progress->close();
@@ -31,14 +31,19 @@
 #include "Model_Progress.h"
 #include "Model_Settings.h"
 #include "Model_FileExts.h"
+#include "Model_Artwork.h"
 #include "Thread_Process.h"
+#include "Tool_Abstract.h"
 #include "Thread_CPUObserver.h"
 #include "Thread_RAMObserver.h"
 #include "Thread_DiskObserver.h"
+#include "Thread_AlbumGain.h"
+#include "Tool_LoudnessMeter.h"
 #include "Dialog_LogView.h"
 #include "Registry_Decoder.h"
 #include "Registry_Encoder.h"
 #include "Filter_Downmix.h"
+#include "Filter_Gain.h"
 #include "Filter_Normalize.h"
 #include "Filter_Resample.h"
 #include "Filter_ToneAdjust.h"
@@ -70,6 +75,7 @@
 #include <QProgressDialog>
 #include <QResizeEvent>
 #include <QTime>
+#include <QDateTime>
 #include <QElapsedTimer>
 #include <QThreadPool>
 
@@ -80,6 +86,15 @@
 //Maximum number of parallel instances
 #define MAX_INSTANCES 64U
 
+//Thresholds for adaptive job admission
+#define ADAPTIVE_CPU_IDLE 0.80
+#define ADAPTIVE_DISK_BUSY 0.85
+#define ADAPTIVE_RAM_BUSY 0.90
+#define ADAPTIVE_INTERVAL 3000
+
+//Reference loudness of ReplayGain 2.0, in LUFS
+#define ALBUM_GAIN_REFERENCE -18.0
+
 ////////////////////////////////////////////////////////////
 
 #define CHANGE_BACKGROUND_COLOR(WIDGET, COLOR) do \
@@ -154,6 +169,34 @@ private:
 	int m_value;
 };
 
+//Quoting of strings in the metrics report
+static inline QString JSON_STRING(const QString &text)
+{
+	QString result(QLatin1String("\""));
+	for(QString::ConstIterator iter = text.constBegin(); iter != text.constEnd(); iter++)
+	{
+		switch(iter->unicode())
+		{
+		case '"':  result.append(QLatin1String("\\\"")); break;
+		case '\\': result.append(QLatin1String("\\\\")); break;
+		case '\n': result.append(QLatin1String("\\n"));  break;
+		case '\r': result.append(QLatin1String("\\r"));  break;
+		case '\t': result.append(QLatin1String("\\t"));  break;
+		default:
+			if(iter->unicode() < 0x20) result.append(QString().sprintf("\\u%04x", iter->unicode()));
+			else result.append(*iter);
+			break;
+		}
+	}
+	return result.append(QLatin1Char('"'));
+}
+
+static inline QString CSV_STRING(const QString &text)
+{
+	QString result(text);
+	return result.replace(QLatin1String("\""), QLatin1String("\"\"")).prepend(QLatin1Char('"')).append(QLatin1Char('"'));
+}
+
 ////////////////////////////////////////////////////////////
 // Constructor
 ////////////////////////////////////////////////////////////
@@ -169,6 +212,14 @@ ProcessingDialog::ProcessingDialog(FileListModel *const fileListModel, const Aud
 	m_shutdownFlag(SHUTDOWN_FLAG_NONE),
 	m_progressViewFilter(-1),
 	m_initThreads(0),
+	m_runningThreads(0),
+	m_targetThreads(1),
+	m_minimumThreads(1),
+	m_adaptiveThreads(false),
+	m_diskLoad(0.0),
+	m_ramUsage(0.0),
+	m_albumGainDone(0),
+	m_albumGainInline(false),
 	m_defaultColor(new QColor()),
 	m_tempFolder(settings->customTempPathEnabled() ? settings->customTempPath() : MUtils::temp_folder()),
 	m_firstShow(true)
@@ -190,6 +241,8 @@ ProcessingDialog::ProcessingDialog(FileListModel *const fileListModel, const Aud
 
 	//Register meta type
 	qRegisterMetaType<QUuid>("QUuid");
+	qRegisterMetaType<ProcessThread::jobStats_t>("ProcessThread::jobStats_t");
+	qRegisterMetaType<ProcessThread::loudness_t>("ProcessThread::loudness_t");
 
 	//Adjust size to DPI settings and re-center
 	MUtils::GUI::scale_widget(this);
@@ -290,7 +343,7 @@ ProcessingDialog::ProcessingDialog(FileListModel *const fileListModel, const Aud
 	{
 		for(int i = 0; i < fileListModel->rowCount(); i++)
 		{
-			m_pendingJobs.append(fileListModel->getFile(fileListModel->index(i,0)));
+			m_pendingJobs.append(pending_job_t(static_cast<quint32>(i), fileListModel->getFile(fileListModel->index(i,0))));
 		}
 	}
 
@@ -362,10 +415,15 @@ ProcessingDialog::~ProcessingDialog(void)
 		if(!m_threadPool->waitForDone(100))
 		{
 			emit abortRunningTasks();
+			m_albumGainAbort.ref();
 			m_threadPool->waitForDone();
 		}
 	}
 
+	qDeleteAll(m_albumGainTasks);
+	m_albumGainTasks.clear();
+	m_albumGain.clear();
+
 	m_taskbar->setOverlayIcon(NULL);
 	m_taskbar->setTaskbarState(MUtils::Taskbar7::TASKBAR_STATE_NONE);
 	
@@ -504,10 +562,31 @@ void ProcessingDialog::initEncoding(void)
 	m_skippedJobs.clear();
 	m_userAborted = m_forcedAbort = false;
 	m_playList.clear();
+	m_jobStats.clear();
+	memset(&m_batchMetrics, 0, sizeof(batch_metrics_t));
 	m_progressIndicator->start();
 
 	MUtils::OS::change_process_priority(1);
 	DecoderRegistry::configureDecoders(m_settings);
+	AbstractTool::resetStartProcessStats();
+
+	//Start the most expensive jobs first, so the last running job doesn't leave the other cores idle
+	if(m_settings->longestJobFirst())
+	{
+		//Estimate the cost of each job only once, as the estimate may have to look at the file
+		QList<job_cost_t> jobCosts;
+		for(QList<pending_job_t>::ConstIterator iter = m_pendingJobs.constBegin(); iter != m_pendingJobs.constEnd(); iter++)
+		{
+			jobCosts << job_cost_t(estimateJobCost(iter->second), *iter);
+		}
+		qStableSort(jobCosts.begin(), jobCosts.end(), compareJobCost);
+		m_pendingJobs.clear();
+		for(QList<job_cost_t>::ConstIterator iter = jobCosts.constBegin(); iter != jobCosts.constEnd(); iter++)
+		{
+			m_pendingJobs << iter->second;
+		}
+	}
+	ArtworkModel::setMaximumSize(qMax(0, m_settings->artworkMaximumSize()));
 
 	CHANGE_BACKGROUND_COLOR(ui->frame_header, QColor(Qt::white));
 
@@ -526,6 +605,7 @@ void ProcessingDialog::initEncoding(void)
 		m_diskObserver.reset(new DiskObserverThread(m_tempFolder));
 		connect(m_diskObserver.data(), SIGNAL(messageLogged(QString,int)), m_progressModel.data(), SLOT(addSystemMessage(QString,int)), Qt::QueuedConnection);
 		connect(m_diskObserver.data(), SIGNAL(freeSpaceChanged(quint64)), this, SLOT(diskUsageHasChanged(quint64)), Qt::QueuedConnection);
+		connect(m_diskObserver.data(), SIGNAL(diskLoadChanged(double)), this, SLOT(diskLoadHasChanged(double)), Qt::QueuedConnection);
 		m_diskObserver->start();
 	}
 	if(!m_cpuObserver)
@@ -544,17 +624,42 @@ void ProcessingDialog::initEncoding(void)
 	if(m_threadPool.isNull())
 	{
 		m_threadPool.reset(createThreadPool());
-		if (m_threadPool->maxThreadCount() > 1)
+		if (m_targetThreads > 1)
 		{
-			m_progressModel->addSystemMessage(tr("Multi-threading enabled: Running %1 instances in parallel!").arg(QString::number(m_threadPool->maxThreadCount())));
+			m_progressModel->addSystemMessage(tr("Multi-threading enabled: Running %1 instances in parallel!").arg(QString::number(m_targetThreads)));
 		}
 	}
 
-	m_initThreads = m_threadPool->maxThreadCount();
-	QTimer::singleShot(100, this, SLOT(initNextJob()));
+	m_diskLoad = 0.0;
+	m_ramUsage = 0.0;
+	m_initThreads = 0;
+	m_lastAdjustment.reset(new QElapsedTimer());
+	m_lastAdjustment->start();
 
 	m_totalTime.reset(new QElapsedTimer());
 	m_totalTime->start();
+
+	//The loudness is measured while encoding, if the ReplayGain tags can be written to the encoded files afterwards
+	m_albumGainInline = false;
+	m_albumKeys.clear();
+	m_measuredLoudness.clear();
+	if(m_settings->albumGainMode() == SettingsModel::AlbumGain_WriteTags)
+	{
+		QScopedPointer<AbstractEncoder> encoder(EncoderRegistry::createInstance(m_settings->compressionEncoder(), m_settings));
+		m_albumGainInline = encoder->supportsReplayGainUpdate();
+		if(m_albumGainInline)
+		{
+			m_progressModel->addSystemMessage(tr("Album gain: The loudness is measured while encoding, the tags are written once all files are done."));
+		}
+	}
+
+	//Otherwise analyze the batch first, the jobs are admitted once the gain of every album is known
+	if((m_settings->albumGainMode() != SettingsModel::AlbumGain_Disabled) && (!m_albumGainInline) && startAlbumGain())
+	{
+		return;
+	}
+
+	admitPendingJobs();
 }
 
 void ProcessingDialog::initNextJob(void)
@@ -581,7 +686,8 @@ void ProcessingDialog::startNextJob(void)
 	m_runningThreads++;
 
 	//Fetch next file
-	AudioFileModel currentFile = m_pendingJobs.takeFirst();
+	const pending_job_t nextJob = m_pendingJobs.takeFirst();
+	AudioFileModel currentFile = nextJob.second;
 	updateMetaInfo(currentFile);
 
 	//Create encoder instance
@@ -597,6 +703,33 @@ void ProcessingDialog::startNextJob(void)
 		m_settings->prependRelativeSourcePath() && (!m_settings->outputToSourceDir())
 	));
 
+	//Measure the loudness on the way to the encoder, the tags are written once the whole batch is done
+	if(m_albumGainInline)
+	{
+		thread->setMeasureLoudness(true);
+		m_albumKeys.insert(thread->getId(), albumKey(nextJob.first, currentFile.metaInfo()));
+	}
+
+	//Use the results of the album gain pre-pass
+	bool applyAlbumGain = false;
+	if(m_albumGain.contains(nextJob.first))
+	{
+		const album_gain_t albumGain = m_albumGain.take(nextJob.first);
+		if(albumGain.valid)
+		{
+			if(m_settings->albumGainMode() == SettingsModel::AlbumGain_ApplyGain)
+			{
+				//Don't push the loudest peak of the album beyond full scale
+				thread->addFilter(new GainFilter(qMin(albumGain.albumGain, -LoudnessMeter::toDecibel(albumGain.albumPeak))));
+				applyAlbumGain = true;
+			}
+			else
+			{
+				encoder->setReplayGain(albumGain.trackGain, albumGain.trackPeak, albumGain.albumGain, albumGain.albumPeak);
+			}
+		}
+	}
+
 	//Add audio filters
 	if(m_settings->forceStereoDownmix())
 	{
@@ -621,7 +754,7 @@ void ProcessingDialog::startNextJob(void)
 	{
 		thread->addFilter(new ToneAdjustFilter(m_settings->toneAdjustBass(), m_settings->toneAdjustTreble()));
 	}
-	if(m_settings->normalizationFilterEnabled())
+	if(m_settings->normalizationFilterEnabled() && (!applyAlbumGain))
 	{
 		thread->addFilter(new NormalizeFilter(m_settings->normalizationFilterMaxVolume(), m_settings->normalizationFilterDynamic(), m_settings->normalizationFilterCoupled(), m_settings->normalizationFilterSize()));
 	}
@@ -645,9 +778,17 @@ void ProcessingDialog::startNextJob(void)
 	{
 		thread->setKeepDateTime(m_settings->keepOriginalDataTime());
 	}
+	if (m_settings->streamingPipelineEnabled())
+	{
+		thread->setStreamingMode(m_settings->streamingPipelineEnabled());
+	}
+	if (m_settings->nativeFiltersEnabled())
+	{
+		thread->setNativeFilters(m_settings->nativeFiltersEnabled());
+	}
 
 	//Save job UUID
-	m_allJobs.append(thread->getId());
+	m_allJobs.insert(nextJob.first, thread->getId());
 	
 	//Connect thread signals
 	connect(thread.data(), SIGNAL(processFinished()), this, SLOT(doneEncoding()), Qt::QueuedConnection);
@@ -655,6 +796,8 @@ void ProcessingDialog::startNextJob(void)
 	connect(thread.data(), SIGNAL(processStateChanged(QUuid,QString,int)), m_progressModel.data(), SLOT(updateJob(QUuid,QString,int)), Qt::QueuedConnection);
 	connect(thread.data(), SIGNAL(processStateFinished(QUuid,QString,int)), this, SLOT(processFinished(QUuid,QString,int)), Qt::QueuedConnection);
 	connect(thread.data(), SIGNAL(processMessageLogged(QUuid,QString)), m_progressModel.data(), SLOT(appendToLog(QUuid,QString)), Qt::QueuedConnection);
+	connect(thread.data(), SIGNAL(processStatsCollected(QUuid,ProcessThread::jobStats_t)), this, SLOT(processStatsCollected(QUuid,ProcessThread::jobStats_t)), Qt::QueuedConnection);
+	connect(thread.data(), SIGNAL(processLoudnessMeasured(QUuid,ProcessThread::loudness_t)), this, SLOT(processLoudnessMeasured(QUuid,ProcessThread::loudness_t)), Qt::QueuedConnection);
 	connect(this, SIGNAL(abortRunningTasks()), thread.data(), SLOT(abort()), Qt::DirectConnection);
 
 	//Initialize thread object
@@ -679,6 +822,7 @@ void ProcessingDialog::abortEncoding(bool force)
 	if(force) m_forcedAbort = true;
 	ui->button_AbortProcess->setEnabled(false);
 	SET_PROGRESS_TEXT(tr("Aborted! Waiting for running jobs to terminate..."));
+	m_albumGainAbort.ref();
 	emit abortRunningTasks();
 }
 
@@ -695,8 +839,8 @@ void ProcessingDialog::doneEncoding(void)
 	
 	if((!m_pendingJobs.isEmpty()) && (!m_userAborted))
 	{
-		QTimer::singleShot(25, this, SLOT(startNextJob()));
-		qDebug("%d files left, starting next job...", m_pendingJobs.count());
+		qDebug("%d files left, %u of %u instances running.", m_pendingJobs.count(), m_runningThreads, m_targetThreads);
+		admitPendingJobs();
 		return;
 	}
 	
@@ -709,12 +853,32 @@ void ProcessingDialog::doneEncoding(void)
 	QApplication::setOverrideCursor(Qt::WaitCursor);
 	qDebug("Running jobs: %u", m_runningThreads);
 
+	m_albumGain.clear();
+
+	quint64 launchCount; qint64 launchWaitTotal, launchWaitMax;
+	AbstractTool::getStartProcessStats(launchCount, launchWaitTotal, launchWaitMax);
+	qDebug("Launched %llu processes, waited %lld ms in total (%lld ms max) for a launch slot.", launchCount, launchWaitTotal, launchWaitMax);
+
+	if(!m_userAborted && m_albumGainInline)
+	{
+		SET_PROGRESS_TEXT(tr("Writing the ReplayGain tags, please wait..."));
+		qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+		writeAlbumGainTags();
+	}
+
 	if(!m_userAborted && m_settings->createPlaylist() && !m_settings->outputToSourceDir())
 	{
 		SET_PROGRESS_TEXT(tr("Creating the playlist file, please wait..."));
 		qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
 		writePlayList();
 	}
+
+	if(m_settings->metricsReportEnabled() && (!m_jobStats.isEmpty()))
+	{
+		SET_PROGRESS_TEXT(tr("Writing the metrics report, please wait..."));
+		qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+		writeMetricsReport(((!m_totalTime.isNull()) && m_totalTime->isValid()) ? m_totalTime->elapsed() : 0i64);
+	}
 	
 	if(m_userAborted)
 	{
@@ -734,6 +898,8 @@ void ProcessingDialog::doneEncoding(void)
 			m_totalTime->invalidate();
 		}
 
+		logJobStats();
+
 		if(m_failedJobs.count() > 0)
 		{
 			CHANGE_BACKGROUND_COLOR(ui->frame_header, QColor("#FFF0F0"));
@@ -817,6 +983,35 @@ void ProcessingDialog::processFinished(const QUuid &jobId, const QString &outFil
 	}
 }
 
+void ProcessingDialog::processStatsCollected(const QUuid &jobId, const ProcessThread::jobStats_t &stats)
+{
+	m_jobStats.insert(jobId, stats);
+}
+
+void ProcessingDialog::processLoudnessMeasured(const QUuid &jobId, const ProcessThread::loudness_t &loudness)
+{
+	m_measuredLoudness.insert(jobId, loudness);
+}
+
+void ProcessingDialog::albumGainCompleted(const unsigned int /*jobIndex*/)
+{
+	if(m_albumGainTasks.isEmpty())
+	{
+		return;
+	}
+
+	if(++m_albumGainDone < static_cast<unsigned int>(m_albumGainTasks.count()))
+	{
+		if(!m_userAborted)
+		{
+			SET_PROGRESS_TEXT(tr("Analyzing loudness: %n file(s) of %1 completed so far, please wait...", "", m_albumGainDone).arg(QString::number(m_albumGainTasks.count())));
+		}
+		return;
+	}
+
+	finishAlbumGain();
+}
+
 void ProcessingDialog::progressModelChanged(void)
 {
 	//Update filter as soon as the model changes!
@@ -970,18 +1165,448 @@ void ProcessingDialog::progressViewFilterChanged(void)
 
 QThreadPool *ProcessingDialog::createThreadPool(void)
 {
+	const quint32 pendingJobs = qMax(1U, static_cast<quint32>(m_pendingJobs.count()));
 	quint32 maximumInstances = qBound(0U, m_settings->maximumInstances(), MAX_INSTANCES);
+
+	//A fixed number of instances was configured by the user, so don't adapt
+	m_adaptiveThreads = false;
+	m_targetThreads = m_minimumThreads = qBound(1U, maximumInstances, pendingJobs);
+
 	if (maximumInstances < 1U)
 	{
 		const MUtils::CPUFetaures::cpu_info_t cpuFeatures = MUtils::CPUFetaures::detect();
 		const quint32 nProcessors = qBound(1U, cpuFeatures.count, MAX_INSTANCES);
-		maximumInstances = isFastSeekingDevice(m_tempFolder) ? nProcessors : cores2instances(nProcessors);
+		
+		//Start with the static estimate, then let the CPU/Disk load decide whether to admit more jobs
+		m_targetThreads = qBound(1U, isFastSeekingDevice(m_tempFolder) ? nProcessors : cores2instances(nProcessors), pendingJobs);
+		m_minimumThreads = qMax(1U, m_targetThreads / 2U);
+		maximumInstances = qBound(1U, nProcessors, pendingJobs);
+		m_adaptiveThreads = (maximumInstances > m_targetThreads);
 	}
+
 	QThreadPool *const threadPool = new QThreadPool();
-	threadPool->setMaxThreadCount(qBound(1U, maximumInstances, static_cast<unsigned int>(m_pendingJobs.count())));
+	threadPool->setMaxThreadCount(qBound(1U, maximumInstances, pendingJobs));
 	return threadPool;
 }
 
+void ProcessingDialog::admitPendingJobs(void)
+{
+	//Queue as many jobs as the current target allows, jobs are started one at a time by initNextJob()
+	const unsigned int queueFirst = m_initThreads;
+	while((m_runningThreads + m_initThreads < m_targetThreads) && (m_initThreads < static_cast<unsigned int>(m_pendingJobs.count())))
+	{
+		m_initThreads++;
+	}
+	if((queueFirst == 0) && (m_initThreads > 0))
+	{
+		QTimer::singleShot(25, this, SLOT(initNextJob()));
+	}
+}
+
+void ProcessingDialog::adjustConcurrency(const double cpuUsage)
+{
+	if(m_userAborted || m_pendingJobs.isEmpty() || m_lastAdjustment.isNull() || (!m_albumGainTasks.isEmpty()))
+	{
+		return;
+	}
+
+	//Give the most recent change some time to take effect
+	if((m_initThreads > 0) || (m_lastAdjustment->elapsed() < ADAPTIVE_INTERVAL))
+	{
+		return;
+	}
+
+	const unsigned int maximumThreads = static_cast<unsigned int>(m_threadPool->maxThreadCount());
+
+	//A fully loaded CPU is the goal, so only disk saturation or memory pressure hold back the next job
+	if((m_diskLoad > ADAPTIVE_DISK_BUSY) || (m_ramUsage > ADAPTIVE_RAM_BUSY))
+	{
+		if(m_targetThreads > m_minimumThreads)
+		{
+			m_targetThreads--;
+			qDebug("Adaptive scheduling: CPU %.2f, Disk %.2f, RAM %.2f -> decreasing to %u instances.", cpuUsage, m_diskLoad, m_ramUsage, m_targetThreads);
+			m_lastAdjustment->restart();
+		}
+	}
+	else if((cpuUsage < ADAPTIVE_CPU_IDLE) && (m_runningThreads >= m_targetThreads))
+	{
+		//Some cores are idle (e.g. jobs are waiting on I/O), admit another job
+		if(m_targetThreads < maximumThreads)
+		{
+			m_targetThreads++;
+			qDebug("Adaptive scheduling: CPU %.2f, Disk %.2f, RAM %.2f -> increasing to %u instances.", cpuUsage, m_diskLoad, m_ramUsage, m_targetThreads);
+			m_lastAdjustment->restart();
+			admitPendingJobs();
+		}
+	}
+}
+
+/*
+ * Decode and analyze all files of the batch in parallel, the pre-pass counts as a single running job
+ */
+bool ProcessingDialog::startAlbumGain(void)
+{
+	m_albumGain.clear();
+	m_albumGainDone = 0;
+	m_albumGainAbort = 0;
+
+	for(QList<pending_job_t>::ConstIterator iter = m_pendingJobs.constBegin(); iter != m_pendingJobs.constEnd(); iter++)
+	{
+		//Tracks of a cue sheet image are cut out by the job, so the pre-pass can not measure them
+		if(iter->second.isTrack())
+		{
+			continue;
+		}
+		AlbumGainTask *const task = new AlbumGainTask(iter->first, iter->second, m_tempFolder, m_albumGainAbort);
+		connect(task, SIGNAL(taskCompleted(unsigned int)), this, SLOT(albumGainCompleted(unsigned int)), Qt::QueuedConnection);
+		m_albumGainTasks.insert(iter->first, task);
+	}
+
+	if(m_albumGainTasks.isEmpty())
+	{
+		return false;
+	}
+
+	m_runningThreads++;
+	m_progressModel->addSystemMessage(tr("Album gain: Analyzing the loudness of %n file(s) before encoding.", "", m_albumGainTasks.count()));
+	SET_PROGRESS_TEXT(tr("Analyzing loudness, please wait..."));
+
+	for(QMap<quint32, AlbumGainTask*>::ConstIterator iter = m_albumGainTasks.constBegin(); iter != m_albumGainTasks.constEnd(); iter++)
+	{
+		m_threadPool->start(iter.value());
+	}
+
+	return true;
+}
+
+void ProcessingDialog::finishAlbumGain(void)
+{
+	//All tasks have signalled completion, but they may still be returning from run()
+	m_threadPool->waitForDone();
+
+	if(!m_userAborted)
+	{
+		//Group the files by album and artist, a file without an album is an album of its own
+		QMap<QString, QList<AlbumGainTask*> > albums;
+		for(QList<pending_job_t>::ConstIterator iter = m_pendingJobs.constBegin(); iter != m_pendingJobs.constEnd(); iter++)
+		{
+			AlbumGainTask *const task = m_albumGainTasks.value(iter->first, NULL);
+			if(task && task->success())
+			{
+				AudioFileModel audioFile(iter->second);
+				updateMetaInfo(audioFile);
+				albums[albumKey(iter->first, audioFile.metaInfo())] << task;
+			}
+		}
+
+		for(QMap<QString, QList<AlbumGainTask*> >::ConstIterator iter = albums.constBegin(); iter != albums.constEnd(); iter++)
+		{
+			QList<ProcessThread::loudness_t> tracks;
+			for(QList<AlbumGainTask*>::ConstIterator task = iter->constBegin(); task != iter->constEnd(); task++)
+			{
+				ProcessThread::loudness_t loudness;
+				loudness.loudness = (*task)->loudness();
+				loudness.truePeak = (*task)->truePeak();
+				loudness.blockEnergies = (*task)->blockEnergies();
+				tracks << loudness;
+			}
+
+			QList<album_gain_t> albumGain;
+			computeAlbumGain(tracks, albumGain);
+			for(int i = 0; i < iter->count(); i++)
+			{
+				m_albumGain.insert(iter->at(i)->jobIndex(), albumGain.at(i));
+			}
+		}
+
+		m_progressModel->addSystemMessage(tr("Album gain: Analyzed %n album(s).", "", albums.count()));
+	}
+
+	qDeleteAll(m_albumGainTasks);
+	m_albumGainTasks.clear();
+
+	if(m_userAborted)
+	{
+		m_pendingJobs.clear();
+		doneEncoding();
+		return;
+	}
+
+	m_runningThreads--;
+	SET_PROGRESS_TEXT(tr("Encoding files, please wait..."));
+	admitPendingJobs();
+}
+
+/*
+ * Write the ReplayGain tags of the files whose loudness was measured while encoding, the album gain is known now
+ */
+void ProcessingDialog::writeAlbumGainTags(void)
+{
+	//Group the files by album and artist, just like the pre-pass does
+	QMap<QString, QList<QUuid> > albums;
+	for(QList<QUuid>::ConstIterator iter = m_succeededJobs.constBegin(); iter != m_succeededJobs.constEnd(); iter++)
+	{
+		if(m_measuredLoudness.contains(*iter) && m_albumKeys.contains(*iter))
+		{
+			albums[m_albumKeys.value(*iter)] << (*iter);
+		}
+	}
+
+	QScopedPointer<AbstractEncoder> encoder(EncoderRegistry::createInstance(m_settings->compressionEncoder(), m_settings));
+	unsigned int taggedFiles = 0, failedFiles = 0;
+
+	for(QMap<QString, QList<QUuid> >::ConstIterator iter = albums.constBegin(); iter != albums.constEnd(); iter++)
+	{
+		QList<ProcessThread::loudness_t> tracks;
+		for(QList<QUuid>::ConstIterator jobId = iter->constBegin(); jobId != iter->constEnd(); jobId++)
+		{
+			tracks << m_measuredLoudness.value(*jobId);
+		}
+
+		QList<album_gain_t> albumGain;
+		computeAlbumGain(tracks, albumGain);
+		for(int i = 0; i < iter->count(); i++)
+		{
+			if(albumGain.at(i).valid)
+			{
+				encoder->setReplayGain(albumGain.at(i).trackGain, albumGain.at(i).trackPeak, albumGain.at(i).albumGain, albumGain.at(i).albumPeak);
+				if(encoder->updateReplayGain(m_playList.value(iter->at(i))))
+				{
+					taggedFiles++;
+					continue;
+				}
+				failedFiles++;
+			}
+		}
+	}
+
+	m_progressModel->addSystemMessage(tr("Album gain: Wrote the ReplayGain tags of %n file(s) in %1 album(s).", "", taggedFiles).arg(QString::number(albums.count())));
+	if(failedFiles > 0)
+	{
+		m_progressModel->addSystemMessage(tr("Album gain: The ReplayGain tags of %n file(s) could not be written!", "", failedFiles), ProgressModel::SysMsg_Warning);
+	}
+
+	m_albumKeys.clear();
+	m_measuredLoudness.clear();
+}
+
+/*
+ * Files without an album are an album of their own
+ */
+QString ProcessingDialog::albumKey(const quint32 jobIndex, const AudioFileModel_MetaInfo &metaInfo)
+{
+	const QString &album = metaInfo.album();
+	return album.isEmpty() ? QString("#%1").arg(QString::number(jobIndex)) : QString("%1\n%2").arg(album, metaInfo.artist());
+}
+
+/*
+ * The album loudness is measured over the gating blocks of all tracks, so the album gain does not depend on the track lengths
+ */
+void ProcessingDialog::computeAlbumGain(const QList<ProcessThread::loudness_t> &tracks, QList<album_gain_t> &albumGain)
+{
+	QVector<double> blockEnergies;
+	double albumPeak = 0.0;
+	for(QList<ProcessThread::loudness_t>::ConstIterator iter = tracks.constBegin(); iter != tracks.constEnd(); iter++)
+	{
+		blockEnergies << iter->blockEnergies;
+		albumPeak = qMax(albumPeak, iter->truePeak);
+	}
+
+	const double albumLoudness = LoudnessMeter::integratedLoudness(blockEnergies);
+	albumGain.clear();
+	for(QList<ProcessThread::loudness_t>::ConstIterator iter = tracks.constBegin(); iter != tracks.constEnd(); iter++)
+	{
+		album_gain_t gain;
+		gain.valid = _finite(iter->loudness) && _finite(albumLoudness);
+		gain.trackGain = ALBUM_GAIN_REFERENCE - iter->loudness;
+		gain.trackPeak = iter->truePeak;
+		gain.albumGain = ALBUM_GAIN_REFERENCE - albumLoudness;
+		gain.albumPeak = albumPeak;
+		albumGain << gain;
+	}
+}
+
+/*
+ * Sum up the statistics of all jobs per step, so we can see where the time of the batch went
+ */
+void ProcessingDialog::logJobStats(void)
+{
+	if(m_jobStats.isEmpty())
+	{
+		return;
+	}
+
+	QStringList stepNames;
+	QMap<QString, ProcessThread::stageStats_t> steps;
+	double duration = 0.0;
+	qint64 wallTime = 0i64;
+
+	for(QMap<QUuid, ProcessThread::jobStats_t>::ConstIterator iter = m_jobStats.constBegin(); iter != m_jobStats.constEnd(); iter++)
+	{
+		if(iter->stages.isEmpty())
+		{
+			continue; /*job did not run*/
+		}
+		duration += iter->duration;
+		wallTime += iter->wallTime;
+		for(QList<ProcessThread::stageStats_t>::ConstIterator stage = iter->stages.constBegin(); stage != iter->stages.constEnd(); stage++)
+		{
+			if(!steps.contains(stage->name))
+			{
+				ProcessThread::stageStats_t total = { stage->name, 0i64, 0ui64, 0ui64, 0ui64, 0ui64, 0 };
+				steps.insert(stage->name, total);
+				stepNames << stage->name;
+			}
+			ProcessThread::stageStats_t &total = steps[stage->name];
+			total.wallTime += stage->wallTime;
+			total.userTime += stage->userTime;
+			total.kernelTime += stage->kernelTime;
+			total.bytesIn += stage->bytesIn;
+			total.bytesOut += stage->bytesOut;
+		}
+	}
+
+	for(QStringList::ConstIterator iter = stepNames.constBegin(); iter != stepNames.constEnd(); iter++)
+	{
+		const ProcessThread::stageStats_t &total = steps[*iter];
+		qDebug("%s: %lld ms wall time, %llu ms user time, %llu ms kernel time, %llu bytes in, %llu bytes out", MUTILS_UTF8(*iter), total.wallTime, total.userTime, total.kernelTime, total.bytesIn, total.bytesOut);
+		m_progressModel->addSystemMessage(tr("%1: %2 spent in total, %3 of CPU time used by the tools.").arg(*iter, time2text(total.wallTime), time2text(total.userTime + total.kernelTime)), ProgressModel::SysMsg_Performance);
+	}
+
+	const double realtimeFactor = ProcessThread::realtimeFactor(duration, wallTime);
+	if(realtimeFactor > 0.0)
+	{
+		m_progressModel->addSystemMessage(tr("Jobs were processed at %1x realtime on average.").arg(QString::number(realtimeFactor, 'f', 1)), ProgressModel::SysMsg_Performance);
+	}
+}
+
+/*
+ * Machine-readable report of the batch, one record per job plus the batch aggregates, written as JSON and CSV next to the output files
+ */
+void ProcessingDialog::writeMetricsReport(const qint64 wallTime)
+{
+	static const char *const STEP_NAMES[] = { "Decode", "Analyze", "Filter", "Encode", NULL };
+
+	//Sum up the jobs that did run
+	double duration = 0.0;
+	quint64 userTime = 0ui64, kernelTime = 0ui64;
+	QString outputDir = m_settings->outputToSourceDir() ? QString() : m_settings->outputDir();
+	for(QMap<QUuid, ProcessThread::jobStats_t>::ConstIterator iter = m_jobStats.constBegin(); iter != m_jobStats.constEnd(); iter++)
+	{
+		if(outputDir.isEmpty() && (!iter->outputFile.isEmpty()))
+		{
+			outputDir = QFileInfo(iter->outputFile).absolutePath();
+		}
+		if(iter->stages.isEmpty())
+		{
+			continue; /*job did not run*/
+		}
+		duration += iter->duration;
+		for(QList<ProcessThread::stageStats_t>::ConstIterator stage = iter->stages.constBegin(); stage != iter->stages.constEnd(); stage++)
+		{
+			userTime += stage->userTime;
+			kernelTime += stage->kernelTime;
+		}
+	}
+
+	const double cpuUsageAverage = (m_batchMetrics.cpuUsageCount > 0) ? (m_batchMetrics.cpuUsageTotal / static_cast<double>(m_batchMetrics.cpuUsageCount)) : 0.0;
+	const quint64 tempSpacePeak = (m_batchMetrics.freeSpaceInitial > m_batchMetrics.freeSpaceMinimum) ? (m_batchMetrics.freeSpaceInitial - m_batchMetrics.freeSpaceMinimum) : 0ui64;
+
+	//Encoder settings, so that runs with different settings can be compared
+	const int encoderId = m_settings->compressionEncoder();
+	const AbstractEncoderInfo *const encoderInfo = EncoderRegistry::getEncoderInfo(encoderId);
+	const int rcMode = EncoderRegistry::loadEncoderMode(m_settings, encoderId);
+	const int valueCount = encoderInfo->valueCount(rcMode);
+	const int value = (valueCount > 0) ? encoderInfo->valueAt(rcMode, qBound(0, EncoderRegistry::loadEncoderValue(m_settings, encoderId, rcMode), valueCount - 1)) : 0;
+
+	QStringList json, csv;
+	json << "{";
+	json << QString("  \"application\": %1,").arg(JSON_STRING(QString().sprintf("LameXP v%d.%02d %s (Build %d)", lamexp_version_major(), lamexp_version_minor(), lamexp_version_release(), lamexp_version_build())));
+	json << QString("  \"created\": %1,").arg(JSON_STRING(QDateTime::currentDateTime().toString(Qt::ISODate)));
+	json << QString("  \"encoder\": { \"name\": %1, \"rc_mode\": %2, \"value\": %3, \"custom_params\": %4 },").arg(JSON_STRING(QString::fromLatin1(encoderInfo->description())), QString::number(rcMode), QString::number(value), JSON_STRING(EncoderRegistry::loadEncoderCustomParams(m_settings, encoderId)));
+	json << "  \"batch\": {";
+	json << QString("    \"jobs\": %1, \"succeeded\": %2, \"failed\": %3, \"skipped\": %4, \"aborted\": %5,").arg(QString::number(m_jobStats.count()), QString::number(m_succeededJobs.count()), QString::number(m_failedJobs.count()), QString::number(m_skippedJobs.count()), QLatin1String(m_userAborted ? "true" : "false"));
+	json << QString("    \"instances\": %1, \"wall_time_ms\": %2, \"audio_duration_s\": %3,").arg(QString::number(m_targetThreads), QString::number(wallTime), QString::number(duration, 'f', 3));
+	json << QString("    \"audio_hours_per_wall_hour\": %1, \"cpu_user_time_ms\": %2, \"cpu_kernel_time_ms\": %3,").arg(QString::number(ProcessThread::realtimeFactor(duration, wallTime), 'f', 3), QString::number(userTime), QString::number(kernelTime));
+	json << QString("    \"cpu_usage_average\": %1, \"cpu_usage_peak\": %2, \"ram_usage_peak\": %3, \"temp_space_peak_bytes\": %4").arg(QString::number(cpuUsageAverage, 'f', 3), QString::number(m_batchMetrics.cpuUsagePeak, 'f', 3), QString::number(m_batchMetrics.ramUsagePeak, 'f', 3), QString::number(tempSpacePeak));
+	json << "  },";
+	json << "  \"jobs\": [";
+
+	QString csvHeader("source,output,result,reason,duration_s,source_size,output_size,wall_time_ms,realtime_factor");
+	for(int i = 0; STEP_NAMES[i]; i++)
+	{
+		csvHeader.append(QString(",%1_ms").arg(QString::fromLatin1(STEP_NAMES[i]).toLower()));
+	}
+	csv << csvHeader.append(",cpu_user_time_ms,cpu_kernel_time_ms,exit_code");
+
+	//One record per job, in the order of the file list
+	QStringList jobRecords;
+	for(QMap<quint32, QUuid>::ConstIterator iter = m_allJobs.constBegin(); iter != m_allJobs.constEnd(); iter++)
+	{
+		if(!m_jobStats.contains(iter.value()))
+		{
+			continue;
+		}
+
+		const ProcessThread::jobStats_t &stats = m_jobStats[iter.value()];
+		const double realtimeFactor = ProcessThread::realtimeFactor(stats.duration, stats.wallTime);
+
+		QStringList stages;
+		QMap<QString, qint64> stepTimes;
+		quint64 jobUserTime = 0ui64, jobKernelTime = 0ui64;
+		int exitCode = 0;
+		for(QList<ProcessThread::stageStats_t>::ConstIterator stage = stats.stages.constBegin(); stage != stats.stages.constEnd(); stage++)
+		{
+			stages << QString("{ \"name\": %1, \"wall_time_ms\": %2, \"user_time_ms\": %3, \"kernel_time_ms\": %4, \"bytes_in\": %5, \"bytes_out\": %6, \"exit_code\": %7 }").arg(JSON_STRING(stage->name), QString::number(stage->wallTime), QString::number(stage->userTime), QString::number(stage->kernelTime), QString::number(stage->bytesIn), QString::number(stage->bytesOut), QString::number(stage->exitCode));
+			stepTimes[stage->name] += stage->wallTime;
+			jobUserTime += stage->userTime;
+			jobKernelTime += stage->kernelTime;
+			if(stage->exitCode != 0)
+			{
+				exitCode = stage->exitCode;
+			}
+		}
+
+		QStringList record;
+		record << "    {";
+		record << QString("      \"source\": %1, \"output\": %2,").arg(JSON_STRING(QDir::toNativeSeparators(stats.sourceFile)), JSON_STRING(QDir::toNativeSeparators(stats.outputFile)));
+		record << QString("      \"result\": %1, \"reason\": %2,").arg(JSON_STRING(stats.result), JSON_STRING(stats.reason));
+		record << QString("      \"duration_s\": %1, \"source_size\": %2, \"output_size\": %3, \"wall_time_ms\": %4, \"realtime_factor\": %5,").arg(QString::number(stats.duration, 'f', 3), QString::number(stats.sourceSize), QString::number(stats.outputSize), QString::number(stats.wallTime), QString::number(realtimeFactor, 'f', 3));
+		record << QString("      \"stages\": [%1]").arg(stages.isEmpty() ? QString() : QString("\r\n        %1\r\n      ").arg(stages.join(",\r\n        ")));
+		record << "    }";
+		jobRecords << record.join("\r\n");
+
+		QString line = QString("%1,%2,%3,%4,%5,%6,%7,%8,%9").arg(CSV_STRING(QDir::toNativeSeparators(stats.sourceFile)), CSV_STRING(QDir::toNativeSeparators(stats.outputFile)), CSV_STRING(stats.result), CSV_STRING(stats.reason), QString::number(stats.duration, 'f', 3), QString::number(stats.sourceSize), QString::number(stats.outputSize), QString::number(stats.wallTime), QString::number(realtimeFactor, 'f', 3));
+		for(int i = 0; STEP_NAMES[i]; i++)
+		{
+			line.append(QString(",%1").arg(QString::number(stepTimes.value(QString::fromLatin1(STEP_NAMES[i]), 0i64))));
+		}
+		csv << line.append(QString(",%1,%2,%3").arg(QString::number(jobUserTime), QString::number(jobKernelTime), QString::number(exitCode)));
+	}
+
+	json << jobRecords.join(",\r\n");
+	json << "  ]";
+	json << "}";
+
+	//Now write the report files
+	const QString reportName = QString("%1/LameXP Report %2").arg((outputDir.isEmpty() ? m_settings->outputDir() : outputDir), QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss"));
+	const QPair<QString, QStringList> reports[2] = { qMakePair(QString("%1.json").arg(reportName), json), qMakePair(QString("%1.csv").arg(reportName), csv) };
+	for(size_t i = 0; i < 2; i++)
+	{
+		QFile reportFile(reports[i].first);
+		if(reportFile.open(QIODevice::WriteOnly))
+		{
+			reportFile.write(reports[i].second.join("\r\n").append("\r\n").toUtf8());
+			reportFile.close();
+		}
+		else
+		{
+			qWarning("Failed to write metrics report: \"%s\"", MUTILS_UTF8(reports[i].first));
+			m_progressModel->addSystemMessage(tr("The metrics report could not be written to: %1").arg(QDir::toNativeSeparators(reports[i].first)), ProgressModel::SysMsg_Warning);
+		}
+	}
+}
+
 void ProcessingDialog::writePlayList(void)
 {
 	if(m_succeededJobs.count() <= 0 || m_allJobs.count() <= 0)
@@ -1010,10 +1635,10 @@ void ProcessingDialog::writePlayList(void)
 	playListName = MUtils::clean_file_name(playListName, true);
 
 	//Create list of audio files
-	for(int i = 0; i < m_allJobs.count(); i++)
+	for(QMap<quint32, QUuid>::ConstIterator iter = m_allJobs.constBegin(); iter != m_allJobs.constEnd(); iter++)
 	{
-		if(!m_succeededJobs.contains(m_allJobs.at(i))) continue;
-		list << QDir::toNativeSeparators(QDir(m_settings->outputDir()).relativeFilePath(m_playList.value(m_allJobs.at(i), "N/A")));
+		if(!m_succeededJobs.contains(iter.value())) continue;
+		list << QDir::toNativeSeparators(QDir(m_settings->outputDir()).relativeFilePath(m_playList.value(iter.value(), "N/A")));
 	}
 
 	//Use prefix?
@@ -1096,6 +1721,15 @@ void ProcessingDialog::cpuUsageHasChanged(const double val)
 	
 	ui->label_cpu->setText(QString().sprintf(" %d%%", qRound(val * 100.0)));
 	UPDATE_MIN_WIDTH(ui->label_cpu);
+
+	m_batchMetrics.cpuUsageTotal += val;
+	m_batchMetrics.cpuUsageCount++;
+	m_batchMetrics.cpuUsagePeak = qMax(m_batchMetrics.cpuUsagePeak, val);
+
+	if(m_adaptiveThreads)
+	{
+		adjustConcurrency(val);
+	}
 }
 
 void ProcessingDialog::ramUsageHasChanged(const double val)
@@ -1103,6 +1737,9 @@ void ProcessingDialog::ramUsageHasChanged(const double val)
 	
 	ui->label_ram->setText(QString().sprintf(" %d%%", qRound(val * 100.0)));
 	UPDATE_MIN_WIDTH(ui->label_ram);
+
+	m_batchMetrics.ramUsagePeak = qMax(m_batchMetrics.ramUsagePeak, val);
+	m_ramUsage = val;
 }
 
 void ProcessingDialog::diskUsageHasChanged(const quint64 val)
@@ -1119,6 +1756,17 @@ void ProcessingDialog::diskUsageHasChanged(const quint64 val)
 
 	ui->label_disk->setText(QString().sprintf(" %3.1f %s", space, postfixStr[postfix]));
 	UPDATE_MIN_WIDTH(ui->label_disk);
+
+	if(m_batchMetrics.freeSpaceInitial == 0ui64)
+	{
+		m_batchMetrics.freeSpaceInitial = m_batchMetrics.freeSpaceMinimum = val;
+	}
+	m_batchMetrics.freeSpaceMinimum = qMin(m_batchMetrics.freeSpaceMinimum, val);
+}
+
+void ProcessingDialog::diskLoadHasChanged(const double val)
+{
+	m_diskLoad = val;
 }
 
 bool ProcessingDialog::shutdownComputer(void)
@@ -1216,6 +1864,39 @@ quint32 ProcessingDialog::cores2instances(const quint32 &cores)
 	return static_cast<quint32>(qRound(y));
 }
 
+quint64 ProcessingDialog::estimateJobCost(const AudioFileModel &audioFile)
+{
+	const AudioFileModel_TechInfo &techInfo = audioFile.techInfo();
+
+	quint64 duration = techInfo.duration();
+	if(audioFile.isTrack())
+	{
+		//Only the track gets encoded, not the whole image; the last track may extend to the end of the image
+		if(_finite(audioFile.trackLength()) && (audioFile.trackLength() > 0.0))
+		{
+			duration = static_cast<quint64>(ceil(audioFile.trackLength()));
+		}
+	}
+	else if((duration == 0) && (techInfo.audioBitrate() > 0))
+	{
+		duration = static_cast<quint64>(QFileInfo(audioFile.filePath()).size()) * 8ui64 / (static_cast<quint64>(techInfo.audioBitrate()) * 1000ui64);
+	}
+	if(duration == 0)
+	{
+		return UINT64_MAX; /*unknown, could be a long one*/
+	}
+
+	const quint64 channels = (techInfo.audioChannels() > 0) ? techInfo.audioChannels() : 2U;
+	const quint64 samplerate = (techInfo.audioSamplerate() > 0) ? techInfo.audioSamplerate() : 44100U;
+
+	return duration * channels * samplerate;
+}
+
+bool ProcessingDialog::compareJobCost(const job_cost_t &job1, const job_cost_t &job2)
+{
+	return job1.first > job2.first;
+}
+
 QString ProcessingDialog::time2text(const qint64 &msec)
 {
 	const qint64 MILLISECONDS_PER_DAY = 86399999;	//24x60x60x1000 - 1
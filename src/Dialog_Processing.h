@@ -26,8 +26,12 @@
 #include <QUuid>
 #include <QSystemTrayIcon>
 #include <QMap>
+#include <QPair>
+
+#include "Thread_Process.h"
 
 class AbstractEncoder;
+class AlbumGainTask;
 class AudioFileModel;
 class AudioFileModel_MetaInfo;
 class CPUObserverThread;
@@ -84,6 +88,8 @@ private slots:
 	void doneEncoding(void);
 	void abortEncoding(bool force = false);
 	void processFinished(const QUuid &jobId, const QString &outFileName, int success);
+	void processStatsCollected(const QUuid &jobId, const ProcessThread::jobStats_t &stats);
+	void processLoudnessMeasured(const QUuid &jobId, const ProcessThread::loudness_t &loudness);
 	void progressModelChanged(void);
 	void logViewDoubleClicked(const QModelIndex &index);
 	void logViewSectionSizeChanged(int, int, int);
@@ -95,7 +101,9 @@ private slots:
 	void cpuUsageHasChanged(const double val);
 	void ramUsageHasChanged(const double val);
 	void diskUsageHasChanged(const quint64 val);
+	void diskLoadHasChanged(const double val);
 	void progressViewFilterChanged(void);
+	void albumGainCompleted(const unsigned int jobIndex);
 
 signals:
 	void abortRunningTasks(void);
@@ -111,26 +119,75 @@ private:
 	Ui::ProcessingDialog *ui; //for Qt UIC
 
 	QThreadPool *createThreadPool(void);
+	void admitPendingJobs(void);
+	void adjustConcurrency(const double cpuUsage);
+	bool startAlbumGain(void);
+	void finishAlbumGain(void);
+	void writeAlbumGainTags(void);
+	void logJobStats(void);
+	void writeMetricsReport(const qint64 wallTime);
 	void updateMetaInfo(AudioFileModel &audioFile);
 	void writePlayList(void);
 	bool shutdownComputer(void);
 	
+	typedef QPair<quint32, AudioFileModel> pending_job_t;
+	typedef QPair<quint64, pending_job_t> job_cost_t;
+
+	typedef struct
+	{
+		bool valid;				//Gain is valid, i.e. the file is not silent
+		double trackGain;
+		double trackPeak;
+		double albumGain;
+		double albumPeak;
+	}
+	album_gain_t;
+
+	static QString albumKey(const quint32 jobIndex, const AudioFileModel_MetaInfo &metaInfo);
+	static void computeAlbumGain(const QList<ProcessThread::loudness_t> &tracks, QList<album_gain_t> &albumGain);
+
+	typedef struct
+	{
+		double cpuUsageTotal;
+		quint32 cpuUsageCount;
+		double cpuUsagePeak;
+		double ramUsagePeak;
+		quint64 freeSpaceInitial;	//Free space of the temp folder, when the batch started
+		quint64 freeSpaceMinimum;
+	}
+	batch_metrics_t;
+
 	QScopedPointer<QThreadPool> m_threadPool;
-	QList<AudioFileModel> m_pendingJobs;
+	QList<pending_job_t> m_pendingJobs;
 	const SettingsModel *const m_settings;
 	const AudioFileModel_MetaInfo *const m_metaInfo;
 	const QString m_tempFolder;
 	QScopedPointer<QMovie> m_progressIndicator;
 	QScopedPointer<ProgressModel> m_progressModel;
 	QMap<QUuid,QString> m_playList;
+	QMap<QUuid,ProcessThread::jobStats_t> m_jobStats;
+	batch_metrics_t m_batchMetrics;
 	QScopedPointer<QMenu> m_contextMenu;
 	QScopedPointer<QActionGroup> m_progressViewFilterGroup;
 	QScopedPointer<QLabel> m_filterInfoLabel;
 	QScopedPointer<QLabel> m_filterInfoLabelIcon;
 	unsigned int m_initThreads;
 	unsigned int m_runningThreads;
+	unsigned int m_targetThreads;
+	unsigned int m_minimumThreads;
+	bool m_adaptiveThreads;
+	double m_diskLoad;
+	double m_ramUsage;
+	QScopedPointer<QElapsedTimer> m_lastAdjustment;
 	unsigned int m_currentFile;
-	QList<QUuid> m_allJobs;
+	QMap<quint32, QUuid> m_allJobs;
+	QMap<quint32, AlbumGainTask*> m_albumGainTasks;
+	QMap<quint32, album_gain_t> m_albumGain;
+	unsigned int m_albumGainDone;
+	QAtomicInt m_albumGainAbort;
+	bool m_albumGainInline;
+	QMap<QUuid, QString> m_albumKeys;
+	QMap<QUuid, ProcessThread::loudness_t> m_measuredLoudness;
 	QList<QUuid> m_succeededJobs;
 	QList<QUuid> m_failedJobs;
 	QList<QUuid> m_skippedJobs;
@@ -154,5 +211,7 @@ private:
 
 	static bool isFastSeekingDevice(const QString &path);
 	static quint32 cores2instances(const quint32 &cores);
+	static quint64 estimateJobCost(const AudioFileModel &audioFile);
+	static bool compareJobCost(const job_cost_t &job1, const job_cost_t &job2);
 	static QString time2text(const qint64 &msec);
 };
@@ -194,6 +194,7 @@ bool FDKAACEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaI
 	if(metaInfo.position())           args << L1S("--track")   << QString::number(metaInfo.position());
 
 	args << L1S("-o") << QDir::toNativeSeparators(outputFile);
+	if(IS_PIPE(sourceFile)) args << L1S("--ignorelength");
 	args << QDir::toNativeSeparators(sourceFile);
 
 	if(!startProcess(process, m_binary, args, QFileInfo(outputFile).canonicalPath()))
@@ -225,6 +226,11 @@ bool FDKAACEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaI
 	return (result == RESULT_SUCCESS);
 }
 
+const bool FDKAACEncoder::supportsPipeInput(void)
+{
+	return true;
+}
+
 bool FDKAACEncoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	if(containerType.compare(L1S("Wave"), Qt::CaseInsensitive) == 0)
@@ -215,6 +215,7 @@ bool QAACEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaInf
 
 	args << L1S("-d") << L1S(".");
 	args << L1S("-o") << QDir::toNativeSeparators(outputFile);
+	if(IS_PIPE(sourceFile)) args << L1S("--ignorelength");
 	args << QDir::toNativeSeparators(sourceFile);
 
 	if(!startProcess(process, qaac_bin, args, QFileInfo(outputFile).canonicalPath()))
@@ -246,6 +247,11 @@ bool QAACEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaInf
 	return (result == RESULT_SUCCESS);
 }
 
+const bool QAACEncoder::supportsPipeInput(void)
+{
+	return true;
+}
+
 bool QAACEncoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	if(containerType.compare(L1S("Wave"), Qt::CaseInsensitive) == 0)
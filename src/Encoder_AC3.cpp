@@ -181,6 +181,7 @@ bool AC3Encoder::encode(const QString &sourceFile, const AudioFileModel_MetaInfo
 
 	if(!m_configCustomParams.isEmpty()) args << m_configCustomParams.split(" ", QString::SkipEmptyParts);
 
+	if(IS_PIPE(sourceFile)) args << L1S("-readtoeof") << QString::number(1);
 	args << QDir::toNativeSeparators(sourceFile);
 	args << QDir::toNativeSeparators(outputFile);
 
@@ -245,6 +246,11 @@ const unsigned int *AC3Encoder::supportedSamplerates(void)
 	return supportedRates;
 }
 
+const bool AC3Encoder::supportsPipeInput(void)
+{
+	return true;
+}
+
 bool AC3Encoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	if(containerType.compare(L1S("Wave"), Qt::CaseInsensitive) == 0)
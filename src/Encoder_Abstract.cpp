@@ -28,12 +28,18 @@
 //MUtils
 #include <MUtils/Global.h>
 
+//Qt
+#include <QStringList>
+
 AbstractEncoder::AbstractEncoder(void)
 {
 	m_configBitrate = 0;
 	m_configRCMode = 0;
 	m_configCustomParams.clear();
 	m_configSamplingRate = 0;
+	m_temporarySource = false;
+	m_replayGain = false;
+	m_trackGain = m_trackPeak = m_albumGain = m_albumPeak = 0.0;
 }
 
 AbstractEncoder::~AbstractEncoder(void)
@@ -79,6 +85,20 @@ void AbstractEncoder::setSamplingRate(const int &value)
 	m_configSamplingRate = qBound(0, value, 48000);
 };
 
+void AbstractEncoder::setTemporarySource(const bool &temporary)
+{
+	m_temporarySource = temporary;
+}
+
+void AbstractEncoder::setReplayGain(const double &trackGain, const double &trackPeak, const double &albumGain, const double &albumPeak)
+{
+	m_replayGain = true;
+	m_trackGain = trackGain;
+	m_trackPeak = trackPeak;
+	m_albumGain = albumGain;
+	m_albumPeak = albumPeak;
+}
+
 
 /*
  * Default implementation
@@ -108,6 +128,24 @@ const bool AbstractEncoder::needsTimingInfo(void)
 	return false;
 }
 
+//Can the encoder read a WAV stream (of unknown length) from the standard input?
+const bool AbstractEncoder::supportsPipeInput(void)
+{
+	return false;
+}
+
+//Can the ReplayGain tags be written to a file that has already been encoded?
+const bool AbstractEncoder::supportsReplayGainUpdate(void)
+{
+	return false;
+}
+
+//Write the ReplayGain information, as set by setReplayGain(), to a file that has already been encoded
+bool AbstractEncoder::updateReplayGain(const QString& /*outputFile*/)
+{
+	return false;
+}
+
 
 /*
  * Helper functions
@@ -133,3 +171,17 @@ QString AbstractEncoder::cleanTag(const QString &text)
 	result.replace(QChar('|'),  "/");
 	return result;
 }
+
+//ReplayGain tags, in the "NAME=value" form of Vorbis comments
+QStringList AbstractEncoder::replayGainTags(void) const
+{
+	QStringList tags;
+	if(m_replayGain)
+	{
+		tags << QString().sprintf("REPLAYGAIN_TRACK_GAIN=%.2f dB", m_trackGain);
+		tags << QString().sprintf("REPLAYGAIN_TRACK_PEAK=%.6f", m_trackPeak);
+		tags << QString().sprintf("REPLAYGAIN_ALBUM_GAIN=%.2f dB", m_albumGain);
+		tags << QString().sprintf("REPLAYGAIN_ALBUM_PEAK=%.6f", m_albumPeak);
+	}
+	return tags;
+}
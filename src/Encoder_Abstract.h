@@ -68,16 +68,21 @@ public:
 	//Internal encoder API
 	virtual bool encode(const QString &sourceFile, const AudioFileModel_MetaInfo &metaInfo, const unsigned int duration, const unsigned int channels, const QString &outputFile, QAtomicInt &abortFlag) = 0;
 	virtual bool isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion) = 0;
+	virtual bool updateReplayGain(const QString &outputFile);
 	virtual const unsigned int *supportedSamplerates(void);
 	virtual const unsigned int *supportedChannelCount(void);
 	virtual const unsigned int *supportedBitdepths(void);
 	virtual const bool needsTimingInfo(void);
+	virtual const bool supportsPipeInput(void);
+	virtual const bool supportsReplayGainUpdate(void);
 
 	//Common setter methods
 	virtual void setBitrate(const int &bitrate);
 	virtual void setRCMode(const int &mode);
 	virtual void setSamplingRate(const int &value);
 	virtual void setCustomParams(const QString &customParams);
+	virtual void setTemporarySource(const bool &temporary);
+	virtual void setReplayGain(const double &trackGain, const double &trackPeak, const double &albumGain, const double &albumPeak);
 
 	//Encoder info
 	virtual const AbstractEncoderInfo *toEncoderInfo(void) const = 0;
@@ -92,8 +97,15 @@ protected:
 	int m_configRCMode;				//Rate-control mode
 	int m_configSamplingRate;		//Target sampling rate
 	QString m_configCustomParams;	//Custom parameters, if any
+	bool m_temporarySource;			//Source is a temporary file that may be consumed
+	bool m_replayGain;				//ReplayGain information is available
+	double m_trackGain;				//ReplayGain of the track, in dB
+	double m_trackPeak;				//Peak of the track, linear
+	double m_albumGain;				//ReplayGain of the album, in dB
+	double m_albumPeak;				//Peak of the album, linear
 
 	//Helper functions
 	bool isUnicode(const QString &text);
 	QString cleanTag(const QString &text);
+	QStringList replayGainTags(void) const;
 };
@@ -25,8 +25,48 @@
 #include "Global.h"
 #include "Model_Settings.h"
 
+#include <MUtils/Global.h>
+
 #include <QProcess>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <FLAC/metadata.h>
+
+#include <stdio.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// File I/O for libFLAC
+///////////////////////////////////////////////////////////////////////////////
+
+//The files are opened by us, so that Unicode file names work with every version of libFLAC
+static size_t flacRead(void *ptr, size_t size, size_t nmemb, FLAC__IOHandle handle)
+{
+	return fread(ptr, size, nmemb, static_cast<FILE*>(handle));
+}
+
+static size_t flacWrite(const void *ptr, size_t size, size_t nmemb, FLAC__IOHandle handle)
+{
+	return fwrite(ptr, size, nmemb, static_cast<FILE*>(handle));
+}
+
+static int flacSeek(FLAC__IOHandle handle, FLAC__int64 offset, int whence)
+{
+	return _fseeki64(static_cast<FILE*>(handle), offset, whence);
+}
+
+static FLAC__int64 flacTell(FLAC__IOHandle handle)
+{
+	return _ftelli64(static_cast<FILE*>(handle));
+}
+
+static int flacEof(FLAC__IOHandle handle)
+{
+	return feof(static_cast<FILE*>(handle));
+}
+
+static const FLAC__IOCallbacks FLAC_FILE_CALLBACKS = { flacRead, flacWrite, flacSeek, flacTell, flacEof, NULL };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Encoder Info
@@ -152,11 +192,18 @@ bool FLACEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaInf
 	if(metaInfo.position())           args << L1S("-T") << QString("track=%1").arg(QString::number(metaInfo.position()));
 	if(!metaInfo.cover().isEmpty())   args << QString("--picture=%1").arg(metaInfo.cover());
 
+	const QStringList replayGain = replayGainTags();
+	for(QStringList::ConstIterator iter = replayGain.constBegin(); iter != replayGain.constEnd(); iter++)
+	{
+		args << L1S("-T") << (*iter);
+	}
+
 	//args << "--tv" << QString().sprintf("Encoder=LameXP v%d.%02d.%04d [%s]", lamexp_version_major(), lamexp_version_minor(), lamexp_version_build(), lamexp_version_release());
 
 	if(!m_configCustomParams.isEmpty()) args << m_configCustomParams.split(" ", QString::SkipEmptyParts);
 
 	args << L1S("-f") << L1S("-o") << QDir::toNativeSeparators(outputFile);
+	if(IS_PIPE(sourceFile)) args << L1S("--ignore-chunk-sizes");
 	args << QDir::toNativeSeparators(sourceFile);
 
 	if(!startProcess(process, m_binary, args))
@@ -188,6 +235,82 @@ bool FLACEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaInf
 	return (result == RESULT_SUCCESS);
 }
 
+/*
+ * Replace the ReplayGain comments of a file that has already been encoded. The padding, which is reserved by
+ * the encoder, is normally large enough for the comments, so only the metadata blocks have to be rewritten.
+ */
+bool FLACEncoder::updateReplayGain(const QString &outputFile)
+{
+	const QStringList tags = replayGainTags();
+	if(tags.isEmpty())
+	{
+		return false;
+	}
+
+	FILE *const file = _wfopen(MUTILS_WCHR(QDir::toNativeSeparators(outputFile)), L"r+b");
+	if(!file)
+	{
+		qWarning("Failed to open FLAC file for writing: <%s>", MUTILS_UTF8(outputFile));
+		return false;
+	}
+
+	FLAC__Metadata_Chain *const chain = FLAC__metadata_chain_new();
+	bool success = chain && FLAC__metadata_chain_read_with_callbacks(chain, file, FLAC_FILE_CALLBACKS) && setComments(chain, tags);
+
+	if(success)
+	{
+		FLAC__metadata_chain_sort_padding(chain);
+		if(!FLAC__metadata_chain_check_if_tempfile_needed(chain, true))
+		{
+			success = FLAC__metadata_chain_write_with_callbacks(chain, true, file, FLAC_FILE_CALLBACKS);
+			fclose(file);
+		}
+		else
+		{
+			//The metadata has outgrown the padding, so the whole file needs to be written once more
+			const QString tempFile = MUtils::make_temp_file(QFileInfo(outputFile).absolutePath(), "tmp", true);
+			FILE *const temp = tempFile.isEmpty() ? NULL : _wfopen(MUTILS_WCHR(QDir::toNativeSeparators(tempFile)), L"w+b");
+			success = temp && FLAC__metadata_chain_write_with_callbacks_and_tempfile(chain, true, file, FLAC_FILE_CALLBACKS, temp, FLAC_FILE_CALLBACKS);
+			fclose(file);
+			if(temp)
+			{
+				fclose(temp);
+			}
+			success = success && QFile::remove(outputFile) && QFile::rename(tempFile, outputFile);
+			if((!success) && (!tempFile.isEmpty()))
+			{
+				QFile::remove(tempFile);
+			}
+		}
+	}
+	else
+	{
+		fclose(file);
+	}
+
+	if(chain)
+	{
+		FLAC__metadata_chain_delete(chain);
+	}
+
+	if(!success)
+	{
+		qWarning("Failed to write the ReplayGain comments: <%s>", MUTILS_UTF8(outputFile));
+	}
+
+	return success;
+}
+
+const bool FLACEncoder::supportsPipeInput(void)
+{
+	return true;
+}
+
+const bool FLACEncoder::supportsReplayGainUpdate(void)
+{
+	return true;
+}
+
 bool FLACEncoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	if(containerType.compare(L1S("Wave"), Qt::CaseInsensitive) == 0)
@@ -217,3 +340,64 @@ const AbstractEncoderInfo *FLACEncoder::getEncoderInfo(void)
 {
 	return &g_flacEncoderInfo;
 }
+
+/*
+ * Replace the comments of the "VORBIS_COMMENT" block with the given "NAME=value" pairs, the block is created if there is none
+ */
+bool FLACEncoder::setComments(FLAC__Metadata_Chain *const chain, const QStringList &comments)
+{
+	FLAC__Metadata_Iterator *const iterator = FLAC__metadata_iterator_new();
+	if(!iterator)
+	{
+		return false;
+	}
+
+	FLAC__StreamMetadata *block = NULL;
+	FLAC__metadata_iterator_init(iterator, chain);
+	do
+	{
+		if(FLAC__metadata_iterator_get_block_type(iterator) == FLAC__METADATA_TYPE_VORBIS_COMMENT)
+		{
+			block = FLAC__metadata_iterator_get_block(iterator);
+			break;
+		}
+	}
+	while(FLAC__metadata_iterator_next(iterator));
+
+	if(!block)
+	{
+		//The first block always is the "STREAMINFO" block
+		FLAC__metadata_iterator_init(iterator, chain);
+		if((block = FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT)) && (!FLAC__metadata_iterator_insert_block_after(iterator, block)))
+		{
+			FLAC__metadata_object_delete(block);
+			block = NULL;
+		}
+	}
+
+	FLAC__metadata_iterator_delete(iterator);
+
+	if(!block)
+	{
+		return false;
+	}
+
+	for(QStringList::ConstIterator iter = comments.constBegin(); iter != comments.constEnd(); iter++)
+	{
+		const QByteArray comment = iter->toUtf8();
+		FLAC__StreamMetadata_VorbisComment_Entry entry;
+		entry.length = static_cast<FLAC__uint32>(comment.size());
+		entry.entry = reinterpret_cast<FLAC__byte*>(const_cast<char*>(comment.constData()));
+
+		if(FLAC__metadata_object_vorbiscomment_remove_entries_matching(block, iter->section(QLatin1Char('='), 0, 0).toLatin1().constData()) < 0)
+		{
+			return false;
+		}
+		if(!FLAC__metadata_object_vorbiscomment_append_comment(block, entry, true))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -26,6 +26,8 @@
 
 #include <QObject>
 
+struct FLAC__Metadata_Chain;
+
 class FLACEncoder : public AbstractEncoder
 {
 	Q_OBJECT
@@ -36,6 +38,9 @@ public:
 
 	virtual bool encode(const QString &sourceFile, const AudioFileModel_MetaInfo &metaInfo, const unsigned int duration, const unsigned int channels, const QString &outputFile, QAtomicInt &abortFlag);
 	virtual bool isFormatSupported(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion);
+	virtual bool updateReplayGain(const QString &outputFile);
+	virtual const bool supportsPipeInput(void);
+	virtual const bool supportsReplayGainUpdate(void);
 	virtual const unsigned int *supportedChannelCount(void);
 	virtual const unsigned int *supportedBitdepths(void);
 
@@ -44,5 +49,7 @@ public:
 	static const AbstractEncoderInfo *getEncoderInfo(void);
 
 private:
+	static bool setComments(FLAC__Metadata_Chain *const chain, const QStringList &comments);
+
 	const QString m_binary;
 };
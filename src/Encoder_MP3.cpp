@@ -234,8 +234,15 @@ bool MP3Encoder::encode(const QString &sourceFile, const AudioFileModel_MetaInfo
 	if(metaInfo.position())           args << L1S("--tn") << QString::number(metaInfo.position());
 	if(!metaInfo.cover().isEmpty())   args << L1S("--ti") << QDir::toNativeSeparators(metaInfo.cover());
 
+	const QStringList replayGain = replayGainTags();
+	for(QStringList::ConstIterator iter = replayGain.constBegin(); iter != replayGain.constEnd(); iter++)
+	{
+		args << L1S("--tv") << QString("TXXX=%1").arg(*iter);
+	}
+
 	if(!m_configCustomParams.isEmpty()) args << m_configCustomParams.split(" ", QString::SkipEmptyParts);
 
+	if(IS_PIPE(sourceFile)) args << L1S("--ignorelength");
 	args << QDir::toNativeSeparators(sourceFile);
 	args << QDir::toNativeSeparators(outputFile);
 
@@ -268,6 +275,11 @@ bool MP3Encoder::encode(const QString &sourceFile, const AudioFileModel_MetaInfo
 	return (result == RESULT_SUCCESS);
 }
 
+const bool MP3Encoder::supportsPipeInput(void)
+{
+	return true;
+}
+
 bool MP3Encoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString &formatProfile, const QString &formatVersion)
 {
 	if(containerType.compare(L1S("Wave"), Qt::CaseInsensitive) == 0)
@@ -198,8 +198,16 @@ bool OpusEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaInf
 	if(!metaInfo.comment().isEmpty()) args << L1S("--comment") << QString("comment=%1").arg(cleanTag(metaInfo.comment()));
 	if(!metaInfo.cover().isEmpty())   args << L1S("--picture") << makeCoverParam(metaInfo.cover());
 
+	//Opus uses R128 tags, in Q7.8 fixed point and relative to -23 LUFS (RFC 7845)
+	if(m_replayGain)
+	{
+		args << L1S("--comment") << QString("R128_TRACK_GAIN=%1").arg(QString::number(qBound(-32768, qRound((m_trackGain - 5.0) * 256.0), 32767)));
+		args << L1S("--comment") << QString("R128_ALBUM_GAIN=%1").arg(QString::number(qBound(-32768, qRound((m_albumGain - 5.0) * 256.0), 32767)));
+	}
+
 	if(!m_configCustomParams.isEmpty()) args << m_configCustomParams.split(" ", QString::SkipEmptyParts);
 
+	if(IS_PIPE(sourceFile)) args << L1S("--ignorelength");
 	args << QDir::toNativeSeparators(sourceFile);
 	args << QDir::toNativeSeparators(outputFile);
 
@@ -270,6 +278,11 @@ void OpusEncoder::setFrameSize(int frameSize)
 	m_configFrameSize = qBound(0, frameSize, 5);
 }
 
+const bool OpusEncoder::supportsPipeInput(void)
+{
+	return true;
+}
+
 bool OpusEncoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	if(containerType.compare(L1S("Wave"), Qt::CaseInsensitive) == 0)
@@ -183,12 +183,19 @@ bool VorbisEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaI
 	if(!metaInfo.comment().isEmpty()) args << L1S("-c") << QString("comment=%1").arg(cleanTag(metaInfo.comment()));
 	if(metaInfo.year())               args << L1S("-d") << QString::number(metaInfo.year());
 	if(metaInfo.position())           args << L1S("-N") << QString::number(metaInfo.position());
+
+	const QStringList replayGain = replayGainTags();
+	for(QStringList::ConstIterator iter = replayGain.constBegin(); iter != replayGain.constEnd(); iter++)
+	{
+		args << L1S("-c") << (*iter);
+	}
 	
 	//args << "--tv" << QString().sprintf("Encoder=LameXP v%d.%02d.%04d [%s]", lamexp_version_major(), lamexp_version_minor(), lamexp_version_build(), lamexp_version_release());
 
 	if(!m_configCustomParams.isEmpty()) args << m_configCustomParams.split(" ", QString::SkipEmptyParts);
 
 	args << L1S("-o") << QDir::toNativeSeparators(outputFile);
+	if(IS_PIPE(sourceFile)) args << L1S("--ignorelength");
 	args << QDir::toNativeSeparators(sourceFile);
 
 	if(!startProcess(process, m_binary, args))
@@ -220,6 +227,11 @@ bool VorbisEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaI
 	return (result == RESULT_SUCCESS);
 }
 
+const bool VorbisEncoder::supportsPipeInput(void)
+{
+	return true;
+}
+
 bool VorbisEncoder::isFormatSupported(const QString &containerType, const QString& /*containerProfile*/, const QString &formatType, const QString& /*formatProfile*/, const QString& /*formatVersion*/)
 {
 	if(containerType.compare(L1S("Wave"), Qt::CaseInsensitive) == 0)
@@ -28,6 +28,13 @@
 #include "Global.h"
 #include "Model_Settings.h"
 
+#include <QDir>
+
+//Windows includes
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
 typedef struct _callback_t
 {
 	WaveEncoder *const pInstance;
@@ -134,6 +141,19 @@ WaveEncoder::~WaveEncoder(void)
 
 bool WaveEncoder::encode(const QString &sourceFile, const AudioFileModel_MetaInfo& /*metaInfo*/, const unsigned int /*duration*/, const unsigned int /*channels*/, const QString &outputFile, QAtomicInt &abortFlag)
 {
+	//Temporary files can simply be moved to the output, as long as both are located on the same volume
+	if (m_temporarySource)
+	{
+		emit messageLogged(QString("Move file \"%1\" to \"%2\"\n").arg(sourceFile, outputFile));
+		if (MoveFileExW(MUTILS_WCHR(QDir::toNativeSeparators(sourceFile)), MUTILS_WCHR(QDir::toNativeSeparators(outputFile)), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		{
+			emit statusUpdated(100);
+			emit messageLogged(L1S("File moved successfully."));
+			return true;
+		}
+		emit messageLogged(L1S("Unable to move the file (different volume?), falling back to copy.\n"));
+	}
+
 	emit messageLogged(QString("Copy file \"%1\" to \"%2\"\n").arg(sourceFile, outputFile));
 
 	callback_t callbackData = { this, &abortFlag };
@@ -22,10 +22,226 @@
 
 #include "Filter_Abstract.h"
 
+//Internal
+#include "Global.h"
+#include "Model_AudioFile.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QDir>
+#include <QProcess>
+#include <QRegExp>
+
+#define INIT_CHAIN(X) do { (X).guard = (X).twoPass = false; } while(0)
+
 AbstractFilter::AbstractFilter(void)
+:
+	m_soxBinary(lamexp_tools_lookup("sox.exe"))
 {
 }
 
 AbstractFilter::~AbstractFilter(void)
 {
+	while(!m_fusedFilters.isEmpty())
+	{
+		delete m_fusedFilters.takeFirst();
+	}
+}
+
+/*
+ * Default implementation, runs the SoX effects chain of this filter (and all fused filters)
+ */
+
+AbstractFilter::FilterResult AbstractFilter::apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag)
+{
+	AudioFileModel_TechInfo outputInfo(*formatInfo);
+	effectsChain_t chain;
+	INIT_CHAIN(chain);
+
+	const FilterResult chainResult = buildEffectsChain(&outputInfo, chain);
+	if(chainResult != AbstractFilter::FILTER_SUCCESS)
+	{
+		if(chainResult == AbstractFilter::FILTER_FAILURE)
+		{
+			qWarning("AbstractFilter: Filter does not provide any SoX effects!");
+		}
+		return chainResult;
+	}
+
+	QProcess process;
+	const QStringList args = makeSoxArgs(sourceFile, outputFile, chain);
+
+	if(!startProcess(process, m_soxBinary, args, QFileInfo(outputFile).canonicalPath()))
+	{
+		return AbstractFilter::FILTER_FAILURE;
+	}
+
+	int prevProgress = -1;
+	QRegExp regExp("In:(\\d+)(\\.\\d+)*%");
+
+	const result_t result = awaitProcess(process, abortFlag, [this, &prevProgress, &regExp](const QString &text)
+	{
+		if (regExp.lastIndexIn(text) >= 0)
+		{
+			qint32 newProgress;
+			if (MUtils::regexp_parse_int32(regExp, newProgress))
+			{
+				if (newProgress > prevProgress)
+				{
+					emit statusUpdated(newProgress);
+					prevProgress = NEXT_PROGRESS(newProgress);
+				}
+			}
+			return true;
+		}
+		return false;
+	});
+
+	if (result != RESULT_SUCCESS)
+	{
+		return AbstractFilter::FILTER_FAILURE;
+	}
+
+	*formatInfo = outputInfo;
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+AbstractFilter::FilterResult AbstractFilter::createPipelineStage(const QString &sourceFile, AudioFileModel_TechInfo *const formatInfo, QString &program, QStringList &args)
+{
+	AudioFileModel_TechInfo outputInfo(*formatInfo);
+	effectsChain_t chain;
+	INIT_CHAIN(chain);
+
+	const FilterResult chainResult = buildEffectsChain(&outputInfo, chain);
+	if(chainResult != AbstractFilter::FILTER_SUCCESS)
+	{
+		return chainResult;
+	}
+
+	if(chain.twoPass)
+	{
+		return AbstractFilter::FILTER_FAILURE; /*filter can not be streamed*/
+	}
+
+	program = m_soxBinary;
+	args = makeSoxArgs(sourceFile, PIPE_NAME(), chain);
+
+	*formatInfo = outputInfo;
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+AbstractFilter::FilterResult AbstractFilter::appendEffects(AudioFileModel_TechInfo *const /*formatInfo*/, effectsChain_t& /*chain*/)
+{
+	return AbstractFilter::FILTER_FAILURE; /*filter has no SoX effects*/
+}
+
+bool AbstractFilter::isComposable(void) const
+{
+	return false;
+}
+
+bool AbstractFilter::hasNativeStage(const AudioFileModel_TechInfo* /*formatInfo*/) const
+{
+	return false;
+}
+
+AbstractFilter::FilterResult AbstractFilter::createNativeStage(AudioFileModel_TechInfo *const /*formatInfo*/, StreamProcessor *&processor)
+{
+	processor = NULL;
+	return AbstractFilter::FILTER_FAILURE; /*filter has no native implementation*/
+}
+
+bool AbstractFilter::needsAnalysis(void) const
+{
+	return false;
+}
+
+AbstractFilter::FilterResult AbstractFilter::analyzeInput(const QString& /*sourceFile*/, AudioFileModel_TechInfo *const /*formatInfo*/, QAtomicInt& /*abortFlag*/)
+{
+	return AbstractFilter::FILTER_SUCCESS; /*nothing to analyze*/
+}
+
+/*
+ * Append the next filter to the effects chain of this filter, takes ownership on success
+ */
+
+bool AbstractFilter::fuse(AbstractFilter *const next)
+{
+	if(next && (next != this) && isComposable() && next->isComposable() && next->m_fusedFilters.isEmpty())
+	{
+		connect(next, SIGNAL(messageLogged(QString)), this, SIGNAL(messageLogged(QString)), Qt::DirectConnection);
+		m_fusedFilters << next;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Collect the SoX effects of this filter and of all fused filters, in order
+ */
+
+AbstractFilter::FilterResult AbstractFilter::buildEffectsChain(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain)
+{
+	FilterResult result = appendEffects(formatInfo, chain);
+
+	for(QList<AbstractFilter*>::ConstIterator iter = m_fusedFilters.constBegin(); (iter != m_fusedFilters.constEnd()) && (result != AbstractFilter::FILTER_FAILURE); iter++)
+	{
+		const FilterResult fusedResult = (*iter)->appendEffects(formatInfo, chain);
+		if(fusedResult != AbstractFilter::FILTER_SKIPPED)
+		{
+			result = fusedResult;
+		}
+	}
+
+	return result;
+}
+
+/*
+ * SoX file arguments, a pipe is always a WAV stream whose header length can not be trusted
+ */
+
+QStringList AbstractFilter::soxFileArgs(const QString &fileName, const bool &isInput)
+{
+	QStringList args;
+
+	if(IS_PIPE(fileName))
+	{
+		if(isInput)
+		{
+			args << "--ignore-length";
+		}
+		args << "-t" << "wav" << PIPE_NAME();
+	}
+	else
+	{
+		args << QDir::toNativeSeparators(fileName);
+	}
+
+	return args;
+}
+
+/*
+ * Complete SoX command-line
+ */
+
+QStringList AbstractFilter::makeSoxArgs(const QString &sourceFile, const QString &outputFile, const effectsChain_t &chain)
+{
+	QStringList args;
+
+	args << "-V3" << "-S";
+	if(chain.guard)
+	{
+		args << "--guard";
+	}
+	args << "--temp" << ".";
+
+	args << soxFileArgs(sourceFile, true);
+	args << chain.outputOptions;
+	args << soxFileArgs(outputFile, false);
+	args << chain.effects;
+
+	return args;
 }
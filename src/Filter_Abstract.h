@@ -19,12 +19,15 @@
 //
 // http://www.gnu.org/licenses/gpl-2.0.txt
 ///////////////////////////////////////////////////////////////////////////////
-
 #pragma once
 
 #include "Tool_Abstract.h"
 
+#include <QList>
+#include <QStringList>
+
 class AudioFileModel_TechInfo;
+class StreamProcessor;
 
 class AbstractFilter : public AbstractTool
 {
@@ -42,7 +45,43 @@ public:
 		FILTER_FAILURE = 2
 	};
 
+	//SoX effects chain
+	typedef struct
+	{
+		QStringList effects;		//Effect arguments, e.g. "rate -v 44100"
+		QStringList outputOptions;	//Output format options, e.g. "-b 16"
+		bool guard;					//Guard against clipping
+		bool twoPass;				//Needs the complete input before it can produce any output
+	}
+	effectsChain_t;
+
 	//Internal decoder API
-	virtual FilterResult apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag) = 0;
-};
+	virtual FilterResult apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag);
+
+	//Streaming API, returns FILTER_FAILURE if the filter can not be run as a pipeline stage
+	virtual FilterResult createPipelineStage(const QString &sourceFile, AudioFileModel_TechInfo *const formatInfo, QString &program, QStringList &args);
+
+	//Composition API, returns FILTER_FAILURE if the filter can not be expressed as SoX effects
+	virtual FilterResult appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain);
+	virtual bool isComposable(void) const;
+	bool fuse(AbstractFilter *const next);
 
+	//Native API, returns FILTER_FAILURE if the filter has no in-process implementation (for the given format)
+	virtual bool hasNativeStage(const AudioFileModel_TechInfo *const formatInfo) const;
+	virtual FilterResult createNativeStage(AudioFileModel_TechInfo *const formatInfo, StreamProcessor *&processor);
+
+	//Analysis API, filters that need to see the complete input before the native stage can be created
+	virtual bool needsAnalysis(void) const;
+	virtual FilterResult analyzeInput(const QString &sourceFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag);
+
+protected:
+	static QStringList soxFileArgs(const QString &fileName, const bool &isInput);
+
+	const QString m_soxBinary;
+
+private:
+	FilterResult buildEffectsChain(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain);
+	static QStringList makeSoxArgs(const QString &sourceFile, const QString &outputFile, const effectsChain_t &chain);
+
+	QList<AbstractFilter*> m_fusedFilters;
+};
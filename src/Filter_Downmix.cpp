@@ -24,24 +24,184 @@
 
 //Internal
 #include "Global.h"
-#include "Tool_WaveProperties.h"
 #include "Model_AudioFile.h"
+#include "Filter_Native.h"
 
 //MUtils
 #include <MUtils/Exception.h>
+#include <MUtils/CPUFeatures.h>
 
 //Qt
-#include <QDir>
-#include <QProcess>
-#include <QRegExp>
+#include <QStringList>
+
+//CRT
+#include <string.h>
+#include <immintrin.h>
 
 #define IS_VALID(X) (((X) != 0U) && ((X) != UINT_MAX))
 
+#define MIN_CHANNELS 3
+#define MAX_CHANNELS 9
+
+//Downmix coefficients for the left and the right output channel, used by the SoX and the native implementation
+static const float DOWNMIX_MATRIX[MAX_CHANNELS - MIN_CHANNELS + 1][2][MAX_CHANNELS] =
+{
+	//3.0 (L/R/C)
+	{ { 0.66f, 0.00f, 0.34f }, { 0.00f, 0.66f, 0.34f } },
+	//3.1 (L/R/C/LFE)
+	{ { 0.50f, 0.00f, 0.25f, 0.25f }, { 0.00f, 0.50f, 0.25f, 0.25f } },
+	//5.0 (L/R/C/BL/BR)
+	{ { 0.50f, 0.00f, 0.25f, 0.25f, 0.00f }, { 0.00f, 0.50f, 0.25f, 0.00f, 0.25f } },
+	//5.1 (L/R/C/LFE/BL/BR)
+	{ { 0.40f, 0.00f, 0.20f, 0.20f, 0.20f, 0.00f }, { 0.00f, 0.40f, 0.20f, 0.20f, 0.00f, 0.20f } },
+	//7.0 (L/R/C/BL/BR/SL/SR)
+	{ { 0.40f, 0.00f, 0.20f, 0.20f, 0.00f, 0.20f, 0.00f }, { 0.00f, 0.40f, 0.20f, 0.00f, 0.20f, 0.00f, 0.20f } },
+	//7.1 (L/R/C/LFE/BL/BR/SL/SR)
+	{ { 0.36f, 0.00f, 0.16f, 0.16f, 0.16f, 0.00f, 0.16f, 0.00f }, { 0.00f, 0.36f, 0.16f, 0.16f, 0.00f, 0.16f, 0.00f, 0.16f } },
+	//8.1 (L/R/C/LFE/BL/BR/SL/SR/BC)
+	{ { 0.308f, 0.000f, 0.154f, 0.154f, 0.154f, 0.000f, 0.154f, 0.000f, 0.076f }, { 0.000f, 0.308f, 0.154f, 0.154f, 0.000f, 0.154f, 0.000f, 0.154f, 0.076f } }
+};
+
+static QString makeRemixSpec(const float *const coeffs, const unsigned int channels)
+{
+	QStringList spec;
+	for(unsigned int c = 0; c < channels; c++)
+	{
+		if(coeffs[c] > 0.0f)
+		{
+			spec << QString("%1v%2").arg(QString::number(c + 1), QString::number(coeffs[c]));
+		}
+	}
+	return spec.join(",");
+}
+
+static void downmixSSE(const float *const *const input, const int channels, const float *const coeffsL, const float *const coeffsR, float *const outL, float *const outR, const int frames, int &i)
+{
+	for(; i + 4 <= frames; i += 4)
+	{
+		__m128 l = _mm_setzero_ps(), r = _mm_setzero_ps();
+		for(int c = 0; c < channels; c++)
+		{
+			const __m128 x = _mm_loadu_ps(input[c] + i);
+			l = _mm_add_ps(l, _mm_mul_ps(x, _mm_set1_ps(coeffsL[c])));
+			r = _mm_add_ps(r, _mm_mul_ps(x, _mm_set1_ps(coeffsR[c])));
+		}
+		_mm_storeu_ps(outL + i, l);
+		_mm_storeu_ps(outR + i, r);
+	}
+}
+
+static void downmixAVX(const float *const *const input, const int channels, const float *const coeffsL, const float *const coeffsR, float *const outL, float *const outR, const int frames, int &i)
+{
+	for(; i + 8 <= frames; i += 8)
+	{
+		__m256 l = _mm256_setzero_ps(), r = _mm256_setzero_ps();
+		for(int c = 0; c < channels; c++)
+		{
+			const __m256 x = _mm256_loadu_ps(input[c] + i);
+			l = _mm256_add_ps(l, _mm256_mul_ps(x, _mm256_set1_ps(coeffsL[c])));
+			r = _mm256_add_ps(r, _mm256_mul_ps(x, _mm256_set1_ps(coeffsR[c])));
+		}
+		_mm256_storeu_ps(outL + i, l);
+		_mm256_storeu_ps(outR + i, r);
+	}
+	_mm256_zeroupper();
+}
+
+class DownmixProcessor : public NativeProcessor
+{
+public:
+	DownmixProcessor(void)
+	:
+		m_channels(0)
+	{
+		const MUtils::CPUFetaures::cpu_info_t cpuFeatures = MUtils::CPUFetaures::detect();
+		m_useSSE = ((cpuFeatures.features & MUtils::CPUFetaures::FLAG_SSE) != 0);
+		m_useAVX = ((cpuFeatures.features & MUtils::CPUFetaures::FLAG_AVX) != 0);
+	}
+
+protected:
+	virtual bool configure(const format_t &input, format_t &output)
+	{
+		m_channels = input.channels;
+		if(m_channels <= 2)
+		{
+			return true; /*nothing to do*/
+		}
+
+		m_coeffsL.fill(0.0f, m_channels);
+		m_coeffsR.fill(0.0f, m_channels);
+		m_input.resize(m_channels);
+
+		//Unknown channel configurations are left to SoX, see DownmixFilter::hasNativeStage()
+		if(m_channels > MAX_CHANNELS)
+		{
+			qWarning("Downmixer: Unknown channel configuration!");
+			return false;
+		}
+
+		memcpy(m_coeffsL.data(), DOWNMIX_MATRIX[m_channels - MIN_CHANNELS][0], m_channels * sizeof(float));
+		memcpy(m_coeffsR.data(), DOWNMIX_MATRIX[m_channels - MIN_CHANNELS][1], m_channels * sizeof(float));
+
+		output.channels = 2;
+		output.channelMask = 0U;
+		return true;
+	}
+
+	virtual bool processBlock(block_t &block)
+	{
+		if(m_channels <= 2)
+		{
+			return true;
+		}
+
+		for(int c = 0; c < m_channels; c++)
+		{
+			m_input[c] = block[c].constData();
+		}
+
+		//The output overwrites the first two channels, each frame is read completely before it is written
+		float *const outL = block[0].data();
+		float *const outR = block[1].data();
+		const int frames = block[0].count();
+
+		int i = 0;
+		if(m_useAVX)
+		{
+			downmixAVX(m_input.constData(), m_channels, m_coeffsL.constData(), m_coeffsR.constData(), outL, outR, frames, i);
+		}
+		if(m_useSSE)
+		{
+			downmixSSE(m_input.constData(), m_channels, m_coeffsL.constData(), m_coeffsR.constData(), outL, outR, frames, i);
+		}
+		for(; i < frames; i++)
+		{
+			float l = 0.0f, r = 0.0f;
+			for(int c = 0; c < m_channels; c++)
+			{
+				l += m_coeffsL[c] * m_input[c][i];
+				r += m_coeffsR[c] * m_input[c][i];
+			}
+			outL[i] = l;
+			outR[i] = r;
+		}
+
+		block.resize(2);
+		return true;
+	}
+
+private:
+	bool m_useSSE;
+	bool m_useAVX;
+	int m_channels;
+	QVector<float> m_coeffsL;
+	QVector<float> m_coeffsR;
+	QVector<const float*> m_input;
+};
+
 DownmixFilter::DownmixFilter(void)
-:
-	m_binary(lamexp_tools_lookup("sox.exe"))
 {
-	if(m_binary.isEmpty())
+	if(m_soxBinary.isEmpty())
 	{
 		MUTILS_THROW("Error initializing SoX filter. Tool 'sox.exe' is not registred!");
 	}
@@ -51,7 +211,7 @@ DownmixFilter::~DownmixFilter(void)
 {
 }
 
-AbstractFilter::FilterResult DownmixFilter::apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag)
+AbstractFilter::FilterResult DownmixFilter::appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain)
 {
 	unsigned int channels = formatInfo->audioChannels();
 	emit messageLogged(QString().sprintf("--> Number of channels is: %d\n", channels));
@@ -63,74 +223,58 @@ AbstractFilter::FilterResult DownmixFilter::apply(const QString &sourceFile, con
 		return AbstractFilter::FILTER_SKIPPED;
 	}
 
-	QProcess process;
-	QStringList args;
-
-	args << "-V3" << "-S";
-	args << "--guard" << "--temp" << ".";
-	args << QDir::toNativeSeparators(sourceFile);
-	args << QDir::toNativeSeparators(outputFile);
-
-	switch(channels)
+	if((channels >= MIN_CHANNELS) && (channels <= MAX_CHANNELS))
 	{
-	case 3: //3.0 (L/R/C)
-		args << "remix" << "1v0.66,3v0.34" << "2v0.66,3v0.34";
-		break;
-	case 4: //3.1 (L/R/C/LFE)
-		args << "remix" << "1v0.5,3v0.25,4v0.25" << "2v0.5,3v0.25,4v0.25";
-		break;
-	case 5: //5.0 (L/R/C/BL/BR)
-		args << "remix" << "1v0.5,3v0.25,4v0.25" << "2v0.5,3v0.25,5v0.25";
-		break;
-	case 6: //5.1 (L/R/C/LFE/BL/BR)
-		args << "remix" << "1v0.4,3v0.2,4v0.2,5v0.2" << "2v0.4,3v0.2,4v0.2,6v0.2";
-		break;
-	case 7: //7.0 (L/R/C/BL/BR/SL/SR)
-		args << "remix" << "1v0.4,3v0.2,4v0.2,6v0.2" << "2v0.4,3v0.2,5v0.2,7v0.2";
-		break;
-	case 8: //7.1 (L/R/C/LFE/BL/BR/SL/SR)
-		args << "remix" << "1v0.36,3v0.16,4v0.16,5v0.16,7v0.16" << "2v0.36,3v0.16,4v0.16,6v0.16,8v0.16";
-		break;
-	case 9: //8.1 (L/R/C/LFE/BL/BR/SL/SR/BC)
-		args << "remix" << "1v0.308,3v0.154,4v0.154,5v0.154,7v0.154,9v0.076" << "2v0.308,3v0.154,4v0.154,6v0.154,8v0.154,9v0.076";
-		break;
-	default: //Unknown
-		qWarning("Downmixer: Unknown channel configuration!");
-		args << "channels" << QString::number(2);
-		break;
+		chain.effects << "remix" << makeRemixSpec(DOWNMIX_MATRIX[channels - MIN_CHANNELS][0], channels) << makeRemixSpec(DOWNMIX_MATRIX[channels - MIN_CHANNELS][1], channels);
 	}
-
-	if(!startProcess(process, m_binary, args, QFileInfo(outputFile).canonicalPath()))
+	else
 	{
-		return AbstractFilter::FILTER_FAILURE;
+		qWarning("Downmixer: Unknown channel configuration!");
+		chain.effects << "channels" << QString::number(2);
 	}
 
-	int prevProgress = -1;
-	QRegExp regExp("In:(\\d+)(\\.\\d+)*%");
+	chain.guard = true;
+	formatInfo->setAudioChannels(2);
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+bool DownmixFilter::isComposable(void) const
+{
+	return true;
+}
+
+/*
+ * Only the known channel layouts are mixed natively, any other layout is left to the "channels" effect of SoX.
+ * SoX also keeps the full precision of 32-Bit integer samples, which the native stage would reduce to 24-Bit.
+ */
+bool DownmixFilter::hasNativeStage(const AudioFileModel_TechInfo *const formatInfo) const
+{
+	const unsigned int channels = formatInfo->audioChannels();
+	return IS_VALID(channels) && (channels <= MAX_CHANNELS) && (formatInfo->audioBitdepth() != 32U);
+}
+
+AbstractFilter::FilterResult DownmixFilter::createNativeStage(AudioFileModel_TechInfo *const formatInfo, StreamProcessor *&processor)
+{
+	unsigned int channels = formatInfo->audioChannels();
+	emit messageLogged(QString().sprintf("--> Number of channels is: %d\n", channels));
 
-	const result_t result = awaitProcess(process, abortFlag, [this, &prevProgress, &regExp](const QString &text)
+	if(IS_VALID(channels) && (channels <= 2))
 	{
-		if (regExp.lastIndexIn(text) >= 0)
-		{
-			qint32 newProgress;
-			if (MUtils::regexp_parse_int32(regExp, newProgress))
-			{
-				if (newProgress > prevProgress)
-				{
-					emit statusUpdated(newProgress);
-					prevProgress = NEXT_PROGRESS(newProgress);
-				}
-			}
-			return true;
-		}
-		return false;
-	});
+		messageLogged("Skipping downmix!");
+		qDebug("Dowmmix not required/possible for Mono or Stereo input, skipping!");
+		processor = NULL;
+		return AbstractFilter::FILTER_SKIPPED;
+	}
 
-	if (result != RESULT_SUCCESS)
+	if(!hasNativeStage(formatInfo))
 	{
+		emit messageLogged("Channel layout or sample format is not supported natively, going to use SoX.");
+		processor = NULL;
 		return AbstractFilter::FILTER_FAILURE;
 	}
-	
+
+	emit messageLogged("Using the native downmix implementation.");
+	processor = new DownmixProcessor();
 	formatInfo->setAudioChannels(2);
 	return AbstractFilter::FILTER_SUCCESS;
 }
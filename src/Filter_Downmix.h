@@ -24,16 +24,15 @@
 
 #include "Filter_Abstract.h"
 
-class WaveProperties;
-
 class DownmixFilter : public AbstractFilter
 {
 public:
 	DownmixFilter(void);
 	~DownmixFilter(void);
 
-	virtual FilterResult apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag);
+	virtual FilterResult appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain);
+	virtual bool isComposable(void) const;
 
-private:
-	const QString m_binary;
+	virtual bool hasNativeStage(const AudioFileModel_TechInfo *const formatInfo) const;
+	virtual FilterResult createNativeStage(AudioFileModel_TechInfo *const formatInfo, StreamProcessor *&processor);
 };
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Filter_Gain.h"
+
+//Internal
+#include "Global.h"
+#include "Filter_Native.h"
+
+//MUtils
+#include <MUtils/Exception.h>
+
+//Qt
+#include <QStringList>
+
+//CRT
+#include <math.h>
+
+class GainProcessor : public NativeProcessor
+{
+public:
+	GainProcessor(const QVector<float> &gains)
+	:
+		m_gains(gains)
+	{
+	}
+
+protected:
+	virtual bool configure(const format_t &input, format_t& /*output*/)
+	{
+		if(m_gains.count() == 1)
+		{
+			m_gains.fill(m_gains.first(), input.channels);
+		}
+		if(static_cast<int>(input.channels) != m_gains.count())
+		{
+			qWarning("GainProcessor: Number of channels differs from the number of gain factors!");
+			return false;
+		}
+		return true;
+	}
+
+	virtual bool processBlock(block_t &block)
+	{
+		for(int c = 0; c < block.count(); c++)
+		{
+			const float gain = m_gains.at(c);
+			float *const data = block[c].data();
+			const int frames = block[c].count();
+			for(int i = 0; i < frames; i++)
+			{
+				data[i] *= gain;
+			}
+		}
+		return true;
+	}
+
+private:
+	QVector<float> m_gains;
+};
+
+GainFilter::GainFilter(const double &gain)
+:
+	m_gain(gain)
+{
+	if(m_soxBinary.isEmpty())
+	{
+		MUTILS_THROW("Error initializing SoX filter. Tool 'sox.exe' is not registred!");
+	}
+}
+
+GainFilter::~GainFilter(void)
+{
+}
+
+AbstractFilter::FilterResult GainFilter::appendEffects(AudioFileModel_TechInfo *const /*formatInfo*/, effectsChain_t &chain)
+{
+	emit messageLogged(QString().sprintf("--> Applying gain: %.2f dB\n", m_gain));
+
+	if(fabs(m_gain) < 0.005)
+	{
+		messageLogged("Skipping gain!");
+		return AbstractFilter::FILTER_SKIPPED;
+	}
+
+	chain.effects << "gain" << QString().sprintf("%.2f", m_gain);
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+bool GainFilter::isComposable(void) const
+{
+	return true;
+}
+
+bool GainFilter::hasNativeStage(const AudioFileModel_TechInfo* /*formatInfo*/) const
+{
+	return true;
+}
+
+AbstractFilter::FilterResult GainFilter::createNativeStage(AudioFileModel_TechInfo *const /*formatInfo*/, StreamProcessor *&processor)
+{
+	emit messageLogged(QString().sprintf("--> Applying gain: %.2f dB\n", m_gain));
+
+	if(fabs(m_gain) < 0.005)
+	{
+		messageLogged("Skipping gain!");
+		processor = NULL;
+		return AbstractFilter::FILTER_SKIPPED;
+	}
+
+	emit messageLogged("Using the native gain implementation.");
+	processor = createGainStage(QVector<float>(1, static_cast<float>(pow(10.0, m_gain / 20.0))));
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+StreamProcessor *GainFilter::createGainStage(const QVector<float> &gains)
+{
+	return new GainProcessor(gains);
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Filter_Abstract.h"
+
+#include <QVector>
+
+class GainFilter : public AbstractFilter
+{
+public:
+	GainFilter(const double &gain);
+	~GainFilter(void);
+
+	virtual FilterResult appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain);
+	virtual bool isComposable(void) const;
+
+	virtual bool hasNativeStage(const AudioFileModel_TechInfo *const formatInfo) const;
+	virtual FilterResult createNativeStage(AudioFileModel_TechInfo *const formatInfo, StreamProcessor *&processor);
+
+	//Native stage that scales each channel by a constant factor, a single factor applies to all channels
+	static StreamProcessor *createGainStage(const QVector<float> &gains);
+
+private:
+	const double m_gain;
+};
@@ -0,0 +1,342 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Filter_Native.h"
+
+//Internal
+#include "Global.h"
+#include "Tool_WaveProperties.h"
+#include "Tool_SampleFormat.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QBuffer>
+#include <QtEndian>
+
+//CRT
+#include <string.h>
+
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+
+#define BLOCK_FRAMES 4096
+#define MAX_HEADER_SIZE 1048576
+#define UNKNOWN_SIZE 0xFFFFFFFFui64
+
+////////////////////////////////////////////////////////////
+// Constructor & Destructor
+////////////////////////////////////////////////////////////
+
+NativeProcessor::NativeProcessor(void)
+:
+	m_fileInput(false),
+	m_headerDone(false),
+	m_remaining(0)
+{
+	memset(&m_input, 0, sizeof(format_t));
+	memset(&m_output, 0, sizeof(format_t));
+}
+
+NativeProcessor::~NativeProcessor(void)
+{
+}
+
+////////////////////////////////////////////////////////////
+// Stream Processing
+////////////////////////////////////////////////////////////
+
+bool NativeProcessor::begin(const bool &fileInput)
+{
+	m_fileInput = fileInput;
+	m_headerDone = false;
+	m_buffer.clear();
+	return true;
+}
+
+bool NativeProcessor::process(const char *const data, const qint64 size, QByteArray &output)
+{
+	if(m_headerDone)
+	{
+		return processData(data, size, output);
+	}
+
+	m_buffer.append(data, static_cast<int>(size));
+	if(!readHeader(output))
+	{
+		return false;
+	}
+
+	if(m_headerDone)
+	{
+		const QByteArray pending = m_buffer;
+		m_buffer.clear();
+		return processData(pending.constData(), pending.size(), output);
+	}
+
+	return true; /*header is not complete yet*/
+}
+
+bool NativeProcessor::finish(QByteArray &output)
+{
+	if(!m_headerDone)
+	{
+		qWarning("NativeProcessor: Stream has ended before the WAV header was complete!");
+		return false;
+	}
+
+	if(!m_buffer.isEmpty())
+	{
+		qWarning("NativeProcessor: Discarding %d bytes of an incomplete sample frame!", m_buffer.size());
+		m_buffer.clear();
+	}
+
+	m_block.resize(m_output.channels);
+	for(int c = 0; c < m_block.count(); c++)
+	{
+		m_block[c].resize(0);
+	}
+
+	if(!flushBlock(m_block))
+	{
+		return false;
+	}
+
+	if(producesOutput())
+	{
+		encodeBlock(output);
+	}
+
+	return true;
+}
+
+bool NativeProcessor::flushBlock(block_t& /*block*/)
+{
+	return true; /*no delayed samples*/
+}
+
+quint64 NativeProcessor::outputFrames(const quint64 inputFrames) const
+{
+	return inputFrames;
+}
+
+bool NativeProcessor::producesOutput(void) const
+{
+	return true;
+}
+
+////////////////////////////////////////////////////////////
+// Private Functions
+////////////////////////////////////////////////////////////
+
+bool NativeProcessor::readHeader(QByteArray &output)
+{
+	QBuffer device(&m_buffer);
+	WaveProperties::header_t header;
+
+	if(!(device.open(QIODevice::ReadOnly) && WaveProperties::parseHeader(device, header)))
+	{
+		if(m_buffer.size() > MAX_HEADER_SIZE)
+		{
+			qWarning("NativeProcessor: Input is not a supported WAV stream!");
+			return false;
+		}
+		return true; /*wait for more data*/
+	}
+
+	device.close();
+
+	m_input.formatTag = header.formatTag;
+	m_input.channels = header.channels;
+	m_input.samplerate = header.samplerate;
+	m_input.containerBits = (header.blockAlign / header.channels) * 8;
+	m_input.validBits = header.bitsPerSample;
+	m_input.channelMask = header.channelMask;
+
+	if((header.blockAlign % header.channels) || (!isSupported(m_input)))
+	{
+		qWarning("NativeProcessor: Unsupported sample format!");
+		return false;
+	}
+
+	m_output = m_input;
+	if(!(configure(m_input, m_output) && isSupported(m_output)))
+	{
+		qWarning("NativeProcessor: Failed to configure the output format!");
+		return false;
+	}
+
+	const quint64 inputBlockAlign = m_input.channels * (m_input.containerBits / 8U);
+	const quint64 outputBlockAlign = m_output.channels * (m_output.containerBits / 8U);
+	const bool sameFormat = (memcmp(&m_input, &m_output, sizeof(format_t)) == 0);
+
+	//The declared length can only be trusted, if the stream was read from a file
+	const bool trustLength = m_fileInput && (header.dataSize > 0U);
+	m_remaining = trustLength ? (header.dataSize - (header.dataSize % inputBlockAlign)) : 0xFFFFFFFFFFFFFFFFui64;
+
+	if(producesOutput())
+	{
+		output.append(WaveProperties::makeHeader(sameFormat ? header.formatChunk : makeFormatChunk(m_output), trustLength ? (outputFrames(header.dataSize / inputBlockAlign) * outputBlockAlign) : UNKNOWN_SIZE));
+	}
+
+	m_buffer.remove(0, static_cast<int>(header.dataOffset));
+	m_headerDone = true;
+
+	return true;
+}
+
+bool NativeProcessor::processData(const char *data, qint64 size, QByteArray &output)
+{
+	const int blockAlign = m_input.channels * (m_input.containerBits / 8);
+
+	size = static_cast<qint64>(qMin(static_cast<quint64>(size), m_remaining));
+	m_remaining -= static_cast<quint64>(size);
+
+	//Complete the partial frame that was left over from the previous call
+	if(!m_buffer.isEmpty())
+	{
+		const int count = static_cast<int>(qMin(static_cast<qint64>(blockAlign - m_buffer.size()), size));
+		m_buffer.append(data, count);
+		data += count;
+		size -= count;
+		if(m_buffer.size() < blockAlign)
+		{
+			return true;
+		}
+		if(!processFrames(m_buffer.constData(), 1, output))
+		{
+			return false;
+		}
+		m_buffer.clear();
+	}
+
+	while(size >= blockAlign)
+	{
+		const int frames = static_cast<int>(qMin(size / blockAlign, static_cast<qint64>(BLOCK_FRAMES)));
+		if(!processFrames(data, frames, output))
+		{
+			return false;
+		}
+		data += frames * blockAlign;
+		size -= frames * blockAlign;
+	}
+
+	if(size > 0)
+	{
+		m_buffer.append(data, static_cast<int>(size));
+	}
+
+	return true;
+}
+
+bool NativeProcessor::processFrames(const char *const data, const int frames, QByteArray &output)
+{
+	decodeBlock(data, frames);
+
+	if(!processBlock(m_block))
+	{
+		return false;
+	}
+
+	if(m_block.count() != static_cast<int>(m_output.channels))
+	{
+		qWarning("NativeProcessor: Processed block has an unexpected number of channels!");
+		return false;
+	}
+
+	if(producesOutput())
+	{
+		encodeBlock(output);
+	}
+
+	return true;
+}
+
+void NativeProcessor::decodeBlock(const char *const data, const int frames)
+{
+	const int channels = m_input.channels;
+
+	m_interleaved.resize(frames * channels);
+	SampleFormat::toFloat(SampleFormat::fromWaveFormat(m_input.formatTag, m_input.containerBits), data, m_interleaved.data(), frames * channels);
+
+	m_block.resize(channels);
+	m_planes.resize(channels);
+	for(int c = 0; c < channels; c++)
+	{
+		m_block[c].resize(frames);
+		m_planes[c] = m_block[c].data();
+	}
+
+	SampleFormat::deinterleave(m_interleaved.constData(), m_planes.constData(), channels, frames);
+}
+
+void NativeProcessor::encodeBlock(QByteArray &output)
+{
+	const int channels = m_output.channels;
+	const int frames = m_block.isEmpty() ? 0 : m_block.first().count();
+	const int count = frames * channels;
+
+	if(count < 1)
+	{
+		return;
+	}
+
+	m_interleaved.resize(count);
+	m_planes.resize(channels);
+	for(int c = 0; c < channels; c++)
+	{
+		m_planes[c] = m_block[c].data();
+	}
+
+	SampleFormat::interleave(m_planes.constData(), m_interleaved.data(), channels, frames);
+
+	const int offset = output.size();
+	output.resize(offset + (count * (m_output.containerBits / 8)));
+	SampleFormat::fromFloat(SampleFormat::fromWaveFormat(m_output.formatTag, m_output.containerBits), m_interleaved.constData(), output.data() + offset, count);
+}
+
+bool NativeProcessor::isSupported(const format_t &format)
+{
+	if((format.channels < 1) || (format.samplerate < 1) || (format.validBits < 1) || (format.validBits > format.containerBits))
+	{
+		return false;
+	}
+
+	return (SampleFormat::fromWaveFormat(format.formatTag, format.containerBits) != SampleFormat::FORMAT_UNKNOWN);
+}
+
+QByteArray NativeProcessor::makeFormatChunk(const format_t &format)
+{
+	QByteArray chunk(format.formatTag == WAVE_FORMAT_IEEE_FLOAT ? 18 : 16, '\0');
+	uchar *const fmt = reinterpret_cast<uchar*>(chunk.data());
+
+	const quint16 blockAlign = format.channels * (format.containerBits / 8U);
+
+	qToLittleEndian<quint16>(format.formatTag, fmt);
+	qToLittleEndian<quint16>(format.channels, fmt + 2);
+	qToLittleEndian<quint32>(format.samplerate, fmt + 4);
+	qToLittleEndian<quint32>(format.samplerate * blockAlign, fmt + 8);
+	qToLittleEndian<quint16>(blockAlign, fmt + 12);
+	qToLittleEndian<quint16>(format.containerBits, fmt + 14);
+
+	return chunk;
+}
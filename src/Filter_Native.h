@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Tool_StreamPipeline.h"
+
+#include <QVector>
+
+/*
+ * Base class for in-process filter stages, decodes the WAV stream into blocks of planar float samples
+ * and encodes the processed blocks back into a WAV stream
+ */
+class NativeProcessor : public StreamProcessor
+{
+public:
+	NativeProcessor(void);
+	virtual ~NativeProcessor(void);
+
+	virtual bool begin(const bool &fileInput);
+	virtual bool process(const char *const data, const qint64 size, QByteArray &output);
+	virtual bool finish(QByteArray &output);
+
+protected:
+	typedef struct
+	{
+		quint16 formatTag;		//WAVE_FORMAT_PCM or WAVE_FORMAT_IEEE_FLOAT
+		quint16 channels;
+		quint32 samplerate;
+		quint16 containerBits;	//Bits per sample, as stored
+		quint16 validBits;		//Bits per sample, as used
+		quint32 channelMask;	//Speaker positions, zero if not specified
+	}
+	format_t;
+
+	typedef QVector<float> plane_t;
+	typedef QVector<plane_t> block_t;
+
+	//Called once the input format is known, may change the output format
+	virtual bool configure(const format_t &input, format_t &output) = 0;
+
+	//Process a block of samples in-place, the number of channels must match the output format
+	virtual bool processBlock(block_t &block) = 0;
+
+	//Drain any delayed samples at the end of the stream
+	virtual bool flushBlock(block_t &block);
+
+	//Number of output frames for the given number of input frames
+	virtual quint64 outputFrames(const quint64 inputFrames) const;
+
+	//Analysis-only processors do not produce a WAV stream
+	virtual bool producesOutput(void) const;
+
+private:
+	bool readHeader(QByteArray &output);
+	bool processData(const char *data, qint64 size, QByteArray &output);
+	bool processFrames(const char *const data, const int frames, QByteArray &output);
+	void decodeBlock(const char *const data, const int frames);
+	void encodeBlock(QByteArray &output);
+
+	static bool isSupported(const format_t &format);
+	static QByteArray makeFormatChunk(const format_t &format);
+
+	bool m_fileInput;
+	bool m_headerDone;
+	QByteArray m_buffer;
+	quint64 m_remaining;
+	format_t m_input;
+	format_t m_output;
+	block_t m_block;
+	QVector<float> m_interleaved;
+	QVector<float*> m_planes;
+};
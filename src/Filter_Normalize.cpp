@@ -24,15 +24,15 @@
 
 //Internal
 #include "Global.h"
+#include "Filter_Gain.h"
+#include "Tool_LoudnessMeter.h"
 
 //MUtils
 #include <MUtils/Global.h>
 #include <MUtils/Exception.h>
 
 //Qt
-#include <QDir>
-#include <QProcess>
-#include <QRegExp>
+#include <QStringList>
 
 static double dbToLinear(const double &value)
 {
@@ -41,13 +41,12 @@ static double dbToLinear(const double &value)
 
 NormalizeFilter::NormalizeFilter(const int &peakVolume, const bool &dnyAudNorm, const bool &channelsCoupled, const int &filterSize)
 :
-	m_binary(lamexp_tools_lookup("sox.exe")),
 	m_useDynAudNorm(dnyAudNorm),
 	m_peakVolume(qMin(-50, qMax(-3200, peakVolume))),
 	m_channelsCoupled(channelsCoupled),
 	m_filterLength(qBound(3, filterSize + (1 - (filterSize % 2)), 301))
 {
-	if(m_binary.isEmpty())
+	if(m_soxBinary.isEmpty())
 	{
 		MUTILS_THROW("Error initializing SoX filter. Tool 'sox.exe' is not registred!");
 	}
@@ -57,63 +56,102 @@ NormalizeFilter::~NormalizeFilter(void)
 {
 }
 
-AbstractFilter::FilterResult NormalizeFilter::apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo* /*formatInfo*/, QAtomicInt &abortFlag)
+AbstractFilter::FilterResult NormalizeFilter::appendEffects(AudioFileModel_TechInfo *const /*formatInfo*/, effectsChain_t &chain)
 {
-	QProcess process;
-	QStringList args;
-
-	args << "-V3" << "-S";
-	args << "--temp" << ".";
-	args << QDir::toNativeSeparators(sourceFile);
-	args << QDir::toNativeSeparators(outputFile);
-
 	if(!m_useDynAudNorm)
 	{
-		args << "gain";
-		args << (m_channelsCoupled ? "-n" : "-nb");
-		args << QString().sprintf("%.2f", static_cast<double>(m_peakVolume) / 100.0);
+		chain.effects << "gain";
+		chain.effects << (m_channelsCoupled ? "-n" : "-nb");
+		chain.effects << QString().sprintf("%.2f", static_cast<double>(m_peakVolume) / 100.0);
+		chain.twoPass = true;
 	}
 	else
 	{
-		args << "dynaudnorm";
-		args << "-p" << QString().sprintf("%.2f", qBound(0.1, dbToLinear(static_cast<double>(m_peakVolume) / 100.0), 1.0));
-		args << "-g" << QString().sprintf("%d", m_filterLength);
+		chain.effects << "dynaudnorm";
+		chain.effects << "-p" << QString().sprintf("%.2f", qBound(0.1, dbToLinear(static_cast<double>(m_peakVolume) / 100.0), 1.0));
+		chain.effects << "-g" << QString().sprintf("%d", m_filterLength);
 		if(!m_channelsCoupled)
 		{
-			args << "-n";
+			chain.effects << "-n";
 		}
 	}
 
-	if(!startProcess(process, m_binary, args, QFileInfo(outputFile).canonicalPath()))
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+bool NormalizeFilter::isComposable(void) const
+{
+	return true;
+}
+
+bool NormalizeFilter::hasNativeStage(const AudioFileModel_TechInfo* /*formatInfo*/) const
+{
+	return !m_useDynAudNorm;
+}
+
+bool NormalizeFilter::needsAnalysis(void) const
+{
+	return !m_useDynAudNorm;
+}
+
+/*
+ * Measure the input, so the gain can be applied in a single streaming pass afterwards
+ */
+AbstractFilter::FilterResult NormalizeFilter::analyzeInput(const QString &sourceFile, AudioFileModel_TechInfo *const /*formatInfo*/, QAtomicInt &abortFlag)
+{
+	LoudnessMeter meter;
+	connect(&meter, SIGNAL(statusUpdated(int)), this, SIGNAL(statusUpdated(int)), Qt::DirectConnection);
+	connect(&meter, SIGNAL(messageLogged(QString)), this, SIGNAL(messageLogged(QString)), Qt::DirectConnection);
+
+	m_gains.clear();
+	if(!meter.analyze(sourceFile, abortFlag))
 	{
 		return AbstractFilter::FILTER_FAILURE;
 	}
 
-	int prevProgress = -1;
-	QRegExp regExp("In:(\\d+)(\\.\\d+)*%");
+	const unsigned int channels = meter.channels();
+	QVector<double> gains(channels, 1.0);
 
-	const result_t result = awaitProcess(process, abortFlag, [this, &prevProgress, &regExp](const QString &text)
+	//Balance the channels by their RMS level first, like "gain -b" does
+	if(!m_channelsCoupled)
 	{
-		if (regExp.lastIndexIn(text) >= 0)
+		double maxLevel = 0.0;
+		for(unsigned int c = 0; c < channels; c++)
 		{
-			qint32 newProgress;
-			if (MUtils::regexp_parse_int32(regExp, newProgress))
-			{
-				if (newProgress > prevProgress)
-				{
-					emit statusUpdated(newProgress);
-					prevProgress = NEXT_PROGRESS(newProgress);
-				}
-			}
-			return true;
+			maxLevel = qMax(maxLevel, sqrt(meter.meanSquare(c)));
 		}
-		return false;
-	});
+		for(unsigned int c = 0; c < channels; c++)
+		{
+			const double level = sqrt(meter.meanSquare(c));
+			gains[c] = (level > 0.0) ? (maxLevel / level) : 1.0;
+		}
+	}
 
-	if (result != RESULT_SUCCESS)
+	double peak = 0.0;
+	for(unsigned int c = 0; c < channels; c++)
 	{
-		return AbstractFilter::FILTER_FAILURE;
+		peak = qMax(peak, gains[c] * meter.samplePeak(c));
 	}
-	
+
+	const double scale = (peak > 0.0) ? (dbToLinear(static_cast<double>(m_peakVolume) / 100.0) / peak) : 1.0;
+	for(unsigned int c = 0; c < channels; c++)
+	{
+		m_gains << static_cast<float>(gains[c] * scale);
+	}
+
+	emit messageLogged(QString().sprintf("Normalization gain: %.2f dB", LoudnessMeter::toDecibel(scale)));
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+AbstractFilter::FilterResult NormalizeFilter::createNativeStage(AudioFileModel_TechInfo *const /*formatInfo*/, StreamProcessor *&processor)
+{
+	if(m_gains.isEmpty())
+	{
+		processor = NULL;
+		return AbstractFilter::FILTER_FAILURE; /*input has not been analyzed*/
+	}
+
+	emit messageLogged("Using the native normalization, the gain is applied while streaming to the encoder.");
+	processor = GainFilter::createGainStage(m_gains);
 	return AbstractFilter::FILTER_SUCCESS;
 }
@@ -24,18 +24,26 @@
 
 #include "Filter_Abstract.h"
 
+#include <QVector>
+
 class NormalizeFilter : public AbstractFilter
 {
 public:
 	NormalizeFilter(const int &peakVolume = -50, const bool &dnyAudNorm = false, const bool &channelsCoupled = true, const int &filterSize = 31);
 	~NormalizeFilter(void);
 
-	virtual FilterResult apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag);
+	virtual FilterResult appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain);
+	virtual bool isComposable(void) const;
+
+	virtual bool hasNativeStage(const AudioFileModel_TechInfo *const formatInfo) const;
+	virtual bool needsAnalysis(void) const;
+	virtual FilterResult analyzeInput(const QString &sourceFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag);
+	virtual FilterResult createNativeStage(AudioFileModel_TechInfo *const formatInfo, StreamProcessor *&processor);
 
 private:
-	const QString m_binary;
 	const bool m_useDynAudNorm;
 	const bool m_channelsCoupled;
 	const int m_peakVolume;
 	const int m_filterLength;
+	QVector<float> m_gains;
 };
@@ -25,25 +25,389 @@
 //Internal
 #include "Global.h"
 #include "Model_AudioFile.h"
+#include "Filter_Native.h"
 
 //MUtils
 #include <MUtils/Exception.h>
+#include <MUtils/CPUFeatures.h>
 
 //Qt
-#include <QDir>
-#include <QProcess>
-#include <QRegExp>
+#include <QStringList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QMap>
+#include <QPair>
+#include <QSharedPointer>
+
+//CRT
+#include <math.h>
+#include <immintrin.h>
+
+#define IS_VALID(X) (((X) != 0U) && ((X) != UINT_MAX))
+
+#define WAVE_FORMAT_PCM 0x0001
+
+#define MAX_PHASES 1024
+#define MAX_BANK_SIZE 4194304
+
+static const double PI = 3.14159265358979323846;
 
 static __inline int multipleOf(int value, int base)
 {
 	return qRound(static_cast<double>(value) / static_cast<double>(base)) * base;
 }
 
+////////////////////////////////////////////////////////////
+// Polyphase Filter Bank
+////////////////////////////////////////////////////////////
+
+typedef struct
+{
+	quint32 phases;				//Interpolation factor
+	quint32 step;				//Decimation factor
+	int taps;					//Taps per phase, always a multiple of 8
+	quint64 delay;				//Group delay, in output samples
+	QVector<float> coeffs;		//One phase after the other, each phase in reverse order
+}
+filter_bank_t;
+
+typedef QPair<QPair<quint32, quint32>, bool> filter_key_t;
+
+static QMutex g_filterBankMutex;
+static QMap<filter_key_t, QSharedPointer<const filter_bank_t> > g_filterBankCache;
+
+static quint32 gcd(quint32 a, quint32 b)
+{
+	while(b)
+	{
+		const quint32 t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static double besselI0(const double &x)
+{
+	double sum = 1.0, term = 1.0;
+	for(int k = 1; k < 64; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if(term < (sum * 1e-12)) break;
+	}
+	return sum;
+}
+
+/*
+ * Kaiser windowed sinc, the very high quality bank has more taps and a higher stop-band attenuation
+ */
+static filter_bank_t *createFilterBank(const quint32 inputRate, const quint32 outputRate, const bool veryHigh)
+{
+	const quint32 divisor = gcd(inputRate, outputRate);
+	const quint32 phases = outputRate / divisor, step = inputRate / divisor;
+
+	const double ratio = qMax(1.0, static_cast<double>(step) / static_cast<double>(phases));
+	const int taps = ((static_cast<int>(ceil((veryHigh ? 128.0 : 64.0) * ratio)) + 7) / 8) * 8;
+
+	if((phases > MAX_PHASES) || ((static_cast<quint64>(phases) * taps) > MAX_BANK_SIZE))
+	{
+		qWarning("Resampler: Conversion from %u Hz to %u Hz is not supported!", inputRate, outputRate);
+		return NULL;
+	}
+
+	const int length = static_cast<int>(phases) * taps;
+	const double center = static_cast<double>(length - 1) / 2.0;
+	const double cutoff = (0.5 / static_cast<double>(qMax(phases, step))) * (veryHigh ? 0.95 : 0.91);
+	const double beta = veryHigh ? 12.0 : 9.0, norm = besselI0(beta);
+
+	filter_bank_t *const bank = new filter_bank_t();
+	bank->phases = phases;
+	bank->step = step;
+	bank->taps = taps;
+	bank->delay = static_cast<quint64>(floor((center / static_cast<double>(step)) + 0.5));
+	bank->coeffs.resize(length);
+
+	for(int j = 0; j < length; j++)
+	{
+		const double x = static_cast<double>(j) - center, pos = (2.0 * static_cast<double>(j) / static_cast<double>(length - 1)) - 1.0;
+		const double sinc = (fabs(x) < 1e-9) ? 1.0 : (sin(2.0 * PI * cutoff * x) / (2.0 * PI * cutoff * x));
+		const double window = besselI0(beta * sqrt(qMax(0.0, 1.0 - (pos * pos)))) / norm;
+		const int phase = j % static_cast<int>(phases), tap = j / static_cast<int>(phases);
+		bank->coeffs[(phase * taps) + (taps - 1 - tap)] = static_cast<float>(2.0 * cutoff * static_cast<double>(phases) * sinc * window);
+	}
+
+	return bank;
+}
+
+/*
+ * Filter banks are computed once per conversion and shared by all jobs
+ */
+static QSharedPointer<const filter_bank_t> lookupFilterBank(const quint32 inputRate, const quint32 outputRate, const bool veryHigh)
+{
+	QMutexLocker lock(&g_filterBankMutex);
+	const filter_key_t key(qMakePair(inputRate, outputRate), veryHigh);
+
+	if(!g_filterBankCache.contains(key))
+	{
+		if(filter_bank_t *const bank = createFilterBank(inputRate, outputRate, veryHigh))
+		{
+			g_filterBankCache.insert(key, QSharedPointer<const filter_bank_t>(bank));
+		}
+		else
+		{
+			return QSharedPointer<const filter_bank_t>();
+		}
+	}
+
+	return g_filterBankCache.value(key);
+}
+
+static float dotProductC(const float *const a, const float *const b, const int count)
+{
+	float sum = 0.0f;
+	for(int i = 0; i < count; i++)
+	{
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+static float dotProductSSE(const float *const a, const float *const b, const int count)
+{
+	__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+	for(int i = 0; i < count; i += 8)
+	{
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	acc0 = _mm_add_ps(acc0, acc1);
+	acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+	acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+	return _mm_cvtss_f32(acc0);
+}
+
+static float dotProductAVX(const float *const a, const float *const b, const int count)
+{
+	__m256 acc = _mm256_setzero_ps();
+	for(int i = 0; i < count; i += 8)
+	{
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+	}
+	__m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+	_mm256_zeroupper();
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+}
+
+////////////////////////////////////////////////////////////
+// Native Resampler
+////////////////////////////////////////////////////////////
+
+class ResampleProcessor : public NativeProcessor
+{
+public:
+	ResampleProcessor(const int samplingRate, const int bitDepth, const bool veryHigh)
+	:
+		m_samplingRate(samplingRate),
+		m_bitDepth(bitDepth),
+		m_veryHigh(veryHigh),
+		m_bufferStart(0),
+		m_nextOutput(0),
+		m_inputFrames(0),
+		m_ditherScale(0.0f),
+		m_seed(0x2545F491)
+	{
+		const MUtils::CPUFetaures::cpu_info_t cpuFeatures = MUtils::CPUFetaures::detect();
+		if((cpuFeatures.features & MUtils::CPUFetaures::FLAG_AVX) != 0)
+		{
+			m_dotProduct = dotProductAVX;
+		}
+		else if((cpuFeatures.features & MUtils::CPUFetaures::FLAG_SSE) != 0)
+		{
+			m_dotProduct = dotProductSSE;
+		}
+		else
+		{
+			m_dotProduct = dotProductC;
+		}
+	}
+
+protected:
+	virtual bool configure(const format_t &input, format_t &output)
+	{
+		if((m_samplingRate > 0) && (static_cast<quint32>(m_samplingRate) != input.samplerate))
+		{
+			m_bank = lookupFilterBank(input.samplerate, m_samplingRate, m_veryHigh);
+			if(m_bank.isNull())
+			{
+				return false;
+			}
+
+			//History starts with silence, so the first outputs see a complete window
+			m_history.fill(QVector<float>(m_bank->taps - 1, 0.0f), input.channels);
+			m_bufferStart = -static_cast<qint64>(m_bank->taps - 1);
+			output.samplerate = m_samplingRate;
+		}
+
+		if(m_bitDepth > 0)
+		{
+			output.formatTag = WAVE_FORMAT_PCM;
+			output.containerBits = output.validBits = m_bitDepth;
+		}
+
+		//Output at 16 bits or less needs dither, like "dither -s" in the SoX chain
+		const int outputBits = (output.formatTag == WAVE_FORMAT_PCM) ? output.validBits : 0;
+		if((outputBits > 0) && (outputBits <= 16))
+		{
+			m_ditherScale = static_cast<float>(1 << (outputBits - 1));
+			m_ditherError.fill(0.0f, input.channels);
+		}
+
+		return true;
+	}
+
+	virtual bool processBlock(block_t &block)
+	{
+		if(!m_bank.isNull())
+		{
+			resample(block, false);
+		}
+		if(m_ditherScale > 0.0f)
+		{
+			dither(block);
+		}
+		return true;
+	}
+
+	virtual bool flushBlock(block_t &block)
+	{
+		if(!m_bank.isNull())
+		{
+			resample(block, true);
+		}
+		if(m_ditherScale > 0.0f)
+		{
+			dither(block);
+		}
+		return true;
+	}
+
+	virtual quint64 outputFrames(const quint64 inputFrames) const
+	{
+		return m_bank.isNull() ? inputFrames : (((inputFrames * m_bank->phases) + (m_bank->step / 2U)) / m_bank->step);
+	}
+
+private:
+	bool resample(block_t &block, const bool flush)
+	{
+		const int taps = m_bank->taps;
+		const quint64 phases = m_bank->phases, step = m_bank->step;
+		const int channels = m_history.count();
+
+		for(int c = 0; c < channels; c++)
+		{
+			m_history[c] += block[c];
+		}
+		m_inputFrames += block.first().count();
+
+		//Output sample n is taken from phase (n * step) % phases, at input position (n * step) / phases
+		quint64 outputEnd = ((static_cast<quint64>(m_bufferStart + m_history.first().count()) * phases) + step - 1) / step;
+		if(flush)
+		{
+			const quint64 outputTotal = outputFrames(m_inputFrames) + m_bank->delay;
+			const qint64 padding = static_cast<qint64>(((qMax(outputTotal, 1ui64) - 1) * step) / phases) + 1 - (m_bufferStart + m_history.first().count());
+			for(int c = 0; c < channels; c++)
+			{
+				m_history[c].insert(m_history[c].count(), static_cast<int>(qMax(0i64, padding)), 0.0f);
+			}
+			outputEnd = outputTotal;
+		}
+
+		const quint64 outputFirst = qMax(m_nextOutput, m_bank->delay);
+		const int count = (outputEnd > outputFirst) ? static_cast<int>(outputEnd - outputFirst) : 0;
+
+		for(int c = 0; c < channels; c++)
+		{
+			const float *const input = m_history[c].constData();
+			block[c].resize(count);
+			float *const output = block[c].data();
+			for(int k = 0; k < count; k++)
+			{
+				const quint64 position = (outputFirst + k) * step;
+				const qint64 window = static_cast<qint64>(position / phases) - (taps - 1) - m_bufferStart;
+				output[k] = m_dotProduct(m_bank->coeffs.constData() + ((position % phases) * taps), input + window, taps);
+			}
+		}
+
+		//Keep just the history needed by the next output
+		m_nextOutput = qMax(m_nextOutput, outputEnd);
+		const qint64 drop = static_cast<qint64>((m_nextOutput * step) / phases) - (taps - 1) - m_bufferStart;
+		if(drop > 0)
+		{
+			for(int c = 0; c < channels; c++)
+			{
+				m_history[c].remove(0, static_cast<int>(qMin(drop, static_cast<qint64>(m_history[c].count()))));
+			}
+			m_bufferStart += drop;
+		}
+
+		return true;
+	}
+
+	/*
+	 * TPDF dither with first-order error feedback, samples are quantized here already
+	 */
+	void dither(block_t &block)
+	{
+		const float lower = -m_ditherScale, upper = m_ditherScale - 1.0f;
+		for(int c = 0; c < block.count(); c++)
+		{
+			float *const data = block[c].data();
+			const int frames = block[c].count();
+			float error = m_ditherError[c];
+			for(int i = 0; i < frames; i++)
+			{
+				const float value = (data[i] * m_ditherScale) - error;
+				const float noise = nextRandom() - nextRandom();
+				const float quantized = qBound(lower, floorf(value + noise + 0.5f), upper);
+				error = qBound(-1.0f, quantized - value, 1.0f);
+				data[i] = quantized / m_ditherScale;
+			}
+			m_ditherError[c] = error;
+		}
+	}
+
+	inline float nextRandom(void)
+	{
+		m_seed ^= m_seed << 13;
+		m_seed ^= m_seed >> 17;
+		m_seed ^= m_seed << 5;
+		return static_cast<float>(m_seed >> 8) * (1.0f / 16777216.0f);
+	}
+
+	const int m_samplingRate;
+	const int m_bitDepth;
+	const bool m_veryHigh;
+	float (*m_dotProduct)(const float *const a, const float *const b, const int count);
+	QSharedPointer<const filter_bank_t> m_bank;
+	QVector<QVector<float> > m_history;
+	qint64 m_bufferStart;
+	quint64 m_nextOutput;
+	quint64 m_inputFrames;
+	float m_ditherScale;
+	QVector<float> m_ditherError;
+	quint32 m_seed;
+};
+
+////////////////////////////////////////////////////////////
+// Constructor & Destructor
+////////////////////////////////////////////////////////////
+
 ResampleFilter::ResampleFilter(int samplingRate, int bitDepth)
-:
-	m_binary(lamexp_tools_lookup("sox.exe"))
 {
-	if(m_binary.isEmpty())
+	if(m_soxBinary.isEmpty())
 	{
 		MUTILS_THROW("Error initializing SoX filter. Tool 'sox.exe' is not registred!");
 	}
@@ -61,11 +425,8 @@ ResampleFilter::~ResampleFilter(void)
 {
 }
 
-AbstractFilter::FilterResult ResampleFilter::apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag)
+AbstractFilter::FilterResult ResampleFilter::appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain)
 {
-	QProcess process;
-	QStringList args;
-
 	if((m_samplingRate == static_cast<int>(formatInfo->audioSamplerate())) && (m_bitDepth == static_cast<int>(formatInfo->audioBitdepth())))
 	{
 		messageLogged("Skipping resample filter!");
@@ -73,61 +434,69 @@ AbstractFilter::FilterResult ResampleFilter::apply(const QString &sourceFile, co
 		return AbstractFilter::FILTER_SKIPPED;
 	}
 
-	args << "-V3" << "-S";
-	args << "--guard" << "--temp" << ".";
-	args << QDir::toNativeSeparators(sourceFile);
-
 	if(m_bitDepth)
 	{
-		args << "-b" << QString::number(m_bitDepth);
+		chain.outputOptions = QStringList() << "-b" << QString::number(m_bitDepth);
 	}
 
-	args << QDir::toNativeSeparators(outputFile);
-
 	if(m_samplingRate)
 	{
-		args << "rate";
-		args << ((m_bitDepth > 16) ? "-v" : "-h");			//if resampling at/to > 16 bit depth (i.e. most commonly 24-bit), use VHQ (-v), otherwise, use HQ (-h)
-		args << ((m_samplingRate > 40000) ? "-L" : "-I");	//if resampling to < 40k, use intermediate phase (-I), otherwise use linear phase (-L)
-		args << QString::number(m_samplingRate);
+		chain.effects << "rate";
+		chain.effects << ((m_bitDepth > 16) ? "-v" : "-h");			//if resampling at/to > 16 bit depth (i.e. most commonly 24-bit), use VHQ (-v), otherwise, use HQ (-h)
+		chain.effects << ((m_samplingRate > 40000) ? "-L" : "-I");	//if resampling to < 40k, use intermediate phase (-I), otherwise use linear phase (-L)
+		chain.effects << QString::number(m_samplingRate);
 	}
 
 	if((m_bitDepth || m_samplingRate) && (m_bitDepth <= 16))
 	{
-		args << "dither" << "-s";					//if you're mastering to 16-bit, you also need to add 'dither' (and in most cases noise-shaping) after the rate
+		chain.effects << "dither" << "-s";					//if you're mastering to 16-bit, you also need to add 'dither' (and in most cases noise-shaping) after the rate
 	}
 
-	if(!startProcess(process, m_binary, args, QFileInfo(outputFile).canonicalPath()))
+	chain.guard = true;
+
+	if (m_samplingRate)
 	{
-		return AbstractFilter::FILTER_FAILURE;
+		formatInfo->setAudioSamplerate(m_samplingRate);
+	}
+	if (m_bitDepth)
+	{
+		formatInfo->setAudioBitdepth(m_bitDepth);
 	}
 
-	int prevProgress = -1;
-	QRegExp regExp("In:(\\d+)(\\.\\d+)*%");
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+bool ResampleFilter::isComposable(void) const
+{
+	return true;
+}
 
-	const result_t result = awaitProcess(process, abortFlag, [this, &prevProgress, &regExp](const QString &text)
+bool ResampleFilter::hasNativeStage(const AudioFileModel_TechInfo* /*formatInfo*/) const
+{
+	return true;
+}
+
+AbstractFilter::FilterResult ResampleFilter::createNativeStage(AudioFileModel_TechInfo *const formatInfo, StreamProcessor *&processor)
+{
+	processor = NULL;
+
+	if((m_samplingRate == static_cast<int>(formatInfo->audioSamplerate())) && (m_bitDepth == static_cast<int>(formatInfo->audioBitdepth())))
 	{
-		if (regExp.lastIndexIn(text) >= 0)
-		{
-			qint32 newProgress;
-			if (MUtils::regexp_parse_int32(regExp, newProgress))
-			{
-				if (newProgress > prevProgress)
-				{
-					emit statusUpdated(newProgress);
-					prevProgress = NEXT_PROGRESS(newProgress);
-				}
-			}
-			return true;
-		}
-		return false;
-	});
+		messageLogged("Skipping resample filter!");
+		qDebug("Resampling filter target samplerate/bitdepth is equals to the format of the input file, skipping!");
+		return AbstractFilter::FILTER_SKIPPED;
+	}
 
-	if (result != RESULT_SUCCESS)
+	//The filter bank depends on the input rate, so it must be known up front
+	const unsigned int inputRate = formatInfo->audioSamplerate();
+	if(m_samplingRate && (!(IS_VALID(inputRate) && ((static_cast<int>(inputRate) == m_samplingRate) || (!lookupFilterBank(inputRate, m_samplingRate, m_bitDepth > 16).isNull())))))
 	{
 		return AbstractFilter::FILTER_FAILURE;
 	}
-	
+
+	emit messageLogged("Using the native resampler implementation.");
+	processor = new ResampleProcessor(m_samplingRate, m_bitDepth, m_bitDepth > 16);
+
 	if (m_samplingRate)
 	{
 		formatInfo->setAudioSamplerate(m_samplingRate);
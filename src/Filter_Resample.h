@@ -30,10 +30,13 @@ public:
 	ResampleFilter(int samplingRate = 0, int bitDepth = 0);
 	~ResampleFilter(void);
 
-	virtual FilterResult apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo *const formatInfo, QAtomicInt &abortFlag);
+	virtual FilterResult appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain);
+	virtual bool isComposable(void) const;
+
+	virtual bool hasNativeStage(const AudioFileModel_TechInfo *const formatInfo) const;
+	virtual FilterResult createNativeStage(AudioFileModel_TechInfo *const formatInfo, StreamProcessor *&processor);
 
 private:
-	const QString m_binary;
 	int m_samplingRate;
 	int m_bitDepth;
 };
@@ -24,82 +24,251 @@
 
 //Internal
 #include "Global.h"
+#include "Filter_Native.h"
 
 //MUtils
 #include <MUtils/Exception.h>
+#include <MUtils/CPUFeatures.h>
 
 //Qt
-#include <QDir>
-#include <QProcess>
-#include <QRegExp>
-#include <QFileInfo>
+#include <QStringList>
 
-ToneAdjustFilter::ToneAdjustFilter(int bass, int treble)
-:
-	m_binary(lamexp_tools_lookup("sox.exe"))
-{
-	if(m_binary.isEmpty())
-	{
-		MUTILS_THROW("Error initializing SoX filter. Tool 'sox.exe' is not registred!");
-	}
+//CRT
+#include <math.h>
+#include <immintrin.h>
 
-	m_bass = qMax(-2000, qMin(2000, bass));
-	m_treble = qMax(-2000, qMin(2000, treble));
-}
+//Defaults of the SoX "bass" and "treble" effects
+#define BASS_FREQUENCY 100.0
+#define TREBLE_FREQUENCY 3000.0
+#define SHELF_SLOPE 0.5
 
-ToneAdjustFilter::~ToneAdjustFilter(void)
+static const double PI = 3.14159265358979323846;
+
+//Normalized biquad coefficients, i.e. a0 equals 1
+typedef struct
 {
+	double b0, b1, b2, a1, a2;
 }
+biquad_t;
 
-AbstractFilter::FilterResult ToneAdjustFilter::apply(const QString &sourceFile, const QString &outputFile, AudioFileModel_TechInfo* /*formatInfo*/, QAtomicInt &abortFlag)
+/*
+ * Shelving filter from the "Audio EQ Cookbook", the same design that SoX uses
+ */
+static biquad_t makeShelf(const bool treble, const double &gain, const double &frequency, const double &samplerate)
 {
-	QProcess process;
-	QStringList args;
+	const double A = pow(10.0, gain / 40.0), sqrtA = sqrt(A);
+	const double w0 = 2.0 * PI * qMin(frequency, 0.49 * samplerate) / samplerate;
+	const double cosw0 = cos(w0);
+	const double alpha = (sin(w0) / 2.0) * sqrt(((A + (1.0 / A)) * ((1.0 / SHELF_SLOPE) - 1.0)) + 2.0);
+	const double sign = treble ? -1.0 : 1.0;
 
-	args << "-V3" << "-S";
-	args << "--guard" << "--temp" << ".";
-	args << QDir::toNativeSeparators(sourceFile);
-	args << QDir::toNativeSeparators(outputFile);
+	const double b0 = A * ((A + 1.0) - (sign * (A - 1.0) * cosw0) + (2.0 * sqrtA * alpha));
+	const double b1 = 2.0 * sign * A * ((A - 1.0) - (sign * (A + 1.0) * cosw0));
+	const double b2 = A * ((A + 1.0) - (sign * (A - 1.0) * cosw0) - (2.0 * sqrtA * alpha));
+	const double a0 = (A + 1.0) + (sign * (A - 1.0) * cosw0) + (2.0 * sqrtA * alpha);
+	const double a1 = -2.0 * sign * ((A - 1.0) + (sign * (A + 1.0) * cosw0));
+	const double a2 = (A + 1.0) + (sign * (A - 1.0) * cosw0) - (2.0 * sqrtA * alpha);
 
-	if(m_bass != 0)
+	const biquad_t result = { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+	return result;
+}
+
+/*
+ * All filters use transposed direct form II, the SIMD versions process one channel per lane
+ */
+static void biquadSSE2(float *const *const planes, const int channels, const int frames, const biquad_t &f, double *const z1, double *const z2, int &c)
+{
+	const __m128d b0 = _mm_set1_pd(f.b0), b1 = _mm_set1_pd(f.b1), b2 = _mm_set1_pd(f.b2), a1 = _mm_set1_pd(f.a1), a2 = _mm_set1_pd(f.a2);
+	for(; c + 2 <= channels; c += 2)
 	{
-		args << "bass" << QString().sprintf("%s%.2f", ((m_bass < 0) ? "-" : "+"), static_cast<double>(abs(m_bass)) / 100.0);
+		float *const x0 = planes[c], *const x1 = planes[c + 1];
+		__m128d s1 = _mm_loadu_pd(z1 + c), s2 = _mm_loadu_pd(z2 + c);
+		for(int i = 0; i < frames; i++)
+		{
+			const __m128d x = _mm_set_pd(x1[i], x0[i]);
+			const __m128d y = _mm_add_pd(_mm_mul_pd(b0, x), s1);
+			s1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, x), _mm_mul_pd(a1, y)), s2);
+			s2 = _mm_sub_pd(_mm_mul_pd(b2, x), _mm_mul_pd(a2, y));
+			x0[i] = static_cast<float>(_mm_cvtsd_f64(y));
+			x1[i] = static_cast<float>(_mm_cvtsd_f64(_mm_unpackhi_pd(y, y)));
+		}
+		_mm_storeu_pd(z1 + c, s1);
+		_mm_storeu_pd(z2 + c, s2);
 	}
-	if(m_treble != 0)
+}
+
+static void biquadAVX(float *const *const planes, const int channels, const int frames, const biquad_t &f, double *const z1, double *const z2, int &c)
+{
+	const __m256d b0 = _mm256_set1_pd(f.b0), b1 = _mm256_set1_pd(f.b1), b2 = _mm256_set1_pd(f.b2), a1 = _mm256_set1_pd(f.a1), a2 = _mm256_set1_pd(f.a2);
+	float y[4];
+	for(; c + 4 <= channels; c += 4)
 	{
-		args << "treble" << QString().sprintf("%s%.2f", ((m_treble < 0) ? "-" : "+"), static_cast<double>(abs(m_treble)) / 100.0);
+		float *const x0 = planes[c], *const x1 = planes[c + 1], *const x2 = planes[c + 2], *const x3 = planes[c + 3];
+		__m256d s1 = _mm256_loadu_pd(z1 + c), s2 = _mm256_loadu_pd(z2 + c);
+		for(int i = 0; i < frames; i++)
+		{
+			const __m256d x = _mm256_set_pd(x3[i], x2[i], x1[i], x0[i]);
+			const __m256d out = _mm256_add_pd(_mm256_mul_pd(b0, x), s1);
+			s1 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(b1, x), _mm256_mul_pd(a1, out)), s2);
+			s2 = _mm256_sub_pd(_mm256_mul_pd(b2, x), _mm256_mul_pd(a2, out));
+			_mm_storeu_ps(y, _mm256_cvtpd_ps(out));
+			x0[i] = y[0];
+			x1[i] = y[1];
+			x2[i] = y[2];
+			x3[i] = y[3];
+		}
+		_mm256_storeu_pd(z1 + c, s1);
+		_mm256_storeu_pd(z2 + c, s2);
 	}
+	_mm256_zeroupper();
+}
 
-	if(!startProcess(process, m_binary, args, QFileInfo(outputFile).canonicalPath()))
+class ToneAdjustProcessor : public NativeProcessor
+{
+public:
+	ToneAdjustProcessor(const double &bass, const double &treble)
+	:
+		m_bass(bass),
+		m_treble(treble),
+		m_channels(0)
 	{
-		return AbstractFilter::FILTER_FAILURE;
+		const MUtils::CPUFetaures::cpu_info_t cpuFeatures = MUtils::CPUFetaures::detect();
+		m_useSSE2 = ((cpuFeatures.features & MUtils::CPUFetaures::FLAG_SSE2) != 0);
+		m_useAVX = ((cpuFeatures.features & MUtils::CPUFetaures::FLAG_AVX) != 0);
 	}
 
-	int prevProgress = -1;
-	QRegExp regExp("In:(\\d+)(\\.\\d+)*%");
+protected:
+	virtual bool configure(const format_t &input, format_t& /*output*/)
+	{
+		m_channels = input.channels;
+		m_filters.clear();
+
+		if(m_bass != 0.0)
+		{
+			m_filters << makeShelf(false, m_bass, BASS_FREQUENCY, input.samplerate);
+		}
+		if(m_treble != 0.0)
+		{
+			m_filters << makeShelf(true, m_treble, TREBLE_FREQUENCY, input.samplerate);
+		}
 
-	const result_t result = awaitProcess(process, abortFlag, [this, &prevProgress, &regExp](const QString &text)
+		//Attenuate by the total boost up front, like SoX's guard does, so that the boosted bands can not clip
+		const double guard = pow(10.0, -(qMax(0.0, m_bass) + qMax(0.0, m_treble)) / 20.0);
+		if((guard < 1.0) && (!m_filters.isEmpty()))
+		{
+			biquad_t &first = m_filters.first();
+			first.b0 *= guard;
+			first.b1 *= guard;
+			first.b2 *= guard;
+		}
+
+		m_z1.fill(0.0, m_channels * m_filters.count());
+		m_z2.fill(0.0, m_channels * m_filters.count());
+		m_planes.resize(m_channels);
+		return true;
+	}
+
+	virtual bool processBlock(block_t &block)
 	{
-		if (regExp.lastIndexIn(text) >= 0)
+		const int frames = block.first().count();
+		for(int c = 0; c < m_channels; c++)
+		{
+			m_planes[c] = block[c].data();
+		}
+
+		//Flush denormals to zero, the filter state decays into the denormal range during silence
+		const unsigned int csr = _mm_getcsr();
+		_mm_setcsr(csr | 0x8040);
+
+		for(int k = 0; k < m_filters.count(); k++)
 		{
-			qint32 newProgress;
-			if (MUtils::regexp_parse_int32(regExp, newProgress))
+			const biquad_t &f = m_filters[k];
+			double *const z1 = m_z1.data() + (k * m_channels), *const z2 = m_z2.data() + (k * m_channels);
+
+			int c = 0;
+			if(m_useAVX)
+			{
+				biquadAVX(m_planes.data(), m_channels, frames, f, z1, z2, c);
+			}
+			if(m_useSSE2)
+			{
+				biquadSSE2(m_planes.data(), m_channels, frames, f, z1, z2, c);
+			}
+			for(; c < m_channels; c++)
 			{
-				if (newProgress > prevProgress)
+				float *const x = m_planes[c];
+				double s1 = z1[c], s2 = z2[c];
+				for(int i = 0; i < frames; i++)
 				{
-					emit statusUpdated(newProgress);
-					prevProgress = NEXT_PROGRESS(newProgress);
+					const double y = (f.b0 * x[i]) + s1;
+					s1 = (f.b1 * x[i]) - (f.a1 * y) + s2;
+					s2 = (f.b2 * x[i]) - (f.a2 * y);
+					x[i] = static_cast<float>(y);
 				}
+				z1[c] = s1;
+				z2[c] = s2;
 			}
-			return true;
 		}
-		return false;
-	});
 
-	if (result != RESULT_SUCCESS)
+		_mm_setcsr(csr);
+		return true;
+	}
+
+private:
+	const double m_bass;
+	const double m_treble;
+	bool m_useSSE2;
+	bool m_useAVX;
+	int m_channels;
+	QVector<biquad_t> m_filters;
+	QVector<double> m_z1;
+	QVector<double> m_z2;
+	QVector<float*> m_planes;
+};
+
+ToneAdjustFilter::ToneAdjustFilter(int bass, int treble)
+{
+	if(m_soxBinary.isEmpty())
+	{
+		MUTILS_THROW("Error initializing SoX filter. Tool 'sox.exe' is not registred!");
+	}
+
+	m_bass = qMax(-2000, qMin(2000, bass));
+	m_treble = qMax(-2000, qMin(2000, treble));
+}
+
+ToneAdjustFilter::~ToneAdjustFilter(void)
+{
+}
+
+AbstractFilter::FilterResult ToneAdjustFilter::appendEffects(AudioFileModel_TechInfo *const /*formatInfo*/, effectsChain_t &chain)
+{
+	if(m_bass != 0)
 	{
-		return AbstractFilter::FILTER_FAILURE;
+		chain.effects << "bass" << QString().sprintf("%s%.2f", ((m_bass < 0) ? "-" : "+"), static_cast<double>(abs(m_bass)) / 100.0);
 	}
-	
+	if(m_treble != 0)
+	{
+		chain.effects << "treble" << QString().sprintf("%s%.2f", ((m_treble < 0) ? "-" : "+"), static_cast<double>(abs(m_treble)) / 100.0);
+	}
+
+	chain.guard = true;
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+bool ToneAdjustFilter::isComposable(void) const
+{
+	return true;
+}
+
+bool ToneAdjustFilter::hasNativeStage(const AudioFileModel_TechInfo* /*formatInfo*/) const
+{
+	return true;
+}
+
+AbstractFilter::FilterResult ToneAdjustFilter::createNativeStage(AudioFileModel_TechInfo *const /*formatInfo*/, StreamProcessor *&processor)
+{
+	emit messageLogged("Using the native tone adjustment implementation.");
+	processor = new ToneAdjustProcessor(static_cast<double>(m_bass) / 100.0, static_cast<double>(m_treble) / 100.0);
 	return AbstractFilter::FILTER_SUCCESS;
 }
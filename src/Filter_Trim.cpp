@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+#include "Filter_Trim.h"
+
+//Internal
+#include "Global.h"
+#include "Model_AudioFile.h"
+
+//MUtils
+#include <MUtils/Exception.h>
+
+//Qt
+#include <QStringList>
+
+//CRT
+#include <float.h>
+
+TrimFilter::TrimFilter(const double offset, const double length)
+:
+	m_offset(offset),
+	m_length(length)
+{
+	if(m_soxBinary.isEmpty())
+	{
+		MUTILS_THROW("Error initializing SoX filter. Tool 'sox.exe' is not registred!");
+	}
+}
+
+TrimFilter::~TrimFilter(void)
+{
+}
+
+AbstractFilter::FilterResult TrimFilter::appendEffects(AudioFileModel_TechInfo *const formatInfo, effectsChain_t &chain)
+{
+	const unsigned int samplerate = formatInfo->audioSamplerate();
+	if((samplerate == 0) || (samplerate == UINT_MAX))
+	{
+		qWarning("Trim: Sampling rate is unknown!");
+		return AbstractFilter::FILTER_FAILURE;
+	}
+
+	quint64 firstSample, sampleCount;
+	sampleRange(m_offset, m_length, samplerate, firstSample, sampleCount);
+	emit messageLogged(QString().sprintf("--> Trim offset: %llu samples\n", firstSample));
+
+	chain.effects << "trim" << QString("%1s").arg(QString::number(firstSample));
+	if(sampleCount > 0)
+	{
+		chain.effects << QString("%1s").arg(QString::number(sampleCount));
+		emit messageLogged(QString().sprintf("--> Trim length: %llu samples\n", sampleCount));
+		formatInfo->setDuration(static_cast<unsigned int>(sampleCount / samplerate));
+	}
+	else if(formatInfo->duration() > 0)
+	{
+		formatInfo->setDuration(static_cast<unsigned int>(qMax(0i64, static_cast<qint64>(formatInfo->duration()) - static_cast<qint64>(firstSample / samplerate))));
+	}
+
+	return AbstractFilter::FILTER_SUCCESS;
+}
+
+bool TrimFilter::isComposable(void) const
+{
+	return true;
+}
+
+/*
+ * Convert to sample positions, so that track boundaries are sample-accurate. A count of zero means "until the end".
+ */
+void TrimFilter::sampleRange(const double offset, const double length, const unsigned int samplerate, quint64 &firstSample, quint64 &sampleCount)
+{
+	firstSample = _finite(offset) ? static_cast<quint64>(qMax(0i64, qRound64(offset * samplerate))) : 0ui64;
+	sampleCount = 0ui64;
+
+	if(_finite(length) && (length > 0.0))
+	{
+		const qint64 lastSample = qRound64((qMax(0.0, offset) + length) * samplerate);
+		sampleCount = static_cast<quint64>(qMax(1i64, lastSample - static_cast<qint64>(firstSample)));
+	}
+}
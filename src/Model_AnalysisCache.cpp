@@ -0,0 +1,371 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Model_AnalysisCache.h"
+
+//Internal
+#include "Global.h"
+#include "Model_AudioFile.h"
+
+//MUtils
+#include <MUtils/Global.h>
+#include <MUtils/OSSupport.h>
+
+//Qt
+#include <QApplication>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+////////////////////////////////////////////////////////////
+// Constants
+////////////////////////////////////////////////////////////
+
+static const quint32 CACHE_MAGIC   = 0x4C584143; /*"LXAC"*/
+static const quint32 CACHE_VERSION = 2;
+static const int     MAX_PENDING   = 1024;
+
+////////////////////////////////////////////////////////////
+// Cache Data
+////////////////////////////////////////////////////////////
+
+typedef struct
+{
+	qint64 fileSize;
+	qint64 fileTime;
+	AudioFileModel_MetaInfo metaInfo;
+	AudioFileModel_TechInfo techInfo;
+	bool hasCover;
+}
+cache_record_t;
+
+static QMutex s_mutex;
+static bool s_initialized = false;
+static QString s_cacheFile;
+static quint32 s_toolVersion = 0;
+static QHash<QString, cache_record_t> s_records;
+static QList<QString> s_pending;
+
+////////////////////////////////////////////////////////////
+// Helper Functions
+////////////////////////////////////////////////////////////
+
+static QString init_directory(const QString &path)
+{
+	if(path.isEmpty() || (!QDir(path).mkpath(".")))
+	{
+		return QString();
+	}
+	return QDir(path).canonicalPath();
+}
+
+static QString cache_directory(void)
+{
+	if(lamexp_version_portable())
+	{
+		const QFileInfo appPath(QApplication::applicationFilePath());
+		return init_directory(QString("%1/%2.cache").arg(appPath.absolutePath(), appPath.completeBaseName()));
+	}
+	const QString dataPath = init_directory(QDesktopServices::storageLocation(QDesktopServices::DataLocation));
+	return dataPath.isEmpty() ? QString() : init_directory(QString("%1/cache").arg(dataPath));
+}
+
+static QString cache_key(const QFileInfo &fileInfo)
+{
+	const QString canonicalPath = fileInfo.canonicalFilePath();
+	return canonicalPath.isEmpty() ? QString() : QDir::fromNativeSeparators(canonicalPath).toLower();
+}
+
+static void write_record(QDataStream &stream, const QString &key, const cache_record_t &record)
+{
+	const AudioFileModel_MetaInfo &metaInfo = record.metaInfo;
+	const AudioFileModel_TechInfo &techInfo = record.techInfo;
+
+	stream << key << record.fileSize << record.fileTime;
+	stream << metaInfo.title() << metaInfo.artist() << metaInfo.album() << metaInfo.genre() << metaInfo.comment();
+	stream << quint32(metaInfo.year()) << quint32(metaInfo.position()) << record.hasCover;
+	stream << techInfo.containerType() << techInfo.containerProfile() << techInfo.audioType() << techInfo.audioProfile() << techInfo.audioVersion() << techInfo.audioEncodeLib();
+	stream << quint32(techInfo.audioSamplerate()) << quint32(techInfo.audioChannels()) << quint32(techInfo.audioBitdepth());
+	stream << quint32(techInfo.audioBitrate()) << quint32(techInfo.audioBitrateMode()) << quint32(techInfo.duration());
+}
+
+static bool read_record(QDataStream &stream, QString &key, cache_record_t &record)
+{
+	QString str[11];
+	quint32 val[8];
+
+	stream >> key >> record.fileSize >> record.fileTime;
+	stream >> str[0] >> str[1] >> str[2] >> str[3] >> str[4] >> val[0] >> val[1] >> record.hasCover;
+	stream >> str[5] >> str[6] >> str[7] >> str[8] >> str[9] >> str[10];
+	stream >> val[2] >> val[3] >> val[4] >> val[5] >> val[6] >> val[7];
+
+	if((stream.status() != QDataStream::Ok) || key.isEmpty())
+	{
+		return false;
+	}
+
+	record.metaInfo.setTitle(str[0]);
+	record.metaInfo.setArtist(str[1]);
+	record.metaInfo.setAlbum(str[2]);
+	record.metaInfo.setGenre(str[3]);
+	record.metaInfo.setComment(str[4]);
+	record.metaInfo.setYear(val[0]);
+	record.metaInfo.setPosition(val[1]);
+
+	record.techInfo.setContainerType(str[5]);
+	record.techInfo.setContainerProfile(str[6]);
+	record.techInfo.setAudioType(str[7]);
+	record.techInfo.setAudioProfile(str[8]);
+	record.techInfo.setAudioVersion(str[9]);
+	record.techInfo.setAudioEncodeLib(str[10]);
+	record.techInfo.setAudioSamplerate(val[2]);
+	record.techInfo.setAudioChannels(val[3]);
+	record.techInfo.setAudioBitdepth(val[4]);
+	record.techInfo.setAudioBitrate(val[5]);
+	record.techInfo.setAudioBitrateMode(val[6]);
+	record.techInfo.setDuration(val[7]);
+
+	return true;
+}
+
+static bool write_header(QDataStream &stream)
+{
+	stream.setVersion(QDataStream::Qt_4_8);
+	stream << CACHE_MAGIC << CACHE_VERSION << s_toolVersion;
+	return (stream.status() == QDataStream::Ok);
+}
+
+static bool read_header(QDataStream &stream)
+{
+	quint32 magic = 0, version = 0, toolVersion = 0;
+	stream.setVersion(QDataStream::Qt_4_8);
+	stream >> magic >> version >> toolVersion;
+	return (stream.status() == QDataStream::Ok) && (magic == CACHE_MAGIC) && (version == CACHE_VERSION) && (toolVersion == s_toolVersion);
+}
+
+static bool rewrite_cache(void)
+{
+	const QString tempFile = QString("%1.%2").arg(s_cacheFile, MUtils::next_rand_str());
+	QFile file(tempFile);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("AnalysisCache: Failed to create cache file!");
+		return false;
+	}
+
+	QDataStream stream(&file);
+	bool okay = write_header(stream);
+	for(QHash<QString, cache_record_t>::ConstIterator iter = s_records.constBegin(); okay && (iter != s_records.constEnd()); iter++)
+	{
+		write_record(stream, iter.key(), iter.value());
+		okay = (stream.status() == QDataStream::Ok);
+	}
+	file.close();
+
+	if(!(okay && ((!QFile::exists(s_cacheFile)) || QFile::remove(s_cacheFile)) && QFile::rename(tempFile, s_cacheFile)))
+	{
+		qWarning("AnalysisCache: Failed to write cache file!");
+		QFile::remove(tempFile);
+		return false;
+	}
+
+	s_pending.clear();
+	return true;
+}
+
+static void initialize(void)
+{
+	if(s_initialized)
+	{
+		return;
+	}
+
+	s_initialized = true;
+	s_toolVersion = lamexp_tools_version("mediainfo.exe");
+
+	const QString cacheDir = cache_directory();
+	if(cacheDir.isEmpty())
+	{
+		qWarning("AnalysisCache: Cache directory could not be initialized!");
+		return;
+	}
+
+	s_cacheFile = QString("%1/analysis.dat").arg(cacheDir);
+
+	unsigned int totalCount = 0;
+	bool discard = false;
+
+	QFile file(s_cacheFile);
+	if(file.open(QIODevice::ReadOnly))
+	{
+		QDataStream stream(&file);
+		if(read_header(stream))
+		{
+			while(!stream.atEnd())
+			{
+				QString key;
+				cache_record_t record;
+				if(!read_record(stream, key, record))
+				{
+					qWarning("AnalysisCache: Cache file is truncated, discarding tail!");
+					discard = true;
+					break;
+				}
+				s_records.insert(key, record);
+				totalCount++;
+			}
+		}
+		else
+		{
+			qWarning("AnalysisCache: Cache file is outdated or invalid, discarding!");
+			discard = true;
+		}
+		file.close();
+	}
+	else if(file.exists())
+	{
+		qWarning("AnalysisCache: Failed to open cache file!");
+		s_cacheFile.clear();
+		return;
+	}
+
+	qDebug("AnalysisCache: Loaded %d record(s) from cache.", s_records.count());
+
+	//Compact the cache file, if it contains more stale records than live ones
+	const unsigned int liveCount = s_records.count();
+	if(discard || (!file.exists()) || ((totalCount - liveCount) > liveCount))
+	{
+		if(!rewrite_cache())
+		{
+			s_cacheFile.clear();
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////
+
+bool AnalysisCache::lookup(const QString &filePath, AudioFileModel &audioFile)
+{
+	const QFileInfo fileInfo(filePath);
+	const QString key = cache_key(fileInfo);
+	if(key.isEmpty())
+	{
+		return false;
+	}
+
+	QMutexLocker lock(&s_mutex);
+	initialize();
+
+	QHash<QString, cache_record_t>::ConstIterator iter = s_records.constFind(key);
+	if((iter == s_records.constEnd()) || (iter->fileSize != fileInfo.size()) || (iter->fileTime != fileInfo.lastModified().toMSecsSinceEpoch()))
+	{
+		return false;
+	}
+
+	audioFile.setMetaInfo(iter->metaInfo);
+	audioFile.setTechInfo(iter->techInfo);
+	if(iter->hasCover)
+	{
+		audioFile.metaInfo().setCoverSource(filePath);
+	}
+
+	return true;
+}
+
+void AnalysisCache::insert(const QString &filePath, const AudioFileModel &audioFile)
+{
+	const QFileInfo fileInfo(filePath);
+	const QString key = cache_key(fileInfo);
+	if(key.isEmpty())
+	{
+		return;
+	}
+
+	cache_record_t record;
+	record.fileSize = fileInfo.size();
+	record.fileTime = fileInfo.lastModified().toMSecsSinceEpoch();
+	record.metaInfo = audioFile.metaInfo();
+	record.metaInfo.setCover(QString(), false);
+	record.techInfo = audioFile.techInfo();
+	record.hasCover = audioFile.metaInfo().hasCover();
+
+	QMutexLocker lock(&s_mutex);
+	initialize();
+
+	if(s_cacheFile.isEmpty())
+	{
+		return;
+	}
+
+	s_records.insert(key, record);
+	s_pending.append(key);
+
+	if(s_pending.count() >= MAX_PENDING)
+	{
+		lock.unlock();
+		flush();
+	}
+}
+
+void AnalysisCache::flush(void)
+{
+	QMutexLocker lock(&s_mutex);
+
+	if(s_pending.isEmpty() || s_cacheFile.isEmpty())
+	{
+		return;
+	}
+
+	QFile file(s_cacheFile);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		qWarning("AnalysisCache: Failed to open cache file for writing!");
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_8);
+	while(!s_pending.isEmpty())
+	{
+		const QString key = s_pending.takeFirst();
+		QHash<QString, cache_record_t>::ConstIterator iter = s_records.constFind(key);
+		if(iter != s_records.constEnd())
+		{
+			write_record(stream, key, iter.value());
+		}
+	}
+
+	if(stream.status() != QDataStream::Ok)
+	{
+		qWarning("AnalysisCache: Failed to write cache file!");
+	}
+	file.close();
+}
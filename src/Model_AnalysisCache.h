@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+
+class AudioFileModel;
+
+////////////////////////////////////////////////////////////
+// Analysis Cache
+////////////////////////////////////////////////////////////
+
+/*
+ * Persistent cache of MediaInfo analysis results, keyed by canonical path, file size and modification time.
+ * The records are kept in an append-only file in the config directory.
+ */
+class AnalysisCache
+{
+public:
+	static bool lookup(const QString &filePath, AudioFileModel &audioFile);
+	static void insert(const QString &filePath, const AudioFileModel &audioFile);
+	static void flush(void);
+
+private:
+	AnalysisCache(void) {}
+	AnalysisCache(const AnalysisCache&) {}
+};
@@ -24,14 +24,261 @@
 
 //Internal
 #include "Global.h"
+#include "MimeTypes.h"
 
 //MUtils
 #include <MUtils/Global.h>
+#include <MUtils/OSSupport.h>
 
 //Qt
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QHash>
+#include <QSet>
+#include <QImage>
+#include <QProcess>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QCryptographicHash>
+#include <QBuffer>
+#include <QWaitCondition>
+#include <QDateTime>
+
+//Time that MediaInfo may take to extract the artwork, in milliseconds
+#define EXTRACT_TIMEOUT 10000
+
+static bool artwork_extract(const QString &sourceFile, QByteArray &content, QString &suffix);
+
+////////////////////////////////////////////////////////////
+// Artwork store
+////////////////////////////////////////////////////////////
+
+/*
+ * Content-addressed store for artwork files: every distinct image is written to the temp folder exactly once and
+ * kept open by a single file handle, reference counted across all ArtworkModel instances that use it
+ */
+class ArtworkModel_Store
+{
+public:
+	static QString acquire(const QByteArray &content, const QString &suffix)
+	{
+		const unsigned int maximumSize = s_maximumSize;
+		const QString hash = QString::fromLatin1(QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex());
+		const QString key = maximumSize ? QString("%1_%2").arg(hash, QString::number(maximumSize)) : hash;
+
+		QMutexLocker lock(&s_mutex);
+
+		QHash<QString, entry_t>::Iterator iter = s_entries.find(key);
+		if(iter != s_entries.end())
+		{
+			iter->refCount += 1;
+			return iter->fileHandle->fileName();
+		}
+
+		QByteArray data = content;
+		QString fileExt = suffix;
+		if(maximumSize)
+		{
+			shrink(data, fileExt, maximumSize);
+		}
+
+		QFile *const file = new QFile(QString("%1/%2.%3").arg(MUtils::temp_folder(), key, fileExt));
+		if(!(file->open(QIODevice::WriteOnly | QIODevice::Truncate) && (file->write(data) == data.size())))
+		{
+			qWarning("[ArtworkModel] Failed to write artwork file!");
+			file->remove();
+			MUTILS_DELETE(file);
+			return QString();
+		}
+
+		file->close();
+		if(!file->open(QIODevice::ReadOnly))
+		{
+			qWarning("[ArtworkModel] Failed to open artwork file!");
+			file->remove();
+			MUTILS_DELETE(file);
+			return QString();
+		}
+
+		entry_t entry = { file, 1U };
+		s_entries.insert(key, entry);
+		return file->fileName();
+	}
+
+	/*
+	 * Extract the artwork of a source file, MediaInfo runs only once per source file (e.g. for all tracks of an image).
+	 * The result, including a failure, is remembered for as long as the source file remains unchanged.
+	 */
+	static QString extract(const QString &sourceFile)
+	{
+		const QFileInfo sourceInfo(sourceFile);
+		const QString sourceKey = QString("%1|%2|%3|%4").arg(sourceInfo.absoluteFilePath(), QString::number(sourceInfo.size()), QString::number(sourceInfo.lastModified().toMSecsSinceEpoch()), QString::number(s_maximumSize));
+
+		QMutexLocker lock(&s_mutex);
+
+		//Another thread may be extracting the artwork of the same file right now
+		while(s_pending.contains(sourceKey))
+		{
+			s_extracted.wait(&s_mutex);
+		}
+
+		QHash<QString, QString>::ConstIterator source = s_sources.constFind(sourceKey);
+		if(source != s_sources.constEnd())
+		{
+			if(source->isEmpty())
+			{
+				return QString(); /*extraction has failed before*/
+			}
+			QHash<QString, entry_t>::Iterator iter = s_entries.find(source.value());
+			if(iter != s_entries.end())
+			{
+				iter->refCount += 1;
+				return iter->fileHandle->fileName();
+			}
+		}
+
+		s_pending.insert(sourceKey);
+		lock.unlock();
+
+		QByteArray content;
+		QString suffix;
+		const QString filePath = artwork_extract(sourceFile, content, suffix) ? acquire(content, suffix) : QString();
+
+		lock.relock();
+		s_sources.insert(sourceKey, filePath.isEmpty() ? QString() : QFileInfo(filePath).completeBaseName());
+		s_pending.remove(sourceKey);
+		s_extracted.wakeAll();
+
+		return filePath;
+	}
+
+	static void release(const QString &filePath)
+	{
+		QMutexLocker lock(&s_mutex);
+		const QString key = QFileInfo(filePath).completeBaseName();
+		QHash<QString, entry_t>::Iterator iter = s_entries.find(key);
+		if(iter != s_entries.end())
+		{
+			if(--(iter->refCount) < 1)
+			{
+				QFile *const file = iter->fileHandle;
+				s_entries.erase(iter);
+				file->close();
+				file->remove();
+				MUTILS_DELETE(file);
+			}
+		}
+		else
+		{
+			qWarning("[ArtworkModel] Released an unknown artwork file!");
+		}
+	}
+
+	static void setMaximumSize(const unsigned int maximumSize)
+	{
+		QMutexLocker lock(&s_mutex);
+		s_maximumSize = maximumSize;
+	}
+
+private:
+	typedef struct
+	{
+		QFile *fileHandle;
+		unsigned int refCount;
+	}
+	entry_t;
+
+	//Scale down oversized images and re-compress them (JPEG, unless transparency needs to be preserved)
+	static void shrink(QByteArray &data, QString &suffix, const unsigned int maximumSize)
+	{
+		QImage image;
+		if(!image.loadFromData(data))
+		{
+			return;
+		}
+		if((unsigned(image.width()) <= maximumSize) && (unsigned(image.height()) <= maximumSize))
+		{
+			return;
+		}
+
+		const QImage scaled = image.scaled(maximumSize, maximumSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+		const bool hasAlpha = scaled.hasAlphaChannel();
+
+		QByteArray buffer;
+		QBuffer device(&buffer);
+		if(device.open(QIODevice::WriteOnly) && scaled.save(&device, hasAlpha ? "PNG" : "JPG", hasAlpha ? -1 : 90))
+		{
+			qDebug("Artwork scaled from %dx%d to %dx%d pixels. (%d -> %d bytes)", image.width(), image.height(), scaled.width(), scaled.height(), data.size(), buffer.size());
+			data = buffer;
+			suffix = QLatin1String(hasAlpha ? "png" : "jpg");
+		}
+	}
+
+	static QMutex s_mutex;
+	static QHash<QString, entry_t> s_entries;
+	static QHash<QString, QString> s_sources;
+	static QSet<QString> s_pending;
+	static QWaitCondition s_extracted;
+	static unsigned int s_maximumSize;
+};
+
+QMutex ArtworkModel_Store::s_mutex;
+QHash<QString, ArtworkModel_Store::entry_t> ArtworkModel_Store::s_entries;
+QHash<QString, QString> ArtworkModel_Store::s_sources;
+QSet<QString> ArtworkModel_Store::s_pending;
+QWaitCondition ArtworkModel_Store::s_extracted;
+unsigned int ArtworkModel_Store::s_maximumSize = 0U;
+
+////////////////////////////////////////////////////////////
+// Artwork extraction
+////////////////////////////////////////////////////////////
+
+static bool artwork_extract(const QString &sourceFile, QByteArray &content, QString &suffix)
+{
+	const QString mediaInfoBin = lamexp_tools_lookup("mediainfo.exe");
+	if(mediaInfoBin.isEmpty())
+	{
+		qWarning("[ArtworkModel] MediaInfo binary not found!");
+		return false;
+	}
+
+	QProcess process;
+	MUtils::init_process(process, QFileInfo(mediaInfoBin).absolutePath());
+	process.start(mediaInfoBin, QStringList() << QLatin1String("--Language=raw") << QLatin1String("--Cover_Data=base64") << QLatin1String("--Output=General;%Cover_Mime%|%Cover_Data%") << QDir::toNativeSeparators(sourceFile));
+
+	if(!(process.waitForStarted() && process.waitForFinished(EXTRACT_TIMEOUT)))
+	{
+		qWarning("[ArtworkModel] MediaInfo process failed to extract the artwork!");
+		process.kill();
+		process.waitForFinished(-1);
+		return false;
+	}
+
+	const QString output = QString::fromLatin1(process.readAll()).trimmed();
+	const int separator = output.indexOf(QLatin1Char('|'));
+	const QString mimeType = output.left(separator).section(QLatin1String(" / "), 0, 0).trimmed().toLower();
+	content = QByteArray::fromBase64(output.mid(separator + 1).section(QLatin1String(" / "), 0, 0).trimmed().toLatin1());
+
+	suffix = QLatin1String("jpg");
+	for(size_t i = 0U; MIME_TYPES[i].type; ++i)
+	{
+		if(mimeType.compare(QLatin1String(MIME_TYPES[i].type)) == 0)
+		{
+			suffix = QString::fromLatin1(MIME_TYPES[i].ext[0]);
+			break;
+		}
+	}
+
+	qDebug("Retrieving cover! (mime=\"%s\", type=\"%s\", len=%d)", MUTILS_L1STR(mimeType), MUTILS_L1STR(suffix), content.size());
+	if((separator < 0) || content.isEmpty() || QImage::fromData(content, MUTILS_L1STR(suffix.toUpper())).isNull())
+	{
+		qWarning("Image data seems to be invalid! [Header:%s]", content.left(32).toHex().constData());
+		return false;
+	}
+
+	return true;
+}
 
 ////////////////////////////////////////////////////////////
 // Shared data class
@@ -42,26 +289,20 @@ class ArtworkModel_SharedData
 	friend ArtworkModel;
 
 protected:
-	ArtworkModel_SharedData(const QString &filePath, const bool isOwner)
+	ArtworkModel_SharedData(const QString &filePath, const bool isOwner, const QString &sourceFile = QString())
 	:
 		m_isOwner(isOwner),
+		m_isShared(false),
+		m_hasFailed(false),
 		m_filePath(filePath),
+		m_sourceFile(sourceFile),
 		m_fileHandle(NULL)
 	{
 		m_referenceCounter = 1;
 
 		if(!m_filePath.isEmpty())
 		{
-			QFile *file = new QFile(m_filePath);
-			if(file->open(QIODevice::ReadOnly))
-			{
-				m_fileHandle = file;
-			}
-			else
-			{
-				qWarning("[ArtworkModel] Failed to open artwork file!");
-				MUTILS_DELETE(file);
-			}
+			openFile();
 		}
 	}
 
@@ -76,6 +317,43 @@ protected:
 			m_fileHandle->close();
 			MUTILS_DELETE(m_fileHandle);
 		}
+		if(m_isShared)
+		{
+			ArtworkModel_Store::release(m_filePath);
+		}
+	}
+
+	void openFile(void)
+	{
+		QFile *file = new QFile(m_filePath);
+		if(file->open(QIODevice::ReadOnly))
+		{
+			m_fileHandle = file;
+		}
+		else
+		{
+			qWarning("[ArtworkModel] Failed to open artwork file!");
+			MUTILS_DELETE(file);
+		}
+	}
+
+	const QString &resolve(void)
+	{
+		QMutexLocker lock(&m_resolveMutex);
+		if(!m_sourceFile.isEmpty())
+		{
+			m_filePath = ArtworkModel_Store::extract(m_sourceFile);
+			m_sourceFile.clear();
+			m_isShared = (!m_filePath.isEmpty());
+			m_hasFailed = m_filePath.isEmpty();
+		}
+		return m_filePath;
+	}
+
+	bool hasFailed(void)
+	{
+		QMutexLocker lock(&m_resolveMutex);
+		return m_hasFailed;
 	}
 
 	static ArtworkModel_SharedData *attach(ArtworkModel_SharedData *ptr)
@@ -110,10 +388,14 @@ protected:
 		}
 	}
 
-	const QString m_filePath;
+	QString m_filePath;
+	QString m_sourceFile;
 	const bool m_isOwner;
+	bool m_isShared;
+	bool m_hasFailed;
 	QFile *m_fileHandle;
 	unsigned int m_referenceCounter;
+	QMutex m_resolveMutex;
 
 	static QMutex s_mutex;
 };
@@ -171,7 +453,7 @@ ArtworkModel::~ArtworkModel(void)
 const QString &ArtworkModel::filePath(void) const
 {
 	QMutexLocker lock(m_mutex);
-	return (m_data) ? m_data->m_filePath : m_nullString;
+	return (m_data) ? m_data->resolve() : m_nullString;
 }
 
 bool ArtworkModel::isOwner(void) const
@@ -190,6 +472,30 @@ void ArtworkModel::setFilePath(const QString &newPath, bool isOwner)
 	}
 }
 
+void ArtworkModel::setSourceFile(const QString &sourceFile)
+{
+	QMutexLocker lock(m_mutex);
+	ArtworkModel_SharedData::detach(&m_data);
+	if(!sourceFile.isEmpty())
+	{
+		m_data = new ArtworkModel_SharedData(QString(), false, sourceFile);
+	}
+}
+
+/*
+ * An artwork, which is still to be extracted from its source file, counts as present, until the extraction has failed
+ */
+bool ArtworkModel::isEmpty(void) const
+{
+	QMutexLocker lock(m_mutex);
+	return (m_data) ? m_data->hasFailed() : true;
+}
+
+void ArtworkModel::setMaximumSize(const unsigned int maximumSize)
+{
+	ArtworkModel_Store::setMaximumSize(maximumSize);
+}
+
 void ArtworkModel::clear(void)
 {
 	QMutexLocker lock(m_mutex);
@@ -39,9 +39,12 @@ public:
 	const QString &filePath(void) const;
 	bool isOwner(void) const;
 	void setFilePath(const QString &newPath, bool isOwner = true);
+	void setSourceFile(const QString &sourceFile);
 	void clear(void);
+
+	static void setMaximumSize(const unsigned int maximumSize);
 	
-	inline bool isEmpty(void) const { return (m_data == NULL); }
+	bool isEmpty(void) const;
 
 private:
 	const QString m_nullString;
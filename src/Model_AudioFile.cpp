@@ -248,7 +248,9 @@ void AudioFileModel_TechInfo::reset(void)
 
 AudioFileModel::AudioFileModel(const QString &path)
 :
-	m_filePath(path)
+	m_filePath(path),
+	m_trackOffset(0.0),
+	m_trackLength(0.0)
 {
 	m_metaInfo.reset();
 	m_techInfo.reset();
@@ -259,6 +261,9 @@ AudioFileModel::AudioFileModel(const AudioFileModel &model)
 	ASSIGN_VAL(model, m_filePath);
 	ASSIGN_VAL(model, m_metaInfo);
 	ASSIGN_VAL(model, m_techInfo);
+	ASSIGN_VAL(model, m_trackName);
+	ASSIGN_VAL(model, m_trackOffset);
+	ASSIGN_VAL(model, m_trackLength);
 }
 
 AudioFileModel &AudioFileModel::operator=(const AudioFileModel &model)
@@ -266,6 +271,9 @@ AudioFileModel &AudioFileModel::operator=(const AudioFileModel &model)
 	ASSIGN_VAL(model, m_filePath);
 	ASSIGN_VAL(model, m_metaInfo);
 	ASSIGN_VAL(model, m_techInfo);
+	ASSIGN_VAL(model, m_trackName);
+	ASSIGN_VAL(model, m_trackOffset);
+	ASSIGN_VAL(model, m_trackLength);
 
 	return (*this);
 }
@@ -281,6 +289,15 @@ void AudioFileModel::reset(void)
 	m_filePath.clear();
 	m_metaInfo.reset();
 	m_techInfo.reset();
+	m_trackName.clear();
+	m_trackOffset = m_trackLength = 0.0;
+}
+
+void AudioFileModel::setTrack(const QString &name, const double offset, const double length)
+{
+	m_trackName = name.trimmed();
+	m_trackOffset = offset;
+	m_trackLength = length;
 }
 
 /*------------------------------------*/
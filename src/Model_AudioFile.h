@@ -49,6 +49,7 @@ public:
 	inline const QString &genre(void)   const { return m_genre; }
 	inline const QString &comment(void) const { return m_comment; }
 	inline const QString &cover(void)   const { return m_cover.filePath(); }
+	inline bool hasCover(void)          const { return !m_cover.isEmpty(); }
 	inline unsigned int year(void)      const { return m_year; }
 	inline unsigned int position(void)  const { return m_position; }
 
@@ -59,6 +60,7 @@ public:
 	inline void setGenre(const QString &genre)                    { m_genre = genre.trimmed(); }
 	inline void setComment(const QString &comment)                { m_comment = comment.trimmed(); }
 	inline void setCover(const QString &path, const bool isOwner) { m_cover.setFilePath(path, isOwner); }
+	inline void setCoverSource(const QString &sourceFile)         { m_cover.setSourceFile(sourceFile); }
 	inline void setYear(const unsigned int year)                  { m_year = year; }
 	inline void setPosition(const unsigned int position)          { m_position = position; }
 
@@ -178,11 +180,16 @@ public:
 	inline const AudioFileModel_TechInfo &techInfo(void) const { return m_techInfo; }
 	inline AudioFileModel_MetaInfo &metaInfo(void)             { return m_metaInfo; }
 	inline AudioFileModel_TechInfo &techInfo(void)             { return m_techInfo; }
+	inline bool isTrack(void)                            const { return !m_trackName.isEmpty(); }
+	inline const QString &trackName(void)                const { return m_trackName; }
+	inline double trackOffset(void)                      const { return m_trackOffset; }
+	inline double trackLength(void)                      const { return m_trackLength; }
 
 	//Setter
 	inline void setFilePath(const QString &filePath)                 { m_filePath = filePath; }
 	inline void setMetaInfo(const AudioFileModel_MetaInfo &metaInfo) { m_metaInfo = metaInfo; }
 	inline void setTechInfo(const AudioFileModel_TechInfo &techInfo) { m_techInfo = techInfo; }
+	void setTrack(const QString &name, const double offset, const double length);
 
 	//Helpers
 	const QString durationInfo(void) const;
@@ -197,4 +204,9 @@ private:
 	QString m_filePath;
 	AudioFileModel_MetaInfo m_metaInfo;
 	AudioFileModel_TechInfo m_techInfo;
+
+	//Track within a larger source file, e.g. a cue sheet image (offset and length in seconds)
+	QString m_trackName;
+	double m_trackOffset;
+	double m_trackLength;
 };
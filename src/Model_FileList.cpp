@@ -39,6 +39,7 @@
 #define EXPAND(STR) QString(STR).leftJustified(96, ' ')
 #define CHECK_HDR(STR,NAM) (!(STR).compare((NAM), Qt::CaseInsensitive))
 #define MAKE_KEY(PATH) (QDir::fromNativeSeparators(PATH).toLower())
+#define MAKE_FILE_KEY(FILE) ((FILE).isTrack() ? QString("%1|%2").arg(MAKE_KEY((FILE).filePath()), QString::number((FILE).trackOffset(), 'f', 6)) : MAKE_KEY((FILE).filePath()))
 
 static inline int LOG10(int x)
 {
@@ -156,7 +157,7 @@ void FileListModel::addFile(const QString &filePath)
 
 void FileListModel::addFile(const AudioFileModel &file)
 {
-	const QString key = MAKE_KEY(file.filePath()); 
+	const QString key = MAKE_FILE_KEY(file); 
 	const bool flag = (!m_blockUpdates);
 
 	if(!m_fileStore.contains(key))
@@ -229,7 +230,7 @@ bool FileListModel::setFile(const QModelIndex &index, const AudioFileModel &audi
 	if(index.row() >= 0 && index.row() < m_fileList.count())
 	{
 		const QString oldKey = m_fileList.at(index.row());
-		const QString newKey = MAKE_KEY(audioFile.filePath());
+		const QString newKey = MAKE_FILE_KEY(audioFile);
 		
 		beginResetModel();
 		m_fileList.replace(index.row(), newKey);
@@ -208,7 +208,9 @@ LAMEXP_MAKE_ID(aftenAudioCodingMode,         "AdvancedOptions/Aften/AudioCodingM
 LAMEXP_MAKE_ID(aftenDynamicRangeCompression, "AdvancedOptions/Aften/DynamicRangeCompression");
 LAMEXP_MAKE_ID(aftenExponentSearchSize,      "AdvancedOptions/Aften/ExponentSearchSize");
 LAMEXP_MAKE_ID(aftenFastBitAllocation,       "AdvancedOptions/Aften/FastBitAllocation");
+LAMEXP_MAKE_ID(albumGainMode,                "AdvancedOptions/AlbumGain/Mode");
 LAMEXP_MAKE_ID(antivirNotificationsEnabled,  "Flags/EnableAntivirusNotifications");
+LAMEXP_MAKE_ID(artworkMaximumSize,           "AdvancedOptions/Artwork/MaximumSize");
 LAMEXP_MAKE_ID(autoUpdateCheckBeta,          "AutoUpdate/CheckForBetaVersions");
 LAMEXP_MAKE_ID(autoUpdateEnabled,            "AutoUpdate/Enabled");
 LAMEXP_MAKE_ID(autoUpdateLastCheck,          "AutoUpdate/LastCheck");
@@ -253,6 +255,7 @@ LAMEXP_MAKE_ID(compressionVbrQualityOggEnc,  "Compression/VbrQualityLevel/OggEnc
 LAMEXP_MAKE_ID(compressionVbrQualityOpusEnc, "Compression/VbrQualityLevel/OpusEnc");
 LAMEXP_MAKE_ID(compressionVbrQualityWave,    "Compression/VbrQualityLevel/Wave");
 LAMEXP_MAKE_ID(createPlaylist,               "Flags/AutoCreatePlaylist");
+LAMEXP_MAKE_ID(cueSheetDirectEncode,         "AdvancedOptions/CueSheet/DirectEncode");
 LAMEXP_MAKE_ID(currentLanguage,              "Localization/Language");
 LAMEXP_MAKE_ID(currentLanguageFile,          "Localization/UseQMFile");
 LAMEXP_MAKE_ID(customParametersAacEnc,       "AdvancedOptions/CustomParameters/AacEnc");
@@ -278,9 +281,13 @@ LAMEXP_MAKE_ID(keepOriginalDataTime,         "AdvancedOptions/FileOperations/Kee
 LAMEXP_MAKE_ID(lameAlgoQuality,              "AdvancedOptions/LAME/AlgorithmQuality");
 LAMEXP_MAKE_ID(lameChannelMode,              "AdvancedOptions/LAME/ChannelMode");
 LAMEXP_MAKE_ID(licenseAccepted,              "LicenseAccepted");
+LAMEXP_MAKE_ID(longestJobFirst,              "AdvancedOptions/Threading/LongestJobFirst");
 LAMEXP_MAKE_ID(maximumInstances,             "AdvancedOptions/Threading/MaximumInstances");
 LAMEXP_MAKE_ID(metaInfoPosition,             "MetaInformation/PlaylistPosition");
+LAMEXP_MAKE_ID(metricsReportEnabled,         "AdvancedOptions/MetricsReport/Enabled");
 LAMEXP_MAKE_ID(mostRecentInputPath,          "InputDirectory/MostRecentPath");
+LAMEXP_MAKE_ID(nativeDecodersEnabled,        "AdvancedOptions/NativeDecoders/Enabled");
+LAMEXP_MAKE_ID(nativeFiltersEnabled,         "AdvancedOptions/NativeFilters/Enabled");
 LAMEXP_MAKE_ID(neroAACEnable2Pass,           "AdvancedOptions/AACEnc/Enable2Pass");
 LAMEXP_MAKE_ID(neroAacNotificationsEnabled,  "Flags/EnableNeroAacNotifications");
 LAMEXP_MAKE_ID(normalizationFilterEnabled,   "AdvancedOptions/VolumeNormalization/Enabled");
@@ -306,6 +313,7 @@ LAMEXP_MAKE_ID(samplingRate,                 "AdvancedOptions/Common/Resampling"
 LAMEXP_MAKE_ID(shellIntegrationEnabled,      "Flags/EnableShellIntegration");
 LAMEXP_MAKE_ID(slowStartup,                  "Flags/SlowStartupDetected");
 LAMEXP_MAKE_ID(soundsEnabled,                "Flags/EnableSounds");
+LAMEXP_MAKE_ID(streamingPipelineEnabled,     "AdvancedOptions/Streaming/Enabled");
 LAMEXP_MAKE_ID(toneAdjustBass,               "AdvancedOptions/ToneAdjustment/Bass");
 LAMEXP_MAKE_ID(toneAdjustTreble,             "AdvancedOptions/ToneAdjustment/Treble");
 LAMEXP_MAKE_ID(versionNumber,                "VersionNumber");
@@ -625,7 +633,9 @@ LAMEXP_MAKE_OPTION_I(aftenAudioCodingMode, 0)
 LAMEXP_MAKE_OPTION_I(aftenDynamicRangeCompression, 5)
 LAMEXP_MAKE_OPTION_I(aftenExponentSearchSize, 8)
 LAMEXP_MAKE_OPTION_B(aftenFastBitAllocation, false)
+LAMEXP_MAKE_OPTION_I(albumGainMode, 0)
 LAMEXP_MAKE_OPTION_B(antivirNotificationsEnabled, true)
+LAMEXP_MAKE_OPTION_I(artworkMaximumSize, 0)
 LAMEXP_MAKE_OPTION_B(autoUpdateCheckBeta, false)
 LAMEXP_MAKE_OPTION_B(autoUpdateEnabled, (!lamexp_version_portable()));
 LAMEXP_MAKE_OPTION_S(autoUpdateLastCheck, "Never")
@@ -670,6 +680,7 @@ LAMEXP_MAKE_OPTION_I(compressionVbrQualityOggEnc, 7)
 LAMEXP_MAKE_OPTION_I(compressionVbrQualityOpusEnc, 11)
 LAMEXP_MAKE_OPTION_I(compressionVbrQualityWave, 0)
 LAMEXP_MAKE_OPTION_B(createPlaylist, true)
+LAMEXP_MAKE_OPTION_B(cueSheetDirectEncode, false)
 LAMEXP_MAKE_OPTION_S(currentLanguage, defaultLanguage())
 LAMEXP_MAKE_OPTION_S(currentLanguageFile, QString())
 LAMEXP_MAKE_OPTION_S(customParametersAacEnc, QString())
@@ -695,9 +706,13 @@ LAMEXP_MAKE_OPTION_B(keepOriginalDataTime, false)
 LAMEXP_MAKE_OPTION_I(lameAlgoQuality, 2)
 LAMEXP_MAKE_OPTION_I(lameChannelMode, 0)
 LAMEXP_MAKE_OPTION_I(licenseAccepted, 0)
+LAMEXP_MAKE_OPTION_B(longestJobFirst, true)
 LAMEXP_MAKE_OPTION_U(maximumInstances, 0)
 LAMEXP_MAKE_OPTION_U(metaInfoPosition, UINT_MAX)
+LAMEXP_MAKE_OPTION_B(metricsReportEnabled, false)
 LAMEXP_MAKE_OPTION_S(mostRecentInputPath, defaultDirectory())
+LAMEXP_MAKE_OPTION_B(nativeDecodersEnabled, true)
+LAMEXP_MAKE_OPTION_B(nativeFiltersEnabled, false)
 LAMEXP_MAKE_OPTION_B(neroAACEnable2Pass, true)
 LAMEXP_MAKE_OPTION_B(neroAacNotificationsEnabled, true)
 LAMEXP_MAKE_OPTION_B(normalizationFilterEnabled, false)
@@ -723,6 +738,7 @@ LAMEXP_MAKE_OPTION_I(samplingRate, 0)
 LAMEXP_MAKE_OPTION_B(shellIntegrationEnabled, !lamexp_version_portable())
 LAMEXP_MAKE_OPTION_B(slowStartup, false)
 LAMEXP_MAKE_OPTION_B(soundsEnabled, true)
+LAMEXP_MAKE_OPTION_B(streamingPipelineEnabled, false)
 LAMEXP_MAKE_OPTION_I(toneAdjustBass, 0)
 LAMEXP_MAKE_OPTION_I(toneAdjustTreble, 0)
 LAMEXP_MAKE_OPTION_B(writeMetaTags, true)
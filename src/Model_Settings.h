@@ -87,6 +87,13 @@ public:
 		Overwrite_SkipFile = 1,
 		Overwrite_Replaces = 2
 	};
+
+	enum AlbumGainMode
+	{
+		AlbumGain_Disabled  = 0,
+		AlbumGain_WriteTags = 1,
+		AlbumGain_ApplyGain = 2
+	};
 	
 	enum AACEncoderType
 	{
@@ -106,7 +113,9 @@ public:
 	LAMEXP_MAKE_OPTION_I(aftenDynamicRangeCompression)
 	LAMEXP_MAKE_OPTION_I(aftenExponentSearchSize)
 	LAMEXP_MAKE_OPTION_B(aftenFastBitAllocation)
+	LAMEXP_MAKE_OPTION_I(albumGainMode)
 	LAMEXP_MAKE_OPTION_B(antivirNotificationsEnabled)
+	LAMEXP_MAKE_OPTION_I(artworkMaximumSize)
 	LAMEXP_MAKE_OPTION_B(autoUpdateCheckBeta)
 	LAMEXP_MAKE_OPTION_B(autoUpdateEnabled)
 	LAMEXP_MAKE_OPTION_S(autoUpdateLastCheck)
@@ -151,6 +160,7 @@ public:
 	LAMEXP_MAKE_OPTION_I(compressionVbrQualityOpusEnc)
 	LAMEXP_MAKE_OPTION_I(compressionVbrQualityWave)
 	LAMEXP_MAKE_OPTION_B(createPlaylist)
+	LAMEXP_MAKE_OPTION_B(cueSheetDirectEncode)
 	LAMEXP_MAKE_OPTION_S(currentLanguage)
 	LAMEXP_MAKE_OPTION_S(currentLanguageFile)
 	LAMEXP_MAKE_OPTION_S(customParametersAacEnc)
@@ -176,9 +186,13 @@ public:
 	LAMEXP_MAKE_OPTION_I(lameAlgoQuality)
 	LAMEXP_MAKE_OPTION_I(lameChannelMode)
 	LAMEXP_MAKE_OPTION_I(licenseAccepted)
+	LAMEXP_MAKE_OPTION_B(longestJobFirst)
 	LAMEXP_MAKE_OPTION_U(maximumInstances)
 	LAMEXP_MAKE_OPTION_U(metaInfoPosition)
+	LAMEXP_MAKE_OPTION_B(metricsReportEnabled)
 	LAMEXP_MAKE_OPTION_S(mostRecentInputPath)
+	LAMEXP_MAKE_OPTION_B(nativeDecodersEnabled)
+	LAMEXP_MAKE_OPTION_B(nativeFiltersEnabled)
 	LAMEXP_MAKE_OPTION_B(neroAACEnable2Pass)
 	LAMEXP_MAKE_OPTION_B(neroAacNotificationsEnabled)
 	LAMEXP_MAKE_OPTION_B(normalizationFilterEnabled)
@@ -204,6 +218,7 @@ public:
 	LAMEXP_MAKE_OPTION_B(shellIntegrationEnabled)
 	LAMEXP_MAKE_OPTION_B(slowStartup)
 	LAMEXP_MAKE_OPTION_B(soundsEnabled)
+	LAMEXP_MAKE_OPTION_B(streamingPipelineEnabled)
 	LAMEXP_MAKE_OPTION_I(toneAdjustBass)
 	LAMEXP_MAKE_OPTION_I(toneAdjustTreble)
 	LAMEXP_MAKE_OPTION_B(writeMetaTags)
@@ -29,6 +29,8 @@
 #include "Decoder_ALAC.h"
 #include "Decoder_Avisynth.h"
 #include "Decoder_FLAC.h"
+#include "Decoder_LibFLAC.h"
+#include "Decoder_LibMPG123.h"
 #include "Decoder_MAC.h"
 #include "Decoder_MP3.h"
 #include "Decoder_Musepack.h"
@@ -71,6 +73,10 @@ QScopedPointer<DecoderRegistry::typeList_t> DecoderRegistry::m_availableTypes;
 
 AbstractDecoder *DecoderRegistry::lookup(const QString &containerType, const QString &containerProfile, const QString &formatType, const QString &formatProfile, const QString &formatVersion)
 {
+	//In-process decoders come first, so they take priority over the decoders that run a tool
+	PROBE_DECODER(LibMPG123Decoder);
+	PROBE_DECODER(LibFLACDecoder);
+
 	PROBE_DECODER(MP3Decoder);
 	PROBE_DECODER(VorbisDecoder);
 	PROBE_DECODER(AACDecoder);
@@ -182,6 +188,8 @@ const QStringList &DecoderRegistry::getSupportedTypes(void)
 void DecoderRegistry::configureDecoders(const SettingsModel *settings)
 {
 	OpusDecoder::setDisableResampling(settings->opusDisableResample());
+	LibFLACDecoder::setEnabled(settings->nativeDecodersEnabled());
+	LibMPG123Decoder::setEnabled(settings->nativeDecodersEnabled());
 }
 
 ////////////////////////////////////////////////////////////
@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Thread_AlbumGain.h"
+
+//Internal
+#include "Global.h"
+#include "Registry_Decoder.h"
+#include "Decoder_Abstract.h"
+#include "Tool_LoudnessMeter.h"
+#include "Tool_WaveProperties.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QFileInfo>
+
+//CRT
+#include <limits>
+
+////////////////////////////////////////////////////////////
+// Constructor & Destructor
+////////////////////////////////////////////////////////////
+
+AlbumGainTask::AlbumGainTask(const quint32 jobIndex, const AudioFileModel &audioFile, const QString &tempFolder, QAtomicInt &abortFlag)
+:
+	m_jobIndex(jobIndex),
+	m_audioFile(audioFile),
+	m_tempFolder(tempFolder),
+	m_abortFlag(abortFlag),
+	m_success(false),
+	m_loudness(-std::numeric_limits<double>::infinity()),
+	m_truePeak(0.0)
+{
+	setAutoDelete(false);
+}
+
+AlbumGainTask::~AlbumGainTask(void)
+{
+}
+
+////////////////////////////////////////////////////////////
+// Thread Entry Point
+////////////////////////////////////////////////////////////
+
+void AlbumGainTask::run(void)
+{
+	LoudnessMeter meter;
+
+	if((!MUTILS_BOOLIFY(m_abortFlag)) && analyzeFile(meter))
+	{
+		m_loudness = meter.integratedLoudness();
+		m_truePeak = meter.truePeak();
+		m_blockEnergies = meter.blockEnergies();
+		m_success = true;
+	}
+
+	if(!m_success)
+	{
+		qWarning("Album gain analysis has failed: <%s>", MUTILS_UTF8(m_audioFile.filePath()));
+	}
+
+	emit taskCompleted(m_jobIndex);
+}
+
+////////////////////////////////////////////////////////////
+// Private Functions
+////////////////////////////////////////////////////////////
+
+bool AlbumGainTask::analyzeFile(LoudnessMeter &meter)
+{
+	const QString sourceFile = m_audioFile.filePath();
+	const AudioFileModel_TechInfo &formatInfo = m_audioFile.techInfo();
+	AbstractDecoder *decoder = DecoderRegistry::lookup(formatInfo.containerType(), formatInfo.containerProfile(), formatInfo.audioType(), formatInfo.audioProfile(), formatInfo.audioVersion());
+
+	if(!decoder)
+	{
+		qWarning("Unsupported input file: <%s>", MUTILS_UTF8(sourceFile));
+		return false;
+	}
+
+	//Nothing to decode, the meter reads the source in place
+	if(decoder->isReadableInPlace())
+	{
+		MUTILS_DELETE(decoder);
+		return meter.analyze(sourceFile, m_abortFlag);
+	}
+
+	//Analyze the output of the decoder while it is running, nothing is written to the disk
+	AbstractDecoder::streamInfo_t streamInfo;
+	if(decoder->openStream(sourceFile, streamInfo))
+	{
+		return meter.analyze(new DecoderSource(decoder, streamInfo), m_abortFlag);
+	}
+
+	QString program;
+	QStringList args;
+	if(decoder->createPipelineStage(sourceFile, program, args))
+	{
+		MUTILS_DELETE(decoder);
+		return meter.analyze(program, args, m_abortFlag);
+	}
+
+	//Otherwise decode to a temporary file, which only lives as long as the analysis
+	const QString tempFile = MUtils::make_temp_file(m_tempFolder, (WaveProperties::useWave64(formatInfo) && decoder->supportsWave64()) ? "w64" : "wav", true);
+	if(tempFile.isEmpty())
+	{
+		MUTILS_DELETE(decoder);
+		return false;
+	}
+
+	bool success = decoder->decode(sourceFile, tempFile, m_abortFlag);
+	MUTILS_DELETE(decoder);
+
+	if(success)
+	{
+		success = meter.analyze(tempFile, m_abortFlag);
+	}
+
+	MUtils::remove_file(tempFile);
+	return success;
+}
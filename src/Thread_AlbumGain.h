@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QRunnable>
+#include <QVector>
+
+#include "Model_AudioFile.h"
+
+class LoudnessMeter;
+
+////////////////////////////////////////////////////////////
+// Album Gain Task
+////////////////////////////////////////////////////////////
+
+/*
+ * Measures the loudness of one file of the batch. The decoder output is analyzed as a stream and discarded,
+ * only decoders that can not write to a pipe need a temporary file, which is deleted right after the analysis.
+ */
+class AlbumGainTask: public QObject, public QRunnable
+{
+	Q_OBJECT
+
+public:
+	AlbumGainTask(const quint32 jobIndex, const AudioFileModel &audioFile, const QString &tempFolder, QAtomicInt &abortFlag);
+	~AlbumGainTask(void);
+
+	inline quint32 jobIndex(void) const { return m_jobIndex; }
+	inline bool success(void) const { return m_success; }
+	inline double loudness(void) const { return m_loudness; }
+	inline double truePeak(void) const { return m_truePeak; }
+	inline const QVector<double> &blockEnergies(void) const { return m_blockEnergies; }
+
+signals:
+	void taskCompleted(const unsigned int jobIndex);
+
+protected:
+	void run(void);
+
+private:
+	bool analyzeFile(LoudnessMeter &meter);
+
+	const quint32 m_jobIndex;
+	const AudioFileModel m_audioFile;
+	const QString m_tempFolder;
+	QAtomicInt &m_abortFlag;
+
+	bool m_success;
+	double m_loudness;
+	double m_truePeak;
+	QVector<double> m_blockEnergies;
+};
@@ -29,10 +29,12 @@
 #include "Model_CueSheet.h"
 #include "Registry_Decoder.h"
 #include "Decoder_Abstract.h"
+#include "Tool_WaveProperties.h"
 
 //MUtils
 #include <MUtils/Global.h>
 #include <MUtils/OSSupport.h>
+#include <MUtils/CPUFeatures.h>
 
 //Qt
 #include <QDir>
@@ -41,12 +43,113 @@
 #include <QDate>
 #include <QTime>
 #include <QDebug>
+#include <QSet>
+#include <QFile>
+#include <QVector>
+#include <QPair>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QSharedPointer>
 
 //CRT
 #include <math.h>
 #include <float.h>
 #include <limits>
 
+#define NATIVE_BUFFER_SIZE 1048576
+#define MAX_DECOMPRESS_THREADS 16
+#define MAX_RIFF_DATA_SIZE 0xFFFFF000ui64
+
+////////////////////////////////////////////////////////////
+// Types
+////////////////////////////////////////////////////////////
+
+struct CueSplitter::track_t
+{
+	QString outputFile;
+	int trackNo;
+	double offset;
+	double length;
+	AudioFileModel_MetaInfo metaInfo;
+};
+
+////////////////////////////////////////////////////////////
+// Helper Functions
+////////////////////////////////////////////////////////////
+
+static bool writeWaveHeader(QFile &file, const WaveProperties::header_t &info, const quint64 dataSize)
+{
+	const QByteArray header = WaveProperties::makeHeader(info.formatChunk, dataSize);
+
+	//Add the pad byte after an odd-sized data chunk
+	if((dataSize & 1U) && (file.size() == header.size() + static_cast<qint64>(dataSize)))
+	{
+		if(!(file.seek(file.size()) && (file.write("\0", 1) == 1)))
+		{
+			return false;
+		}
+	}
+
+	return file.seek(0) && (file.write(header) == header.size());
+}
+
+class CueSplitter_DecompressTask : public QRunnable
+{
+public:
+	CueSplitter_DecompressTask(const QString &inputFile, const AudioFileModel_TechInfo &techInfo, const QString &outputFile, QAtomicInt &abortFlag)
+	:
+		m_inputFile(inputFile),
+		m_techInfo(techInfo),
+		m_outputFile(outputFile),
+		m_abortFlag(abortFlag),
+		m_success(false)
+	{
+		setAutoDelete(false);
+	}
+
+	bool waitForResult(void)
+	{
+		m_done.acquire();
+		m_done.release();
+		return m_success;
+	}
+
+	const QString &outputFile(void) const { return m_outputFile; }
+
+protected:
+	void run(void)
+	{
+		AbstractDecoder *decoder = DecoderRegistry::lookup(m_techInfo.containerType(), m_techInfo.containerProfile(), m_techInfo.audioType(), m_techInfo.audioProfile(), m_techInfo.audioVersion());
+		if(decoder)
+		{
+			if(!MUTILS_BOOLIFY(m_abortFlag))
+			{
+				m_success = decoder->decode(m_inputFile, m_outputFile, m_abortFlag);
+				if(!m_success)
+				{
+					qWarning("Failed to decompress file: <%s>", MUTILS_UTF8(m_inputFile));
+					MUtils::remove_file(m_outputFile);
+				}
+			}
+			MUTILS_DELETE(decoder);
+		}
+		else
+		{
+			qWarning("Unsupported input file: <%s>", MUTILS_UTF8(m_inputFile));
+		}
+		m_done.release();
+	}
+
+private:
+	const QString m_inputFile;
+	const AudioFileModel_TechInfo m_techInfo;
+	const QString m_outputFile;
+	QAtomicInt &m_abortFlag;
+	bool m_success;
+	QSemaphore m_done;
+};
+
 ////////////////////////////////////////////////////////////
 // Constructor
 ////////////////////////////////////////////////////////////
@@ -77,6 +180,7 @@ CueSplitter::CueSplitter(const QString &outputDir, const QString &baseName, CueS
 	
 	qDebug("All input files added.");
 	m_bSuccess = false;
+	m_bDirectMode = false;
 }
 
 CueSplitter::~CueSplitter(void)
@@ -100,7 +204,7 @@ void CueSplitter::run()
 	m_decompressedFiles.clear();
 	m_activeFile.clear();
 	
-	if(!QDir(m_outputDir).exists())
+	if((!m_bDirectMode) && (!QDir(m_outputDir).exists()))
 	{
 		qWarning("Output directory \"%s\" does not exist!", MUTILS_UTF8(m_outputDir));
 		return;
@@ -109,69 +213,43 @@ void CueSplitter::run()
 	QStringList inputFileList = m_inputFilesInfo.keys();
 	int nInputFiles = inputFileList.count();
 	
-	emit progressMaxChanged(nInputFiles);
+	int nFiles = m_model->getFileCount();
+	int nTracksTotal = 0, nTracksComplete = 0;
+
+	for(int i = 0; i < nFiles; i++)
+	{
+		nTracksTotal += m_model->getTrackCount(i);
+	}
+
+	emit progressMaxChanged(10 * nTracksTotal);
 	emit progressValChanged(0);
 
-	//Decompress all input files
+	//Decompress all input files in parallel, the tasks must outlive the pool
+	QMap<QString, QSharedPointer<CueSplitter_DecompressTask> > decompressTasks;
+	QThreadPool decompressPool;
+	decompressPool.setMaxThreadCount(qBound(1, static_cast<int>(MUtils::CPUFetaures::detect().count), qMax(1, qMin(MAX_DECOMPRESS_THREADS, nInputFiles))));
+
 	for(int i = 0; i < nInputFiles; i++)
 	{
 		const AudioFileModel_TechInfo &inputFileInfo = m_inputFilesInfo[inputFileList.at(i)].techInfo();
+		if(m_bDirectMode)
+		{
+			continue; /*tracks will be cut from the original file at encode time*/
+		}
 		if(inputFileInfo.containerType().compare("Wave", Qt::CaseInsensitive) || inputFileInfo.audioType().compare("PCM", Qt::CaseInsensitive))
 		{
-			AbstractDecoder *decoder = DecoderRegistry::lookup(inputFileInfo.containerType(), inputFileInfo.containerProfile(), inputFileInfo.audioType(), inputFileInfo.audioProfile(), inputFileInfo.audioVersion());
-			if(decoder)
-			{
-				m_activeFile = shortName(QFileInfo(inputFileList.at(i)).fileName());
-				
-				emit fileSelected(m_activeFile);
-				emit progressValChanged(i+1);
-				
-				QString tempFile = QString("%1/~%2.wav").arg(m_outputDir, MUtils::next_rand_str());
-				connect(decoder, SIGNAL(statusUpdated(int)), this, SLOT(handleUpdate(int)), Qt::DirectConnection);
-				
-				if(decoder->decode(inputFileList.at(i), tempFile, m_abortFlag))
-				{
-					m_decompressedFiles.insert(inputFileList.at(i), tempFile);
-					m_tempFiles.append(tempFile);
-				}
-				else
-				{
-					qWarning("Failed to decompress file: <%s>", inputFileList.at(i).toLatin1().constData());
-					MUtils::remove_file(tempFile);
-				}
-				
-				m_activeFile.clear();
-				MUTILS_DELETE(decoder);
-			}
-			else
-			{
-				qWarning("Unsupported input file: <%s>", inputFileList.at(i).toLatin1().constData());
-			}
+			const QString tempFile = QString("%1/~%2.wav").arg(m_outputDir, MUtils::next_rand_str());
+			m_tempFiles.append(tempFile);
+			QSharedPointer<CueSplitter_DecompressTask> task(new CueSplitter_DecompressTask(inputFileList.at(i), inputFileInfo, tempFile, m_abortFlag));
+			decompressTasks.insert(inputFileList.at(i), task);
+			decompressPool.start(task.data());
 		}
 		else
 		{
 			m_decompressedFiles.insert(inputFileList.at(i), inputFileList.at(i));
 		}
-
-		if(MUTILS_BOOLIFY(m_abortFlag))
-		{
-			m_bAborted = true;
-			qWarning("The user has requested to abort the process!");
-			return;
-		}
 	}
 
-	int nFiles = m_model->getFileCount();
-	int nTracksTotal = 0, nTracksComplete = 0;
-
-	for(int i = 0; i < nFiles; i++)
-	{
-		nTracksTotal += m_model->getTrackCount(i);
-	}
-
-	emit progressMaxChanged(10 * nTracksTotal);
-	emit progressValChanged(0);
-
 	const AudioFileModel_MetaInfo *albumInfo = m_model->getAlbumInfo();
 
 	//Now split all files
@@ -179,8 +257,29 @@ void CueSplitter::run()
 	{
 		int nTracks = m_model->getTrackCount(i);
 		QString trackFile = m_model->getFileName(i);
+		QList<track_t> tracks;
+		QSet<QString> reservedNames;
 
-		//Process all tracks
+		//Wait until this file has been decompressed
+		if(decompressTasks.contains(trackFile))
+		{
+			QSharedPointer<CueSplitter_DecompressTask> task = decompressTasks.value(trackFile);
+			m_activeFile = shortName(QFileInfo(trackFile).fileName());
+			emit fileSelected(m_activeFile);
+			if(task->waitForResult())
+			{
+				m_decompressedFiles.insert(trackFile, task->outputFile());
+			}
+			m_activeFile.clear();
+			if(MUTILS_BOOLIFY(m_abortFlag))
+			{
+				m_bAborted = true;
+				qWarning("The user has requested to abort the process!");
+				return;
+			}
+		}
+
+		//Collect all tracks
 		for(int j = 0; j < nTracks; j++)
 		{
 			const AudioFileModel_MetaInfo *trackInfo = m_model->getTrackInfo(i, j);
@@ -192,6 +291,7 @@ void CueSplitter::run()
 			if((trackNo < 0) || _isnan(trackOffset) || _isnan(trackLength))
 			{
 				qWarning("Failed to fetch information for track #%d of file #%d!", j, i);
+				emit progressValChanged(nTracksComplete += 10);
 				continue;
 			}
 			
@@ -208,14 +308,40 @@ void CueSplitter::run()
 			//Generate output file name
 			QString trackTitle = trackMetaInfo.title().isEmpty() ? QString().sprintf("Track %02d", trackNo) : trackMetaInfo.title();
 			QString outputFile = QString("%1/[%2] %3 - %4.wav").arg(m_outputDir, QString().sprintf("%02d", trackNo), MUtils::clean_file_name(m_baseName, true), MUtils::clean_file_name(trackTitle, true));
-			for(int n = 2; QFileInfo(outputFile).exists(); n++)
+			for(int n = 2; QFileInfo(outputFile).exists() || reservedNames.contains(outputFile.toLower()); n++)
 			{
 				outputFile = QString("%1/[%2] %3 - %4 (%5).wav").arg(m_outputDir, QString().sprintf("%02d", trackNo), MUtils::clean_file_name(m_baseName, true), MUtils::clean_file_name(trackTitle, true), QString::number(n));
 			}
+			reservedNames.insert(outputFile.toLower());
 
-			//Call split function
-			emit fileSelected(shortName(QFileInfo(outputFile).fileName()));
-			splitFile(outputFile, trackNo, trackFile, trackOffset, trackLength, trackMetaInfo, nTracksComplete);
+			const track_t track = { outputFile, trackNo, trackOffset, trackLength, trackMetaInfo };
+			tracks.append(track);
+		}
+
+		//Only add the tracks to the file list, they will be cut from the source at encode time
+		if(m_bDirectMode)
+		{
+			addTracks(trackFile, tracks, nTracksComplete);
+			continue;
+		}
+
+		//Split all tracks in a single pass, if the input can be read natively
+		if(splitFileNative(trackFile, tracks, nTracksComplete))
+		{
+			if(MUTILS_BOOLIFY(m_abortFlag))
+			{
+				m_bAborted = true;
+				qWarning("The user has requested to abort the process!");
+				return;
+			}
+			continue;
+		}
+
+		//Otherwise fall back to SoX, one process per track
+		for(QList<track_t>::ConstIterator iter = tracks.constBegin(); iter != tracks.constEnd(); iter++)
+		{
+			emit fileSelected(shortName(QFileInfo(iter->outputFile).fileName()));
+			splitFile(iter->outputFile, iter->trackNo, trackFile, iter->offset, iter->length, iter->metaInfo, nTracksComplete);
 			emit progressValChanged(nTracksComplete += 10);
 
 			if(MUTILS_BOOLIFY(m_abortFlag))
@@ -247,6 +373,193 @@ void CueSplitter::handleUpdate(int /*progress*/)
 // Privtae Functions
 ////////////////////////////////////////////////////////////
 
+void CueSplitter::addTracks(const QString &file, const QList<track_t> &tracks, int &progress)
+{
+	if(!m_inputFilesInfo.contains(file))
+	{
+		qWarning("Unknown or unsupported input file, skipping!");
+		m_nTracksSkipped += tracks.count();
+		emit progressValChanged(progress += (10 * tracks.count()));
+		return;
+	}
+
+	const AudioFileModel &inputFileInfo = m_inputFilesInfo[file];
+	for(QList<track_t>::ConstIterator iter = tracks.constBegin(); iter != tracks.constEnd(); iter++)
+	{
+		AudioFileModel trackFileInfo(inputFileInfo);
+		trackFileInfo.setMetaInfo(iter->metaInfo);
+		trackFileInfo.setTrack(QFileInfo(iter->outputFile).completeBaseName(), iter->offset, iter->length);
+
+		//Compute the track duration, the last track extends to the end of the file
+		const unsigned int duration = inputFileInfo.techInfo().duration();
+		const unsigned int offset = _finite(iter->offset) ? static_cast<unsigned int>(qMax(0.0, floor(iter->offset + 0.5))) : 0U;
+		trackFileInfo.techInfo().setDuration(_finite(iter->length) ? static_cast<unsigned int>(floor(iter->length + 0.5)) : ((duration > offset) ? (duration - offset) : 0U));
+
+		emit fileSelected(shortName(trackFileInfo.trackName()));
+		emit fileSplit(trackFileInfo);
+		m_nTracksSuccess++;
+		emit progressValChanged(progress += 10);
+	}
+}
+
+bool CueSplitter::splitFileNative(const QString &file, const QList<track_t> &tracks, int &progress)
+{
+	if(!m_decompressedFiles.contains(file))
+	{
+		return false;
+	}
+
+	QFile input(m_decompressedFiles[file]);
+	WaveProperties::header_t info;
+	if(!(input.open(QIODevice::ReadOnly) && WaveProperties::parseHeader(input, info)))
+	{
+		qWarning("Input can not be split natively, falling back to SoX!");
+		return false;
+	}
+
+	//Convert the track indices to sample frames
+	QList<QPair<quint64, quint64> > ranges;
+	for(QList<track_t>::ConstIterator iter = tracks.constBegin(); iter != tracks.constEnd(); iter++)
+	{
+		const quint64 first = _finite(iter->offset) ? qMin(static_cast<quint64>(qMax(0i64, qRound64(iter->offset * info.samplerate))), info.frameCount) : 0ui64;
+		const quint64 last = (_finite(iter->offset) && _finite(iter->length)) ? qMin(static_cast<quint64>(qMax(0i64, qRound64((iter->offset + iter->length) * info.samplerate))), info.frameCount) : info.frameCount;
+		if((last < first) || ((last - first) * info.blockAlign > MAX_RIFF_DATA_SIZE))
+		{
+			qWarning("Track %02d can not be represented as RIFF Wave, falling back to SoX!", iter->trackNo);
+			return false;
+		}
+		ranges.append(qMakePair(first, last));
+	}
+
+	qDebug("Splitting \"%s\" natively: %u tracks, %llu frames.", MUTILS_UTF8(input.fileName()), tracks.count(), info.frameCount);
+
+	QVector<QFile*> outputs(tracks.count(), NULL);
+	QVector<bool> done(tracks.count(), false);
+	QByteArray buffer(qMax(1, NATIVE_BUFFER_SIZE / info.blockAlign) * info.blockAlign, '\0');
+	const int baseProgress = progress;
+	quint64 position = 0;
+	int remaining = tracks.count();
+
+	while((remaining > 0) && (!MUTILS_BOOLIFY(m_abortFlag)))
+	{
+		//Skip ahead to the next track, if currently no track is active
+		quint64 nextStart = info.frameCount, nextEnd = 0;
+		for(int k = 0; k < tracks.count(); k++)
+		{
+			if(!done[k])
+			{
+				nextStart = qMin(nextStart, ranges[k].first);
+				nextEnd = qMax(nextEnd, ranges[k].second);
+			}
+		}
+		if(nextStart > position)
+		{
+			position = nextStart;
+		}
+
+		//Open outputs of all tracks starting here, finish the empty ones
+		for(int k = 0; k < tracks.count(); k++)
+		{
+			if(done[k] || outputs[k] || (ranges[k].first > position))
+			{
+				continue;
+			}
+			emit fileSelected(shortName(QFileInfo(tracks[k].outputFile).fileName()));
+			outputs[k] = new QFile(tracks[k].outputFile);
+			if(!(outputs[k]->open(QIODevice::WriteOnly | QIODevice::Truncate) && writeWaveHeader(*outputs[k], info, 0)))
+			{
+				qWarning("Failed to create output file: <%s>", MUTILS_UTF8(tracks[k].outputFile));
+				MUTILS_DELETE(outputs[k]);
+				done[k] = true;
+				remaining--;
+				m_nTracksSkipped++;
+				emit progressValChanged(progress += 10);
+			}
+		}
+
+		//Read the next block, but not beyond the end of the last track
+		const quint64 frames = qMin(static_cast<quint64>(buffer.size() / info.blockAlign), ((nextEnd > position) ? (nextEnd - position) : 0ui64));
+		qint64 bytesRead = 0;
+		if(frames > 0)
+		{
+			if(input.pos() != info.dataOffset + static_cast<qint64>(position * info.blockAlign))
+			{
+				input.seek(info.dataOffset + static_cast<qint64>(position * info.blockAlign));
+			}
+			bytesRead = qMax(0i64, input.read(buffer.data(), static_cast<qint64>(frames * info.blockAlign)));
+		}
+		const quint64 framesRead = static_cast<quint64>(bytesRead) / info.blockAlign;
+
+		//Write the block to all tracks that overlap with it, then finish the completed tracks
+		for(int k = 0; k < tracks.count(); k++)
+		{
+			if(done[k] || (!outputs[k]))
+			{
+				continue;
+			}
+			const quint64 first = qMax(position, ranges[k].first), last = qMin(position + framesRead, ranges[k].second);
+			bool success = true;
+			if(last > first)
+			{
+				const qint64 length = static_cast<qint64>((last - first) * info.blockAlign);
+				success = (outputs[k]->write(buffer.constData() + static_cast<int>((first - position) * info.blockAlign), length) == length);
+			}
+			if(success && (ranges[k].second > position + framesRead) && (framesRead > 0))
+			{
+				continue; /*track not complete yet*/
+			}
+			const quint64 dataSize = (ranges[k].second - ranges[k].first) * info.blockAlign;
+			success = success && (dataSize > 0) && (ranges[k].second <= position + framesRead) && writeWaveHeader(*outputs[k], info, dataSize);
+			outputs[k]->close();
+			MUTILS_DELETE(outputs[k]);
+			done[k] = true;
+			remaining--;
+			if(success)
+			{
+				AudioFileModel outFileInfo(tracks[k].outputFile);
+				outFileInfo.setMetaInfo(tracks[k].metaInfo);
+				AudioFileModel_TechInfo &outFileTechInfo = outFileInfo.techInfo();
+				outFileTechInfo.setContainerType("Wave");
+				outFileTechInfo.setAudioType("PCM");
+				outFileTechInfo.setAudioChannels(info.channels);
+				outFileTechInfo.setAudioSamplerate(info.samplerate);
+				outFileTechInfo.setAudioBitdepth(((info.formatTag == 0x0003) && (info.bitsPerSample == 32)) ? AudioFileModel::BITDEPTH_IEEE_FLOAT32 : info.bitsPerSample);
+				outFileTechInfo.setDuration(static_cast<unsigned int>((ranges[k].second - ranges[k].first) / info.samplerate));
+				emit fileSplit(outFileInfo);
+				m_nTracksSuccess++;
+			}
+			else
+			{
+				qWarning("Splitting has failed for track %02d !!!", tracks[k].trackNo);
+				MUtils::remove_file(tracks[k].outputFile);
+				m_nTracksSkipped++;
+			}
+		}
+
+		position += framesRead;
+		const int newProgress = baseProgress + static_cast<int>((10ui64 * tracks.count() * qMin(position, info.frameCount)) / qMax(1ui64, info.frameCount));
+		if(newProgress > progress)
+		{
+			emit progressValChanged(progress = newProgress);
+		}
+	}
+
+	//Clean up the incomplete outputs, if the process was aborted
+	for(int k = 0; k < tracks.count(); k++)
+	{
+		if(outputs[k])
+		{
+			outputs[k]->close();
+			MUTILS_DELETE(outputs[k]);
+			MUtils::remove_file(tracks[k].outputFile);
+		}
+	}
+
+	progress = baseProgress + (10 * tracks.count());
+	emit progressValChanged(progress);
+	return true;
+}
+
 void CueSplitter::splitFile(const QString &output, const int trackNo, const QString &file, const double offset, const double length, const AudioFileModel_MetaInfo &metaInfo, const int baseProgress)
 {
 	qDebug("[Track %02d]", trackNo);
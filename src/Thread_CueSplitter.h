@@ -50,6 +50,7 @@ public:
 	unsigned int getTracksSkipped(void) { return m_nTracksSkipped; }
 	bool getSuccess(void) { return !isRunning() && m_bSuccess; }
 	bool getAborted(void) { return m_bAborted; }
+	void setDirectMode(const bool direct) { m_bDirectMode = direct; }
 
 signals:
 	void fileSelected(const QString &fileName);
@@ -64,6 +65,10 @@ public slots:
 	void abortProcess(void) { m_abortFlag.ref(); }
 
 private:
+	struct track_t;
+
+	void addTracks(const QString &file, const QList<track_t> &tracks, int &progress);
+	bool splitFileNative(const QString &file, const QList<track_t> &tracks, int &progress);
 	void splitFile(const QString &output, const int trackNo, const QString &file, const double offset, const double length, const AudioFileModel_MetaInfo &metaInfo, const int baseProgress);
 	QString indexToString(const double index) const;
 	QString shortName(const QString &longName) const;
@@ -78,6 +83,7 @@ private:
 
 	bool m_bAborted;
 	bool m_bSuccess;
+	bool m_bDirectMode;
 	
 	QAtomicInt m_abortFlag;
 
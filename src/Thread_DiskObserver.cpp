@@ -34,6 +34,12 @@
 //Qt
 #include <QDir>
 
+//Windows includes
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <WinIoCtl.h>
+
 #define MIN_DISKSPACE 104857600ui64 //100 MB
 
 ////////////////////////////////////////////////////////////
@@ -80,6 +86,20 @@ void DiskObserverThread::observe(void)
 {
 	quint64 minimumSpace = MIN_DISKSPACE;
 	quint64 previousSpace = quint64(-1);
+	double previousLoad = -1.0;
+	LONGLONG idleTime[2] = { 0, 0 }, queryTime[2] = { 0, 0 };
+
+	//Open volume for querying the disk performance counters (no access rights required)
+	const QString volumeName = makeVolumeName(m_path);
+	HANDLE hVolume = INVALID_HANDLE_VALUE;
+	if(!volumeName.isEmpty())
+	{
+		hVolume = CreateFileW(MUTILS_WCHR(volumeName), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+		if(hVolume == INVALID_HANDLE_VALUE)
+		{
+			qWarning("Failed to open volume '%s', disk load will not be available!", MUTILS_UTF8(volumeName));
+		}
+	}
 
 	forever
 	{
@@ -98,8 +118,40 @@ void DiskObserverThread::observe(void)
 				previousSpace = freeSpace;
 			}
 		}
+		if(hVolume != INVALID_HANDLE_VALUE)
+		{
+			DISK_PERFORMANCE diskPerf;
+			DWORD bytesReturned = 0;
+			if(DeviceIoControl(hVolume, IOCTL_DISK_PERFORMANCE, NULL, 0, &diskPerf, sizeof(DISK_PERFORMANCE), &bytesReturned, NULL))
+			{
+				idleTime[1]  = idleTime[0];  idleTime[0]  = diskPerf.IdleTime.QuadPart;
+				queryTime[1] = queryTime[0]; queryTime[0] = diskPerf.QueryTime.QuadPart;
+				const LONGLONG timeIdl = idleTime[0]  - idleTime[1];
+				const LONGLONG timeSum = queryTime[0] - queryTime[1];
+				if((queryTime[1] > 0) && (timeSum > 0))
+				{
+					const double current = qBound(0.0, 1.0 - (static_cast<double>(timeIdl) / static_cast<double>(timeSum)), 1.0);
+					if(current != previousLoad)
+					{
+						emit diskLoadChanged(current);
+						previousLoad = current;
+					}
+				}
+			}
+			else
+			{
+				qWarning("Disk performance counters are not available for '%s'!", MUTILS_UTF8(volumeName));
+				CloseHandle(hVolume);
+				hVolume = INVALID_HANDLE_VALUE;
+			}
+		}
 		if(m_semaphore.tryAcquire(1, 2000)) break;
 	}
+
+	if(hVolume != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(hVolume);
+	}
 }
 
 QString DiskObserverThread::makeRootDir(const QString &baseDir)
@@ -121,6 +173,16 @@ QString DiskObserverThread::makeRootDir(const QString &baseDir)
 	return dir.canonicalPath();
 }
 
+QString DiskObserverThread::makeVolumeName(const QString &rootDir)
+{
+	if((rootDir.length() >= 2) && rootDir.at(0).isLetter() && (rootDir.at(1) == QLatin1Char(':')))
+	{
+		return QString("\\\\.\\%1:").arg(rootDir.at(0).toUpper());
+	}
+
+	return QString(); /*not a local drive*/
+}
+
 ////////////////////////////////////////////////////////////
 // SLOTS
 ////////////////////////////////////////////////////////////
@@ -40,10 +40,12 @@ protected:
 	void observe(void);
 
 	static QString makeRootDir(const QString &baseDir);
+	static QString makeVolumeName(const QString &rootDir);
 
 signals:
 	void messageLogged(const QString &text, int type);
 	void freeSpaceChanged(const quint64);
+	void diskLoadChanged(const double);
 
 private:
 	QSemaphore m_semaphore;
@@ -26,6 +26,7 @@
 #include "Global.h"
 #include "LockedFile.h"
 #include "Model_AudioFile.h"
+#include "Model_AnalysisCache.h"
 #include "Thread_FileAnalyzer_Task.h"
 #include "PlaylistImporter.h"
 
@@ -47,6 +48,9 @@
 #include <QTimer>
 #include <QQueue>
 
+//Maximum number of files per analyzer task
+static const int MAX_BATCH_SIZE = 32;
+
 //Insert into QStringList *without* duplicates
 static inline void SAFE_APPEND_STRING(QStringList &list, const QString &str)
 {
@@ -150,6 +154,9 @@ void FileAnalyzer::run()
 	//Wait for pending tasks to complete
 	m_pool->waitForDone();
 
+	//Write back new analysis results
+	AnalysisCache::flush();
+
 	//Was opertaion aborted?
 	if(MUTILS_BOOLIFY(m_bAborted))
 	{
@@ -184,16 +191,24 @@ bool FileAnalyzer::analyzeNextFile(void)
 {
 	if(!(m_inputFiles.isEmpty() || MUTILS_BOOLIFY(m_bAborted)))
 	{
-		const unsigned int taskId = m_tasksCounterNext++;
-		const QString currentFile = QDir::fromNativeSeparators(m_inputFiles.takeFirst());
+		//Split the remaining files evenly across the threads, but pass several files to each MediaInfo invocation
+		const int batchSize = qBound(1, m_inputFiles.count() / qMax(1, m_pool->maxThreadCount()), MAX_BATCH_SIZE);
+		const unsigned int taskId = m_tasksCounterNext;
+
+		QStringList currentFiles;
+		while((currentFiles.count() < batchSize) && (!m_inputFiles.isEmpty()))
+		{
+			currentFiles << QDir::fromNativeSeparators(m_inputFiles.takeFirst());
+		}
+		m_tasksCounterNext += currentFiles.count();
 
 		if((!m_timer->isValid()) || (m_timer->elapsed() >= 333))
 		{
-			emit fileSelected(QFileInfo(currentFile).fileName());
+			emit fileSelected(QFileInfo(currentFiles.first()).fileName());
 			m_timer->restart();
 		}
 	
-		AnalyzeTask *task = new AnalyzeTask(taskId, currentFile, m_bAborted);
+		AnalyzeTask *task = new AnalyzeTask(taskId, currentFiles, m_bAborted);
 		connect(task, SIGNAL(fileAnalyzed(const unsigned int, const int, AudioFileModel)), this, SLOT(taskFileAnalyzed(unsigned int, const int, AudioFileModel)), Qt::QueuedConnection);
 		connect(task, SIGNAL(taskCompleted(const unsigned int)), this, SLOT(taskThreadFinish(const unsigned int)), Qt::QueuedConnection);
 		m_runningTaskIds.insert(taskId); m_pool->start(task);
@@ -270,6 +285,7 @@ void FileAnalyzer::initializeTasks(void)
 void FileAnalyzer::taskFileAnalyzed(const unsigned int taskId, const int fileType, const AudioFileModel &file)
 {
 	m_completedTaskIds.insert(taskId);
+	emit progressValChanged(++m_completedCounter);
 
 	switch(fileType)
 	{
@@ -316,7 +332,6 @@ void FileAnalyzer::taskFileAnalyzed(const unsigned int taskId, const int fileTyp
 void FileAnalyzer::taskThreadFinish(const unsigned int taskId)
 {
 	m_runningTaskIds.remove(taskId);
-	emit progressValChanged(++m_completedCounter);
 
 	if(!analyzeNextFile())
 	{
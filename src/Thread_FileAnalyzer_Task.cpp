@@ -26,7 +26,7 @@
 #include "Global.h"
 #include "LockedFile.h"
 #include "Model_AudioFile.h"
-#include "MimeTypes.h"
+#include "Model_AnalysisCache.h"
 
 //MUtils
 #include <MUtils/Global.h>
@@ -49,6 +49,9 @@
 #include <QXmlInputSource>
 #include <QXmlStreamReader>
 #include <QStack>
+#include <QVector>
+#include <QTextCodec>
+#include <QtEndian>
 
 //CRT
 #include <math.h>
@@ -79,6 +82,7 @@ while(0)
 while(0)
 
 #define DIV_RND(A,B) (((A) + ((B) / 2U)) / (B))
+#define MAX_CMDLINE_LEN 16384
 #define STRICMP(A,B) ((A).compare((B), Qt::CaseInsensitive) == 0)
 
 ////////////////////////////////////////////////////////////
@@ -112,8 +116,7 @@ static MUtils::Lazy<const QMap<QPair<AnalyzeTask::MI_trackType_t, QString>, Anal
 	ADD_PROPTERY_MAPPING_1(aud, bitrate);
 	ADD_PROPTERY_MAPPING_1(aud, bitrate_mode);
 	ADD_PROPTERY_MAPPING_1(aud, encoded_library);
-	ADD_PROPTERY_MAPPING_2(gen, cover_mime, cover_mime);
-	ADD_PROPTERY_MAPPING_2(gen, cover_data, cover_data);
+	ADD_PROPTERY_MAPPING_1(gen, cover);
 	return builder;
 });
 
@@ -127,16 +130,6 @@ static MUtils::Lazy<const QMap<QString, AnalyzeTask::MI_propertyId_t>> s_avisynt
 	return builder;
 });
 
-static MUtils::Lazy<const QMap<QString, QString>> s_mimeTypes([]
-{
-	QMap<QString, QString> *const builder = new QMap<QString, QString>();
-	for (size_t i = 0U; MIME_TYPES[i].type; ++i)
-	{
-		builder->insert(QString::fromLatin1(MIME_TYPES[i].type), QString::fromLatin1(MIME_TYPES[i].ext[0]));
-	}
-	return builder;
-});
-
 static MUtils::Lazy<const QMap<QString, AnalyzeTask::MI_trackType_t>> s_trackTypes([]
 {
 	QMap<QString, AnalyzeTask::MI_trackType_t> *const builder = new QMap<QString, AnalyzeTask::MI_trackType_t>();
@@ -149,17 +142,16 @@ static MUtils::Lazy<const QMap<QString, AnalyzeTask::MI_trackType_t>> s_trackTyp
 // Constructor
 ////////////////////////////////////////////////////////////
 
-AnalyzeTask::AnalyzeTask(const int taskId, const QString &inputFile, QAtomicInt &abortFlag)
+AnalyzeTask::AnalyzeTask(const int taskId, const QStringList &inputFiles, QAtomicInt &abortFlag)
 :
 	m_taskId(taskId),
-	m_inputFile(inputFile),
+	m_inputFiles(inputFiles),
 	m_mediaInfoBin(lamexp_tools_lookup("mediainfo.exe")),
 	m_mediaInfoVer(lamexp_tools_version("mediainfo.exe")),
 	m_avs2wavBin(lamexp_tools_lookup("avs2wav.exe")),
 	m_abortFlag(abortFlag),
 	m_mediaInfoIdx(*s_mediaInfoIdx),
 	m_avisynthIdx(*s_avisynthIdx),
-	m_mimeTypes(*s_mimeTypes),
 	m_trackTypes(*s_trackTypes)
 {
 	if(m_mediaInfoBin.isEmpty() || m_avs2wavBin.isEmpty())
@@ -197,12 +189,42 @@ void AnalyzeTask::run()
 
 void AnalyzeTask::run_ex(void)
 {
-	int fileType = fileTypeNormal;
-	QString currentFile = QDir::fromNativeSeparators(m_inputFile);
-	qDebug("Analyzing: %s", MUTILS_UTF8(currentFile));
-	
-	AudioFileModel fileInfo(currentFile);
-	analyzeFile(currentFile, fileInfo, &fileType);
+	const int fileCount = m_inputFiles.count();
+	QList<AudioFileModel> fileInfo;
+	QVector<int> fileType(fileCount, int(fileTypeNormal));
+	QList<int> pendingFiles;
+
+	for(int i = 0; i < fileCount; i++)
+	{
+		const QString currentFile = QDir::fromNativeSeparators(m_inputFiles.at(i));
+		qDebug("Analyzing: %s", MUTILS_UTF8(currentFile));
+		fileInfo << AudioFileModel(currentFile);
+		if(!analyzeFile(currentFile, fileInfo[i], &fileType[i]))
+		{
+			pendingFiles << i;
+		}
+	}
+
+	//Analyze the remaining files with MediaInfo, passing as many files per invocation as possible
+	while(!(pendingFiles.isEmpty() || MUTILS_BOOLIFY(m_abortFlag)))
+	{
+		QList<AudioFileModel*> batch;
+		int cmdLength = 0;
+		while((!pendingFiles.isEmpty()) && (batch.isEmpty() || (cmdLength + fileInfo[pendingFiles.first()].filePath().length() < MAX_CMDLINE_LEN)))
+		{
+			AudioFileModel *const audioFile = &fileInfo[pendingFiles.takeFirst()];
+			cmdLength += audioFile->filePath().length() + 3;
+			batch << audioFile;
+		}
+		analyzeMediaFiles(batch);
+		for(QList<AudioFileModel*>::ConstIterator iter = batch.constBegin(); iter != batch.constEnd(); iter++)
+		{
+			if(!(MUTILS_BOOLIFY(m_abortFlag) || (*iter)->metaInfo().title().isEmpty() || (*iter)->techInfo().containerType().isEmpty() || (*iter)->techInfo().audioType().isEmpty()))
+			{
+				AnalysisCache::insert((*iter)->filePath(), *(*iter));
+			}
+		}
+	}
 
 	if(MUTILS_BOOLIFY(m_abortFlag))
 	{
@@ -210,52 +232,56 @@ void AnalyzeTask::run_ex(void)
 		return;
 	}
 
-	switch(fileType)
+	for(int i = 0; i < fileCount; i++)
 	{
-	case fileTypeDenied:
-		qWarning("Cannot access file for reading, skipping!");
-		break;
-	case fileTypeCDDA:
-		qWarning("Dummy CDDA file detected, skipping!");
-		break;
-	default:
-		if(fileInfo.metaInfo().title().isEmpty() || fileInfo.techInfo().containerType().isEmpty() || fileInfo.techInfo().audioType().isEmpty())
+		const QString &currentFile = fileInfo[i].filePath();
+		switch(fileType[i])
 		{
-			fileType = fileTypeUnknown;
-			if(!QFileInfo(currentFile).suffix().compare("cue", Qt::CaseInsensitive))
-			{
-				qWarning("Cue Sheet file detected, skipping!");
-				fileType = fileTypeCueSheet;
-			}
-			else if(!QFileInfo(currentFile).suffix().compare("avs", Qt::CaseInsensitive))
+		case fileTypeDenied:
+			qWarning("Cannot access file for reading, skipping!");
+			break;
+		case fileTypeCDDA:
+			qWarning("Dummy CDDA file detected, skipping!");
+			break;
+		default:
+			if(fileInfo[i].metaInfo().title().isEmpty() || fileInfo[i].techInfo().containerType().isEmpty() || fileInfo[i].techInfo().audioType().isEmpty())
 			{
-				qDebug("Found a potential Avisynth script, investigating...");
-				if(analyzeAvisynthFile(currentFile, fileInfo))
+				fileType[i] = fileTypeUnknown;
+				if(!QFileInfo(currentFile).suffix().compare("cue", Qt::CaseInsensitive))
 				{
-					fileType = fileTypeNormal;
+					qWarning("Cue Sheet file detected, skipping!");
+					fileType[i] = fileTypeCueSheet;
+				}
+				else if(!QFileInfo(currentFile).suffix().compare("avs", Qt::CaseInsensitive))
+				{
+					qDebug("Found a potential Avisynth script, investigating...");
+					if(analyzeAvisynthFile(currentFile, fileInfo[i]))
+					{
+						fileType[i] = fileTypeNormal;
+					}
+					else
+					{
+						qDebug("Rejected Avisynth file: %s", MUTILS_UTF8(fileInfo[i].filePath()));
+					}
 				}
 				else
 				{
-					qDebug("Rejected Avisynth file: %s", MUTILS_UTF8(fileInfo.filePath()));
+					qDebug("Rejected file of unknown type: %s", MUTILS_UTF8(fileInfo[i].filePath()));
 				}
 			}
-			else
-			{
-				qDebug("Rejected file of unknown type: %s", MUTILS_UTF8(fileInfo.filePath()));
-			}
+			break;
 		}
-		break;
-	}
 
-	//Emit the file now!
-	emit fileAnalyzed(m_taskId, fileType, fileInfo);
+		//Emit the file now!
+		emit fileAnalyzed(m_taskId + i, fileType[i], fileInfo[i]);
+	}
 }
 
 ////////////////////////////////////////////////////////////
 // Privtae Functions
 ////////////////////////////////////////////////////////////
 
-const AudioFileModel& AnalyzeTask::analyzeFile(const QString &filePath, AudioFileModel &audioFile, int *const type)
+bool AnalyzeTask::analyzeFile(const QString &filePath, AudioFileModel &audioFile, int *const type)
 {
 	*type = fileTypeNormal;
 	QFile readTest(filePath);
@@ -263,28 +289,47 @@ const AudioFileModel& AnalyzeTask::analyzeFile(const QString &filePath, AudioFil
 	if (!readTest.open(QIODevice::ReadOnly))
 	{
 		*type = fileTypeDenied;
-		return audioFile;
+		return true;
 	}
 
 	if (checkFile_CDDA(readTest))
 	{
 		*type = fileTypeCDDA;
-		return audioFile;
+		return true;
 	}
 
 	readTest.close();
-	return analyzeMediaFile(filePath, audioFile);
+
+	if (AnalysisCache::lookup(filePath, audioFile))
+	{
+		qDebug("Analysis result retrieved from cache.");
+		return true;
+	}
+
+	if (analyzeNativeFile(filePath, audioFile))
+	{
+		qDebug("File header was analyzed natively.");
+		if (!(audioFile.metaInfo().title().isEmpty() || audioFile.techInfo().containerType().isEmpty() || audioFile.techInfo().audioType().isEmpty()))
+		{
+			AnalysisCache::insert(filePath, audioFile);
+		}
+		return true;
+	}
+
+	return false; /*requires MediaInfo*/
 }
 
-const AudioFileModel& AnalyzeTask::analyzeMediaFile(const QString &filePath, AudioFileModel &audioFile)
+void AnalyzeTask::analyzeMediaFiles(const QList<AudioFileModel*> &audioFiles)
 {
 	//bool skipNext = false;
 	QPair<quint32, quint32> id_val(UINT_MAX, UINT_MAX);
-	QByteArray coverData;
 
 	QStringList params;
-	params << L1S("--Language=raw") << L1S("--Output=XML") << L1S("--Full") << L1S("--Cover_Data=base64");
-	params << QDir::toNativeSeparators(filePath);
+	params << L1S("--Language=raw") << L1S("--Output=XML") << L1S("--Full");
+	for (QList<AudioFileModel*>::ConstIterator iter = audioFiles.constBegin(); iter != audioFiles.constEnd(); ++iter)
+	{
+		params << QDir::toNativeSeparators((*iter)->filePath());
+	}
 
 	QProcess process;
 	MUtils::init_process(process, QFileInfo(m_mediaInfoBin).absolutePath());
@@ -299,7 +344,7 @@ const AudioFileModel& AnalyzeTask::analyzeMediaFile(const QString &filePath, Aud
 		qWarning("Error message: \"%s\"\n", process.errorString().toLatin1().constData());
 		process.kill();
 		process.waitForFinished(-1);
-		return audioFile;
+		return;
 	}
 
 	while(process.state() != QProcess::NotRunning)
@@ -352,13 +397,14 @@ const AudioFileModel& AnalyzeTask::analyzeMediaFile(const QString &filePath, Aud
 	qDebug("-----BEGIN MEDIAINFO-----\n%s\n-----END MEDIAINFO-----", data.constData());
 #endif //MUTILS_DEBUG
 
-	return parseMediaInfo(data, audioFile);
+	parseMediaInfo(data, audioFiles);
 }
 
-const AudioFileModel& AnalyzeTask::parseMediaInfo(const QByteArray &data, AudioFileModel &audioFile)
+void AnalyzeTask::parseMediaInfo(const QByteArray &data, const QList<AudioFileModel*> &audioFiles)
 {
 	QXmlStreamReader xmlStream(data);
-	bool firstMediaFile = true;
+	QVector<bool> mediaFound(audioFiles.count(), false);
+	int nextIndex = 0;
 
 	if (findNextElement(QLatin1String("MediaInfo"), xmlStream))
 	{
@@ -366,7 +412,7 @@ const AudioFileModel& AnalyzeTask::parseMediaInfo(const QByteArray &data, AudioF
 		if (versionXml.isEmpty() || (!checkVersionStr(versionXml, 2U, 0U)))
 		{
 			qWarning("Invalid file format version property: \"%s\"", MUTILS_UTF8(versionXml));
-			return audioFile;
+			return;
 		}
 		if (findNextElement(QLatin1String("CreatingLibrary"), xmlStream))
 		{
@@ -375,7 +421,7 @@ const AudioFileModel& AnalyzeTask::parseMediaInfo(const QByteArray &data, AudioF
 			if (!STRICMP(identifier, QLatin1String("MediaInfoLib")))
 			{
 				qWarning("Invalid library identiofier property: \"%s\"", MUTILS_UTF8(identifier));
-				return audioFile;
+				return;
 			}
 			if (!versionLib.isEmpty())
 			{
@@ -385,21 +431,28 @@ const AudioFileModel& AnalyzeTask::parseMediaInfo(const QByteArray &data, AudioF
 					if (!checkVersionStr(versionLib, mediaInfoVer / 100U, mediaInfoVer % 100U))
 					{
 						qWarning("Invalid library version property: \"%s\"", MUTILS_UTF8(versionLib));
-						return audioFile;
+						return;
 					}
 				}
 			}
 			else
 			{
 				qWarning("Library version property not found!");
-				return audioFile;
+				return;
 			}
 			while (findNextElement(QLatin1String("Media"), xmlStream))
 			{
-				if (firstMediaFile || audioFile.techInfo().containerType().isEmpty() || audioFile.techInfo().audioType().isEmpty())
+				const int index = findMediaIndex(findAttribute(QLatin1String("ref"), xmlStream.attributes()), audioFiles, nextIndex);
+				if (index < 0)
 				{
-					firstMediaFile = false;
-					parseFileInfo(xmlStream, audioFile);
+					qWarning("Skipping unrelated file!");
+					xmlStream.skipCurrentElement();
+				}
+				else if ((!mediaFound[index]) || audioFiles[index]->techInfo().containerType().isEmpty() || audioFiles[index]->techInfo().audioType().isEmpty())
+				{
+					mediaFound[index] = true;
+					nextIndex = qMax(nextIndex, index + 1);
+					parseFileInfo(xmlStream, *audioFiles[index]);
 				}
 				else
 				{
@@ -410,6 +463,31 @@ const AudioFileModel& AnalyzeTask::parseMediaInfo(const QByteArray &data, AudioF
 		}
 	}
 
+	for (QList<AudioFileModel*>::ConstIterator iter = audioFiles.constBegin(); iter != audioFiles.constEnd(); ++iter)
+	{
+		completeFileInfo(*(*iter));
+	}
+}
+
+int AnalyzeTask::findMediaIndex(const QString &ref, const QList<AudioFileModel*> &audioFiles, const int nextIndex)
+{
+	if (ref.isEmpty())
+	{
+		return (nextIndex < audioFiles.count()) ? nextIndex : (-1);
+	}
+	const QString filePath = QDir::fromNativeSeparators(ref);
+	for (int i = 0; i < audioFiles.count(); ++i)
+	{
+		if (STRICMP(audioFiles[i]->filePath(), filePath))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+const AudioFileModel& AnalyzeTask::completeFileInfo(AudioFileModel &audioFile)
+{
 	if (!(audioFile.techInfo().containerType().isEmpty() || audioFile.techInfo().audioType().isEmpty()))
 	{
 		if (audioFile.metaInfo().title().isEmpty())
@@ -470,7 +548,6 @@ void AnalyzeTask::parseFileInfo(QXmlStreamReader &xmlStream, AudioFileModel &aud
 
 void AnalyzeTask::parseTrackInfo(QXmlStreamReader &xmlStream, const MI_trackType_t trackType, AudioFileModel &audioFile)
 {
-	QString coverMimeType;
 	while (xmlStream.readNextStartElement())
 	{
 		const MI_propertyId_t idx = m_mediaInfoIdx.value(qMakePair(trackType, xmlStream.name().toString().simplified().toLower()), MI_propertyId_t(-1));
@@ -480,7 +557,7 @@ void AnalyzeTask::parseTrackInfo(QXmlStreamReader &xmlStream, const MI_trackType
 			const QString value = xmlStream.readElementText(QXmlStreamReader::SkipChildElements).simplified();
 			if (!value.isEmpty())
 			{
-				parseProperty(encoding.isEmpty() ? value : decodeStr(value, encoding), idx, audioFile, coverMimeType);
+				parseProperty(encoding.isEmpty() ? value : decodeStr(value, encoding), idx, audioFile);
 			}
 		}
 		else
@@ -490,7 +567,7 @@ void AnalyzeTask::parseTrackInfo(QXmlStreamReader &xmlStream, const MI_trackType
 	}
 }
 
-void AnalyzeTask::parseProperty(const QString &value, const MI_propertyId_t propertyIdx, AudioFileModel &audioFile, QString &coverMimeType)
+void AnalyzeTask::parseProperty(const QString &value, const MI_propertyId_t propertyIdx, AudioFileModel &audioFile)
 {
 #if MUTILS_DEBUG
 	qDebug("Property #%d = \"%s\"", propertyIdx, MUTILS_UTF8(value.left(24)));
@@ -516,8 +593,7 @@ void AnalyzeTask::parseProperty(const QString &value, const MI_propertyId_t prop
 		case propertyId_bitrate:           SET_OPTIONAL(quint32, parseUnsigned(value, _tmp), audioFile.techInfo().setAudioBitrate(DIV_RND(_tmp, 1000U))); return;
 		case propertyId_bitrate_mode:      SET_OPTIONAL(quint32, parseRCMode(value, _tmp), audioFile.techInfo().setAudioBitrateMode(_tmp));               return;
 		case propertyId_encoded_library:   audioFile.techInfo().setAudioEncodeLib(cleanAsciiStr(value));                                                  return;
-		case propertyId_cover_mime:        coverMimeType = value;                                                                                         return;
-		case propertyId_cover_data:        retrieveCover(audioFile, coverMimeType, value);                                                                return;
+		case propertyId_cover:             if (STRICMP(value, QLatin1String("Yes"))) audioFile.metaInfo().setCoverSource(audioFile.filePath());          return;
 		default: MUTILS_THROW_FMT("Invalid property ID: %d", propertyIdx);
 	}
 }
@@ -534,27 +610,796 @@ bool AnalyzeTask::checkFile_CDDA(QFile &file)
 	return ((i >= 0) && (j >= 0) && (k >= 0) && (k > j) && (j > i));
 }
 
-void AnalyzeTask::retrieveCover(AudioFileModel &audioFile, const QString &coverType, const QString &coverData)
+// ---------------------------------------------------------
+// Native Probing
+// ---------------------------------------------------------
+
+#define PROBE_MAX_TAGSIZE 0x100000
+#define PROBE_MAX_CHUNKS  64
+#define PROBE_SYNC_SEARCH 8192
+#define PROBE_OGG_TAIL    65536
+
+static inline quint16 LE16(const QByteArray &data, const int offset) { return qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(data.constData()) + offset); }
+static inline quint32 LE32(const QByteArray &data, const int offset) { return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data.constData()) + offset); }
+static inline qint64  LE64(const QByteArray &data, const int offset) { return qFromLittleEndian<qint64> (reinterpret_cast<const uchar*>(data.constData()) + offset); }
+static inline quint16 BE16(const QByteArray &data, const int offset) { return qFromBigEndian<quint16>(reinterpret_cast<const uchar*>(data.constData()) + offset); }
+static inline quint32 BE32(const QByteArray &data, const int offset) { return qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data.constData()) + offset); }
+static inline quint32 BE24(const QByteArray &data, const int offset) { return BE32(data, offset - 1) & 0xFFFFFF; }
+
+static inline quint32 SYNCSAFE32(const QByteArray &data, const int offset)
+{
+	const quint32 value = BE32(data, offset);
+	return ((value & 0x7F000000) >> 3) | ((value & 0x7F0000) >> 2) | ((value & 0x7F00) >> 1) | (value & 0x7F);
+}
+
+static const char *const ID3_GENRES[] =
+{
+	"Blues", "Classic Rock", "Country", "Dance", "Disco", "Funk", "Grunge", "Hip-Hop", "Jazz", "Metal",
+	"New Age", "Oldies", "Other", "Pop", "R&B", "Rap", "Reggae", "Rock", "Techno", "Industrial",
+	"Alternative", "Ska", "Death Metal", "Pranks", "Soundtrack", "Euro-Techno", "Ambient", "Trip-Hop", "Vocal", "Jazz+Funk",
+	"Fusion", "Trance", "Classical", "Instrumental", "Acid", "House", "Game", "Sound Clip", "Gospel", "Noise",
+	"AlternRock", "Bass", "Soul", "Punk", "Space", "Meditative", "Instrumental Pop", "Instrumental Rock", "Ethnic", "Gothic",
+	"Darkwave", "Techno-Industrial", "Electronic", "Pop-Folk", "Eurodance", "Dream", "Southern Rock", "Comedy", "Cult", "Gangsta",
+	"Top 40", "Christian Rap", "Pop/Funk", "Jungle", "Native American", "Cabaret", "New Wave", "Psychadelic", "Rave", "Showtunes",
+	"Trailer", "Lo-Fi", "Tribal", "Acid Punk", "Acid Jazz", "Polka", "Retro", "Musical", "Rock & Roll", "Hard Rock", NULL
+};
+
+static const quint16 MPEG_BITRATES[2][3][16] =
+{
+	{
+		{ 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+		{ 0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+		{ 0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 0 }
+	},
+	{
+		{ 0, 32, 48, 56,  64,  80,  96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+		{ 0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+		{ 0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160, 0 }
+	}
+};
+
+static const quint32 MPEG_SAMPLERATES[4][3] =
+{
+	{ 11025, 12000,  8000 }, /*MPEG-2.5*/
+	{     0,     0,     0 }, /*reserved*/
+	{ 22050, 24000, 16000 }, /*MPEG-2  */
+	{ 44100, 48000, 32000 }  /*MPEG-1  */
+};
+
+typedef struct
+{
+	quint32 version;
+	quint32 layer;
+	quint32 bitrate;
+	quint32 samplerate;
+	quint32 channels;
+	quint32 frameSize;
+	quint32 samplesPerFrame;
+	quint32 sideInfoSize;
+}
+mpeg_header_t;
+
+static bool parse_mpeg_header(const QByteArray &data, const int offset, mpeg_header_t &header)
+{
+	if ((offset < 0) || (offset + 4 > data.size()))
+	{
+		return false;
+	}
+
+	const quint32 value = BE32(data, offset);
+	const quint32 version = (value >> 19) & 0x3, layerIdx = (value >> 17) & 0x3, bitrateIdx = (value >> 12) & 0xF, samplerateIdx = (value >> 10) & 0x3;
+	if (((value & 0xFFE00000) != 0xFFE00000) || (version == 1) || (layerIdx == 0) || (bitrateIdx == 0) || (bitrateIdx == 15) || (samplerateIdx == 3))
+	{
+		return false;
+	}
+
+	header.version = version;
+	header.layer = 4 - layerIdx;
+	header.bitrate = MPEG_BITRATES[(version == 3) ? 0 : 1][header.layer - 1][bitrateIdx];
+	header.samplerate = MPEG_SAMPLERATES[version][samplerateIdx];
+	header.channels = (((value >> 6) & 0x3) == 3) ? 1 : 2;
+
+	const quint32 padding = (value >> 9) & 0x1;
+	switch (header.layer)
+	{
+	case 1:
+		header.samplesPerFrame = 384;
+		header.frameSize = ((12000U * header.bitrate / header.samplerate) + padding) * 4U;
+		break;
+	case 2:
+		header.samplesPerFrame = 1152;
+		header.frameSize = (144000U * header.bitrate / header.samplerate) + padding;
+		break;
+	default:
+		header.samplesPerFrame = (version == 3) ? 1152 : 576;
+		header.frameSize = (((version == 3) ? 144000U : 72000U) * header.bitrate / header.samplerate) + padding;
+		break;
+	}
+
+	header.sideInfoSize = (version == 3) ? ((header.channels == 1) ? 17 : 32) : ((header.channels == 1) ? 9 : 17);
+	return true;
+}
+
+static bool parse_leading_uint(const QString &str, quint32 &value)
+{
+	int len = 0;
+	while ((len < str.length()) && str.at(len).isDigit())
+	{
+		len++;
+	}
+	bool okay = false;
+	value = str.left(len).toUInt(&okay);
+	return okay;
+}
+
+static bool parse_genre(const QString &str, QString &genre)
+{
+	static const int genreCount = sizeof(ID3_GENRES) / sizeof(ID3_GENRES[0]) - 1;
+	QRegExp reference("^\\((\\d+)\\)(.*)$"), numeric("^(\\d+)$");
+	const bool isReference = (reference.indexIn(str) >= 0);
+	if (isReference || (numeric.indexIn(str) >= 0))
+	{
+		const QString refinement = isReference ? reference.cap(2).trimmed() : QString();
+		if (!refinement.isEmpty())
+		{
+			genre = refinement;
+			return true;
+		}
+		const int index = (isReference ? reference.cap(1) : numeric.cap(1)).toInt();
+		if (index >= genreCount)
+		{
+			return false;
+		}
+		genre = QString::fromLatin1(ID3_GENRES[index]);
+		return true;
+	}
+	genre = str;
+	return true;
+}
+
+static QString decode_text(const QByteArray &data)
+{
+	const QByteArray text = data.left(data.indexOf('\0'));
+	QTextCodec::ConverterState state;
+	const QString result = QTextCodec::codecForName("UTF-8")->toUnicode(text.constData(), text.size(), &state);
+	return (state.invalidChars > 0) ? QString::fromLatin1(text).simplified() : result.simplified();
+}
+
+static QStringList decode_id3_strings(const QByteArray &data)
+{
+	static const char *const ENCODINGS[] = { "ISO-8859-1", "UTF-16", "UTF-16BE", "UTF-8" };
+	if ((data.size() < 1) || (quint8(data.at(0)) > 3))
+	{
+		return QStringList();
+	}
+	QTextCodec *const codec = QTextCodec::codecForName(ENCODINGS[quint8(data.at(0))]);
+	if (!codec)
+	{
+		return QStringList();
+	}
+	QStringList strings;
+	const QStringList parts = codec->toUnicode(data.mid(1)).split(QChar(0));
+	for (QStringList::ConstIterator iter = parts.constBegin(); iter != parts.constEnd(); ++iter)
+	{
+		strings << QString(*iter).remove(QChar(0xFEFF)).simplified();
+	}
+	return strings;
+}
+
+bool AnalyzeTask::analyzeNativeFile(const QString &filePath, AudioFileModel &audioFile)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	const QByteArray header = file.read(12);
+	AudioFileModel nativeInfo(audioFile.filePath());
+	bool success = false;
+
+	if ((header.size() >= 12) && header.startsWith("RIFF") && (header.mid(8, 4) == "WAVE"))
+	{
+		success = probeWave(file, nativeInfo);
+	}
+	else if (header.startsWith("fLaC"))
+	{
+		success = probeFLAC(file, nativeInfo);
+	}
+	else if (header.startsWith("OggS"))
+	{
+		success = probeOgg(file, nativeInfo);
+	}
+	else if (header.startsWith("ID3") || ((header.size() >= 2) && (quint8(header.at(0)) == 0xFF) && ((quint8(header.at(1)) & 0xE0) == 0xE0)))
+	{
+		success = probeMPEG(file, nativeInfo);
+	}
+
+	file.close();
+
+	if (success)
+	{
+		audioFile.setMetaInfo(nativeInfo.metaInfo());
+		audioFile.setTechInfo(nativeInfo.techInfo());
+		completeFileInfo(audioFile);
+	}
+
+	return success;
+}
+
+bool AnalyzeTask::probeWave(QFile &file, AudioFileModel &audioFile)
 {
-	const QByteArray content = QByteArray::fromBase64(coverData.toLatin1());
-	const QString type = m_mimeTypes.value(coverType.toLower());
-	qDebug("Retrieving cover! (mime=\"%s\", type=\"%s\", len=%d)", MUTILS_L1STR(coverType), MUTILS_L1STR(type), content.size());
-	if(!QImage::fromData(content, type.isEmpty() ? NULL : MUTILS_L1STR(type.toUpper())).isNull())
+	const qint64 fileSize = file.size();
+	qint64 offset = 12, dataSize = -1;
+	quint32 formatTag = 0, channels = 0, sampleRate = 0, byteRate = 0, bitsPerSample = 0;
+
+	for (int chunkCount = 0; (offset + 8 <= fileSize) && (chunkCount < PROBE_MAX_CHUNKS); ++chunkCount)
 	{
-		QFile coverFile(QString("%1/%2.%3").arg(MUtils::temp_folder(), MUtils::next_rand_str(), type.isEmpty() ? QLatin1String("jpg") : type));
-		if(coverFile.open(QIODevice::WriteOnly))
+		if (!file.seek(offset))
+		{
+			return false;
+		}
+		const QByteArray header = file.read(8);
+		if (header.size() < 8)
 		{
-			coverFile.write(content);
-			coverFile.close();
-			audioFile.metaInfo().setCover(coverFile.fileName(), true);
+			break;
 		}
+		const QByteArray chunkId = header.left(4);
+		const quint32 chunkSize = LE32(header, 4);
+		if (chunkId == "fmt ")
+		{
+			const QByteArray format = file.read(qMin(chunkSize, 40U));
+			if (format.size() < 16)
+			{
+				return false;
+			}
+			formatTag = LE16(format, 0);
+			channels = LE16(format, 2);
+			sampleRate = LE32(format, 4);
+			byteRate = LE32(format, 8);
+			bitsPerSample = LE16(format, 14);
+			if ((formatTag == 0xFFFE) && (format.size() >= 26))
+			{
+				formatTag = LE16(format, 24); /*WAVE_FORMAT_EXTENSIBLE sub-format*/
+			}
+		}
+		else if (chunkId == "data")
+		{
+			dataSize = ((chunkSize == UINT_MAX) || (offset + 8 + chunkSize > fileSize)) ? (fileSize - offset - 8) : chunkSize;
+		}
+		else if (chunkId == "LIST")
+		{
+			if ((chunkSize >= 4) && (chunkSize <= PROBE_MAX_TAGSIZE))
+			{
+				const QByteArray list = file.read(chunkSize);
+				if (list.startsWith("INFO"))
+				{
+					for (int pos = 4; pos + 8 <= list.size(); )
+					{
+						const QByteArray itemId = list.mid(pos, 4);
+						const quint32 itemSize = quint32(LE32(list, pos + 4));
+						if (itemSize > quint32(list.size() - pos - 8))
+						{
+							break; /*damaged item, the remaining items can not be located*/
+						}
+						const QString value = decode_text(list.mid(pos + 8, int(itemSize)));
+						if (!value.isEmpty())
+						{
+							if      (itemId == "INAM") audioFile.metaInfo().setTitle(value);
+							else if (itemId == "IART") audioFile.metaInfo().setArtist(value);
+							else if (itemId == "IPRD") audioFile.metaInfo().setAlbum(value);
+							else if (itemId == "IGNR") audioFile.metaInfo().setGenre(value);
+							else if (itemId == "ICMT") audioFile.metaInfo().setComment(value);
+							else if (itemId == "ICRD") SET_OPTIONAL(quint32, parse_leading_uint(value, _tmp), audioFile.metaInfo().setYear(_tmp));
+							else if ((itemId == "ITRK") || (itemId == "IPRT")) SET_OPTIONAL(quint32, parse_leading_uint(value, _tmp), audioFile.metaInfo().setPosition(_tmp));
+						}
+						pos += 8 + int(itemSize + (itemSize & 1U)); /*always advances by at least 8 bytes*/
+					}
+				}
+			}
+		}
+		else if ((chunkId == "id3 ") || (chunkId == "ID3 "))
+		{
+			return false; /*ID3 tags in RIFF files are handled by MediaInfo*/
+		}
+		offset += 8 + qint64(chunkSize) + (chunkSize & 1);
+	}
+
+	if (((formatTag != 1) && (formatTag != 3)) || (channels < 1) || (sampleRate < 1) || (byteRate < 1) || (bitsPerSample < 1) || (dataSize < 0))
+	{
+		return false;
+	}
+
+	audioFile.techInfo().setContainerType(QLatin1String("Wave"));
+	audioFile.techInfo().setAudioType(QLatin1String("PCM"));
+	if (formatTag == 3)
+	{
+		audioFile.techInfo().setAudioProfile(QLatin1String("Float"));
+	}
+	audioFile.techInfo().setAudioSamplerate(sampleRate);
+	audioFile.techInfo().setAudioChannels(channels);
+	audioFile.techInfo().setAudioBitdepth(bitsPerSample);
+	audioFile.techInfo().setAudioBitrate(DIV_RND(sampleRate * channels * bitsPerSample, 1000U));
+	audioFile.techInfo().setAudioBitrateMode(AudioFileModel::BitrateModeConstant);
+	audioFile.techInfo().setDuration(quint32(qRound64(double(dataSize) / double(byteRate))));
+	return true;
+}
+
+bool AnalyzeTask::probeFLAC(QFile &file, AudioFileModel &audioFile)
+{
+	qint64 offset = 4, totalSamples = 0;
+	quint32 sampleRate = 0, channels = 0, bitsPerSample = 0;
+	bool lastBlock = false;
+
+	while (!lastBlock)
+	{
+		if (!file.seek(offset))
+		{
+			return false;
+		}
+		const QByteArray header = file.read(4);
+		if (header.size() < 4)
+		{
+			return false;
+		}
+		const quint8 blockType = quint8(header.at(0)) & 0x7F;
+		const quint32 blockSize = BE24(header, 1);
+		lastBlock = ((quint8(header.at(0)) & 0x80) != 0);
+		switch (blockType)
+		{
+		case 0: /*STREAMINFO*/
+			{
+				const QByteArray info = file.read(34);
+				if (info.size() < 34)
+				{
+					return false;
+				}
+				sampleRate = BE32(info, 10) >> 12;
+				channels = ((quint8(info.at(12)) >> 1) & 0x07) + 1;
+				bitsPerSample = (((quint8(info.at(12)) & 0x01) << 4) | (quint8(info.at(13)) >> 4)) + 1;
+				totalSamples = (qint64(quint8(info.at(13)) & 0x0F) << 32) | BE32(info, 14);
+			}
+			break;
+		case 4: /*VORBIS_COMMENT*/
+			if ((blockSize > PROBE_MAX_TAGSIZE) || (!parseVorbisComment(file.read(blockSize), audioFile)))
+			{
+				return false;
+			}
+			break;
+		case 6: /*PICTURE*/
+			audioFile.metaInfo().setCoverSource(audioFile.filePath());
+			break;
+		case 127:
+			return false;
+		}
+		offset += 4 + qint64(blockSize);
+	}
+
+	if (sampleRate < 1)
+	{
+		return false;
+	}
+
+	audioFile.techInfo().setContainerType(QLatin1String("FLAC"));
+	audioFile.techInfo().setAudioType(QLatin1String("FLAC"));
+	audioFile.techInfo().setAudioSamplerate(sampleRate);
+	audioFile.techInfo().setAudioChannels(channels);
+	audioFile.techInfo().setAudioBitdepth(bitsPerSample);
+	if (totalSamples > 0)
+	{
+		const double duration = double(totalSamples) / double(sampleRate);
+		audioFile.techInfo().setDuration(quint32(qRound64(duration)));
+		audioFile.techInfo().setAudioBitrate(quint32(qRound64(double(file.size() - offset) * 8.0 / (duration * 1000.0))));
+		audioFile.techInfo().setAudioBitrateMode(AudioFileModel::BitrateModeVariable);
+	}
+	return true;
+}
+
+bool AnalyzeTask::probeOgg(QFile &file, AudioFileModel &audioFile)
+{
+	QList<QByteArray> packets;
+	QByteArray currentPacket;
+	qint64 offset = 0;
+	quint32 serial = 0;
+
+	//Read the identification and comment headers of the first logical stream
+	while (packets.count() < 2)
+	{
+		if ((offset > PROBE_MAX_TAGSIZE) || (!file.seek(offset)))
+		{
+			return false;
+		}
+		const QByteArray header = file.read(27);
+		if ((header.size() < 27) || (!header.startsWith("OggS")) || (header.at(4) != '\0'))
+		{
+			return false;
+		}
+		const QByteArray segments = file.read(quint8(header.at(26)));
+		if (segments.size() != quint8(header.at(26)))
+		{
+			return false;
+		}
+		const bool firstPage = (offset == 0);
+		if (firstPage)
+		{
+			if (!(header.at(5) & 0x02))
+			{
+				return false;
+			}
+			serial = LE32(header, 14);
+		}
+		else if (LE32(header, 14) != serial)
+		{
+			if (header.at(5) & 0x02)
+			{
+				return false; /*multiplexed streams are handled by MediaInfo*/
+			}
+		}
+		int pageSize = 0;
+		for (int i = 0; i < segments.size(); ++i)
+		{
+			pageSize += quint8(segments.at(i));
+		}
+		if (LE32(header, 14) == serial)
+		{
+			const QByteArray body = file.read(pageSize);
+			if (body.size() != pageSize)
+			{
+				return false;
+			}
+			for (int i = 0, pos = 0; (i < segments.size()) && (packets.count() < 2); ++i)
+			{
+				const int lacing = quint8(segments.at(i));
+				currentPacket += body.mid(pos, lacing);
+				pos += lacing;
+				if (lacing < 255)
+				{
+					packets << currentPacket;
+					currentPacket.clear();
+				}
+			}
+		}
+		offset += 27 + segments.size() + pageSize;
+	}
+
+	quint32 sampleRate = 0, channels = 0, preSkip = 0;
+	QByteArray comments;
+
+	if (packets[0].startsWith("\x01vorbis") && (packets[0].size() >= 30) && packets[1].startsWith("\x03vorbis"))
+	{
+		audioFile.techInfo().setAudioType(QLatin1String("Vorbis"));
+		channels = quint8(packets[0].at(11));
+		sampleRate = LE32(packets[0], 12);
+		comments = packets[1].mid(7);
+	}
+	else if (packets[0].startsWith("OpusHead") && (packets[0].size() >= 19) && packets[1].startsWith("OpusTags"))
+	{
+		audioFile.techInfo().setAudioType(QLatin1String("Opus"));
+		channels = quint8(packets[0].at(9));
+		preSkip = LE16(packets[0], 10);
+		sampleRate = 48000;
+		comments = packets[1].mid(8);
 	}
 	else
 	{
-		qWarning("Image data seems to be invalid! [Header:%s]", content.left(32).toHex().constData());
+		return false;
+	}
+
+	if ((sampleRate < 1) || (channels < 1) || (!parseVorbisComment(comments, audioFile)))
+	{
+		return false;
 	}
+
+	audioFile.techInfo().setContainerType(QLatin1String("Ogg"));
+	audioFile.techInfo().setAudioSamplerate(sampleRate);
+	audioFile.techInfo().setAudioChannels(channels);
+
+	//Determine the duration from the granule position of the last page
+	const qint64 fileSize = file.size(), tailOffset = qMax(qint64(0), fileSize - PROBE_OGG_TAIL);
+	if (file.seek(tailOffset))
+	{
+		const QByteArray tail = file.read(PROBE_OGG_TAIL);
+		for (int pos = tail.lastIndexOf("OggS"); pos >= 0; pos = (pos > 0) ? tail.lastIndexOf("OggS", pos - 1) : -1)
+		{
+			if ((pos + 27 <= tail.size()) && (LE32(tail, pos + 14) == serial))
+			{
+				const qint64 granule = LE64(tail, pos + 6);
+				if (granule > qint64(preSkip))
+				{
+					const double duration = double(granule - preSkip) / double(sampleRate);
+					audioFile.techInfo().setDuration(quint32(qRound64(duration)));
+					audioFile.techInfo().setAudioBitrate(quint32(qRound64(double(fileSize - offset) * 8.0 / (duration * 1000.0))));
+					audioFile.techInfo().setAudioBitrateMode(AudioFileModel::BitrateModeVariable);
+					break;
+				}
+			}
+		}
+	}
+
+	return true;
 }
 
+bool AnalyzeTask::probeMPEG(QFile &file, AudioFileModel &audioFile)
+{
+	const qint64 fileSize = file.size();
+	qint64 audioStart = 0, audioEnd = fileSize;
+	bool haveTags = false;
+
+	//Parse the ID3v2 tag, if any
+	if (!file.seek(0))
+	{
+		return false;
+	}
+	const QByteArray id3Header = file.read(10);
+	if ((id3Header.size() == 10) && id3Header.startsWith("ID3"))
+	{
+		const quint8 version = id3Header.at(3), flags = id3Header.at(5);
+		const quint32 tagSize = SYNCSAFE32(id3Header, 6);
+		if ((version < 3) || (version > 4) || (flags & 0xC0) || (tagSize > PROBE_MAX_TAGSIZE))
+		{
+			return false; /*unsynchronized or extended tags are handled by MediaInfo*/
+		}
+		if (!parseID3v2Tag(file.read(tagSize), version, audioFile))
+		{
+			return false;
+		}
+		haveTags = true;
+		audioStart = 10 + tagSize + ((flags & 0x10) ? 10 : 0);
+	}
+
+	//Check for trailing tags
+	if ((fileSize >= audioStart + 128) && file.seek(fileSize - 128))
+	{
+		const QByteArray id3v1 = file.read(128);
+		if ((id3v1.size() == 128) && id3v1.startsWith("TAG"))
+		{
+			audioEnd -= 128;
+			if ((!haveTags) && (!parseID3v1Tag(id3v1, audioFile)))
+			{
+				return false;
+			}
+		}
+	}
+	if ((audioEnd >= audioStart + 32) && file.seek(audioEnd - 32))
+	{
+		if (file.read(32).startsWith("APETAGEX"))
+		{
+			return false; /*APE tags are handled by MediaInfo*/
+		}
+	}
+
+	//Find the first frame, requiring a consistent successor frame
+	if (!file.seek(audioStart))
+	{
+		return false;
+	}
+	const QByteArray buffer = file.read(PROBE_SYNC_SEARCH);
+	mpeg_header_t frame, next;
+	int framePos = -1;
+	for (int pos = 0; pos + 4 <= buffer.size(); ++pos)
+	{
+		if (parse_mpeg_header(buffer, pos, frame) && parse_mpeg_header(buffer, pos + frame.frameSize, next))
+		{
+			if ((next.version == frame.version) && (next.layer == frame.layer) && (next.samplerate == frame.samplerate))
+			{
+				framePos = pos;
+				break;
+			}
+		}
+	}
+	if (framePos < 0)
+	{
+		return false;
+	}
+
+	const qint64 audioSize = audioEnd - audioStart - framePos;
+	quint32 frameCount = 0, byteCount = 0, bitrateMode = AudioFileModel::BitrateModeConstant;
+
+	//Check for a Xing/Info or VBRI header in the first frame
+	const int xingPos = framePos + 4 + frame.sideInfoSize;
+	if ((frame.layer == 3) && (xingPos + 16 <= buffer.size()) && ((buffer.mid(xingPos, 4) == "Xing") || (buffer.mid(xingPos, 4) == "Info")))
+	{
+		const quint32 flags = BE32(buffer, xingPos + 4);
+		int pos = xingPos + 8;
+		if (flags & 0x1) { frameCount = BE32(buffer, pos); pos += 4; }
+		if (flags & 0x2) { byteCount  = BE32(buffer, pos); pos += 4; }
+		if (flags & 0x4) { pos += 100; }
+		if (flags & 0x8) { pos += 4; }
+		if (buffer.mid(xingPos, 4) == "Xing")
+		{
+			bitrateMode = AudioFileModel::BitrateModeVariable;
+		}
+		if (pos + 9 <= buffer.size())
+		{
+			const QString encoder = cleanAsciiStr(QString::fromLatin1(buffer.mid(pos, 9)));
+			if ((encoder.length() >= 4) && encoder.at(0).isLetter())
+			{
+				audioFile.techInfo().setAudioEncodeLib(encoder);
+			}
+		}
+	}
+	else if ((frame.layer == 3) && (framePos + 54 <= buffer.size()) && (buffer.mid(framePos + 36, 4) == "VBRI"))
+	{
+		byteCount  = BE32(buffer, framePos + 46);
+		frameCount = BE32(buffer, framePos + 50);
+		bitrateMode = AudioFileModel::BitrateModeVariable;
+	}
+
+	audioFile.techInfo().setContainerType(QLatin1String("MPEG Audio"));
+	audioFile.techInfo().setAudioType(QLatin1String("MPEG Audio"));
+	audioFile.techInfo().setAudioVersion(QLatin1String((frame.version == 3) ? "Version 1" : ((frame.version == 2) ? "Version 2" : "Version 2.5")));
+	audioFile.techInfo().setAudioProfile(QString("Layer %1").arg(frame.layer));
+	audioFile.techInfo().setAudioSamplerate(frame.samplerate);
+	audioFile.techInfo().setAudioChannels(frame.channels);
+	audioFile.techInfo().setAudioBitrateMode(bitrateMode);
+
+	if (frameCount > 0)
+	{
+		const double duration = double(frameCount) * double(frame.samplesPerFrame) / double(frame.samplerate);
+		audioFile.techInfo().setDuration(quint32(qRound64(duration)));
+		audioFile.techInfo().setAudioBitrate((bitrateMode == AudioFileModel::BitrateModeConstant) ? frame.bitrate : quint32(qRound64(double((byteCount > 0) ? byteCount : audioSize) * 8.0 / (duration * 1000.0))));
+	}
+	else
+	{
+		audioFile.techInfo().setDuration(quint32(qRound64(double(audioSize) * 8.0 / (double(frame.bitrate) * 1000.0))));
+		audioFile.techInfo().setAudioBitrate(frame.bitrate);
+	}
+
+	return true;
+}
+
+bool AnalyzeTask::parseVorbisComment(const QByteArray &data, AudioFileModel &audioFile)
+{
+	if (data.size() < 8)
+	{
+		return false;
+	}
+
+	const qint64 vendorLen = LE32(data, 0);
+	if (vendorLen > data.size() - 8)
+	{
+		return false;
+	}
+
+	const QString vendor = QString::fromUtf8(data.constData() + 4, int(vendorLen));
+	const quint32 count = LE32(data, 4 + int(vendorLen));
+	int pos = 8 + int(vendorLen);
+
+	for (quint32 i = 0; i < count; ++i)
+	{
+		if (pos + 4 > data.size())
+		{
+			return false;
+		}
+		const qint64 entryLen = LE32(data, pos);
+		if (entryLen > data.size() - pos - 4)
+		{
+			return false;
+		}
+		const QString entry = QString::fromUtf8(data.constData() + pos + 4, int(entryLen));
+		pos += 4 + int(entryLen);
+
+		const int separator = entry.indexOf(QLatin1Char('='));
+		const QString key = entry.left(separator).toUpper(), value = entry.mid(separator + 1).simplified();
+		if ((separator < 1) || value.isEmpty())
+		{
+			continue;
+		}
+		if ((key == QLatin1String("METADATA_BLOCK_PICTURE")) || (key == QLatin1String("COVERART")))
+		{
+			audioFile.metaInfo().setCoverSource(audioFile.filePath()); /*artwork is extracted on demand*/
+			continue;
+		}
+
+		AudioFileModel_MetaInfo &metaInfo = audioFile.metaInfo();
+		if      ((key == QLatin1String("TITLE"))       && metaInfo.title().isEmpty())   metaInfo.setTitle(value);
+		else if ((key == QLatin1String("ARTIST"))      && metaInfo.artist().isEmpty())  metaInfo.setArtist(value);
+		else if ((key == QLatin1String("ALBUM"))       && metaInfo.album().isEmpty())   metaInfo.setAlbum(value);
+		else if ((key == QLatin1String("GENRE"))       && metaInfo.genre().isEmpty())   metaInfo.setGenre(value);
+		else if ((key == QLatin1String("COMMENT"))     && metaInfo.comment().isEmpty()) metaInfo.setComment(value);
+		else if ((key == QLatin1String("DESCRIPTION")) && metaInfo.comment().isEmpty()) metaInfo.setComment(value);
+		else if ((key == QLatin1String("DATE"))        && (!metaInfo.year()))           SET_OPTIONAL(quint32, parse_leading_uint(value, _tmp), metaInfo.setYear(_tmp));
+		else if ((key == QLatin1String("TRACKNUMBER")) && (!metaInfo.position()))       SET_OPTIONAL(quint32, parse_leading_uint(value, _tmp), metaInfo.setPosition(_tmp));
+	}
+
+	if (!vendor.isEmpty())
+	{
+		audioFile.techInfo().setAudioEncodeLib(cleanAsciiStr(vendor));
+	}
+
+	return true;
+}
+
+bool AnalyzeTask::parseID3v2Tag(const QByteArray &data, const quint32 version, AudioFileModel &audioFile)
+{
+	for (int pos = 0; pos + 10 <= data.size(); )
+	{
+		const QByteArray frameId = data.mid(pos, 4);
+		if (frameId.at(0) == '\0')
+		{
+			break; /*padding*/
+		}
+
+		const quint32 frameSize = (version > 3) ? SYNCSAFE32(data, pos + 4) : BE32(data, pos + 4);
+		const quint16 frameFlags = BE16(data, pos + 8);
+		pos += 10;
+
+		if (frameSize > quint32(data.size() - pos))
+		{
+			return false;
+		}
+		if (frameId == "APIC")
+		{
+			audioFile.metaInfo().setCoverSource(audioFile.filePath()); /*artwork is extracted on demand*/
+		}
+
+		//Skip compressed, encrypted or otherwise transformed frames
+		if ((frameSize > 0) && (!(frameFlags & ((version > 3) ? 0x004F : 0x00E0))))
+		{
+			const QByteArray payload = data.mid(pos, frameSize);
+			if (frameId == "COMM")
+			{
+				const QStringList strings = decode_id3_strings(payload.left(1) + payload.mid(4));
+				if ((strings.count() >= 2) && strings[0].isEmpty() && (!strings[1].isEmpty()))
+				{
+					audioFile.metaInfo().setComment(strings[1]);
+				}
+			}
+			else if (frameId.startsWith('T'))
+			{
+				const QString value = decode_id3_strings(payload).value(0);
+				if (!value.isEmpty())
+				{
+					if      (frameId == "TIT2") audioFile.metaInfo().setTitle(value);
+					else if (frameId == "TPE1") audioFile.metaInfo().setArtist(value);
+					else if (frameId == "TALB") audioFile.metaInfo().setAlbum(value);
+					else if ((frameId == "TYER") || (frameId == "TDRC")) SET_OPTIONAL(quint32, parse_leading_uint(value, _tmp), audioFile.metaInfo().setYear(_tmp));
+					else if (frameId == "TRCK") SET_OPTIONAL(quint32, parse_leading_uint(value, _tmp), audioFile.metaInfo().setPosition(_tmp));
+					else if (frameId == "TSSE") audioFile.techInfo().setAudioEncodeLib(cleanAsciiStr(value));
+					else if (frameId == "TCON")
+					{
+						QString genre;
+						if (!parse_genre(value, genre))
+						{
+							return false;
+						}
+						audioFile.metaInfo().setGenre(genre);
+					}
+				}
+			}
+		}
+
+		pos += frameSize;
+	}
+
+	return true;
+}
+
+bool AnalyzeTask::parseID3v1Tag(const QByteArray &data, AudioFileModel &audioFile)
+{
+	const quint8 genreIdx = data.at(127);
+	if (genreIdx != 0xFF)
+	{
+		QString genre;
+		if (!parse_genre(QString::number(genreIdx), genre))
+		{
+			return false;
+		}
+		audioFile.metaInfo().setGenre(genre);
+	}
+
+	audioFile.metaInfo().setTitle(QString::fromLatin1(data.mid(3, 30).constData()));
+	audioFile.metaInfo().setArtist(QString::fromLatin1(data.mid(33, 30).constData()));
+	audioFile.metaInfo().setAlbum(QString::fromLatin1(data.mid(63, 30).constData()));
+	SET_OPTIONAL(quint32, parse_leading_uint(QString::fromLatin1(data.mid(93, 4).constData()), _tmp), audioFile.metaInfo().setYear(_tmp));
+	audioFile.metaInfo().setComment(QString::fromLatin1(data.mid(97, 30).constData()));
+	if ((data.at(125) == '\0') && (data.at(126) != '\0'))
+	{
+		audioFile.metaInfo().setPosition(quint8(data.at(126)));
+	}
+
+	return true;
+}
 
 bool AnalyzeTask::analyzeAvisynthFile(const QString &filePath, AudioFileModel &info)
 {
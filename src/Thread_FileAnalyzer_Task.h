@@ -44,7 +44,7 @@ class AnalyzeTask: public QObject, public QRunnable
 	Q_OBJECT
 
 public:
-	AnalyzeTask(const int taskId, const QString &inputFile, QAtomicInt &abortFlag);
+	AnalyzeTask(const int taskId, const QStringList &inputFiles, QAtomicInt &abortFlag);
 	~AnalyzeTask(void);
 	
 	typedef enum
@@ -86,8 +86,7 @@ public:
 		propertyId_bitrate,
 		propertyId_bitrate_mode,
 		propertyId_encoded_library,
-		propertyId_cover_mime,
-		propertyId_cover_data
+		propertyId_cover
 	}
 	MI_propertyId_t;
 
@@ -100,16 +99,25 @@ protected:
 	void run_ex(void);
 
 private:
-	const AudioFileModel& analyzeFile(const QString &filePath, AudioFileModel &audioFile, int *const type);
-	const AudioFileModel& analyzeMediaFile(const QString &filePath, AudioFileModel &audioFile);
-	const AudioFileModel& parseMediaInfo(const QByteArray &data, AudioFileModel &audioFile);
+	bool analyzeFile(const QString &filePath, AudioFileModel &audioFile, int *const type);
+	void analyzeMediaFiles(const QList<AudioFileModel*> &audioFiles);
+	void parseMediaInfo(const QByteArray &data, const QList<AudioFileModel*> &audioFiles);
+	const AudioFileModel& completeFileInfo(AudioFileModel &audioFile);
+	bool analyzeNativeFile(const QString &filePath, AudioFileModel &audioFile);
 	void parseFileInfo(QXmlStreamReader &xmlStream, AudioFileModel &audioFile);
 	void parseTrackInfo(QXmlStreamReader &xmlStream, const MI_trackType_t trackType, AudioFileModel &audioFile);
-	void parseProperty(const QString &value, const MI_propertyId_t propertyIdx, AudioFileModel &audioFile, QString &coverMimeType);
-	void retrieveCover(AudioFileModel &audioFile, const QString &coverType, const QString &coverData);
+	void parseProperty(const QString &value, const MI_propertyId_t propertyIdx, AudioFileModel &audioFile);
 	bool checkFile_CDDA(QFile &file);
 	bool analyzeAvisynthFile(const QString &filePath, AudioFileModel &info);
 
+	static bool probeWave(QFile &file, AudioFileModel &audioFile);
+	static bool probeFLAC(QFile &file, AudioFileModel &audioFile);
+	static bool probeOgg(QFile &file, AudioFileModel &audioFile);
+	static bool probeMPEG(QFile &file, AudioFileModel &audioFile);
+	static bool parseVorbisComment(const QByteArray &data, AudioFileModel &audioFile);
+	static bool parseID3v2Tag(const QByteArray &data, const quint32 version, AudioFileModel &audioFile);
+	static bool parseID3v1Tag(const QByteArray &data, AudioFileModel &audioFile);
+
 	static QString decodeStr(const QString &str, const QString &encoding);
 	static bool parseUnsigned(const QString &str, quint32 &value);
 	static bool parseFloat(const QString &str, double &value);
@@ -119,17 +127,17 @@ private:
 	static bool findNextElement(const QString &name, QXmlStreamReader &xmlStream);
 	static QString findAttribute(const QString &name, const QXmlStreamAttributes &xmlAttributes);
 	static bool checkVersionStr(const QString &str, const quint32 expectedMajor, const quint32 expectedMinor);
+	static int findMediaIndex(const QString &ref, const QList<AudioFileModel*> &audioFiles, const int nextIndex);
 
 	const QMap<QPair<MI_trackType_t, QString>, MI_propertyId_t> &m_mediaInfoIdx;
 	const QMap<QString, MI_propertyId_t> &m_avisynthIdx;
-	const QMap<QString, QString> &m_mimeTypes;
 	const QMap<QString, MI_trackType_t> &m_trackTypes;
 
 	const unsigned int m_taskId;
 	const QString m_mediaInfoBin;
 	const quint32 m_mediaInfoVer;
 	const QString m_avs2wavBin;
-	const QString m_inputFile;
+	const QStringList m_inputFiles;
 
 	QAtomicInt &m_abortFlag;
 };
@@ -31,7 +31,10 @@
 #include "Filter_Abstract.h"
 #include "Filter_Downmix.h"
 #include "Filter_Resample.h"
+#include "Filter_Trim.h"
 #include "Tool_WaveProperties.h"
+#include "Tool_StreamPipeline.h"
+#include "Tool_LoudnessMeter.h"
 #include "Registry_Decoder.h"
 #include "Model_Settings.h"
 
@@ -48,6 +51,7 @@
 #include <QMutexLocker>
 #include <QDate>
 #include <QThreadPool>
+#include <QElapsedTimer>
 
 //CRT
 #include <limits.h>
@@ -57,6 +61,9 @@
 #define DIFF(X,Y) ((X > Y) ? (X-Y) : (Y-X))
 #define IS_WAVE(X) ((X.containerType().compare("Wave", Qt::CaseInsensitive) == 0) && (X.audioType().compare("PCM", Qt::CaseInsensitive) == 0))
 #define STRDEF(STR,DEF) ((!STR.isEmpty()) ? STR : DEF)
+#define IS_VALID(X) (((X) != 0U) && ((X) != UINT_MAX))
+#define HAS_FORMAT(X) (IS_VALID(X.audioSamplerate()) && IS_VALID(X.audioChannels()) && IS_VALID(X.audioBitdepth()))
+#define IS_WAVE64(X) (QFileInfo(X).suffix().compare(QLatin1String("w64"), Qt::CaseInsensitive) == 0)
 
 ////////////////////////////////////////////////////////////
 // Constructor
@@ -73,8 +80,14 @@ ProcessThread::ProcessThread(const AudioFileModel &audioFile, const QString &out
 	m_renamePattern("<BaseName>"),
 	m_overwriteMode(OverwriteMode_KeepBoth),
 	m_keepDateTime(false),
+	m_streamingMode(false),
+	m_nativeFilters(false),
+	m_measureLoudness(false),
 	m_initialized(-1),
-	m_propDetect(new WaveProperties())
+	m_propDetect(new WaveProperties()),
+	m_loudnessMeter(new LoudnessMeter()),
+	m_pipeline(new StreamPipeline()),
+	m_stageTool(NULL)
 {
 	connect(m_encoder, SIGNAL(statusUpdated(int)), this, SLOT(handleUpdate(int)), Qt::DirectConnection);
 	connect(m_encoder, SIGNAL(messageLogged(QString)), this, SLOT(handleMessage(QString)), Qt::DirectConnection);
@@ -82,6 +95,11 @@ ProcessThread::ProcessThread(const AudioFileModel &audioFile, const QString &out
 	connect(m_propDetect, SIGNAL(statusUpdated(int)), this, SLOT(handleUpdate(int)), Qt::DirectConnection);
 	connect(m_propDetect, SIGNAL(messageLogged(QString)), this, SLOT(handleMessage(QString)), Qt::DirectConnection);
 
+	connect(m_pipeline, SIGNAL(statusUpdated(int)), this, SLOT(handleUpdate(int)), Qt::DirectConnection);
+	connect(m_pipeline, SIGNAL(messageLogged(QString)), this, SLOT(handleMessage(QString)), Qt::DirectConnection);
+
+	connect(m_loudnessMeter, SIGNAL(messageLogged(QString)), this, SLOT(handleMessage(QString)), Qt::DirectConnection);
+
 	m_currentStep = UnknownStep;
 }
 
@@ -99,6 +117,8 @@ ProcessThread::~ProcessThread(void)
 
 	MUTILS_DELETE(m_encoder);
 	MUTILS_DELETE(m_propDetect);
+	MUTILS_DELETE(m_pipeline);
+	MUTILS_DELETE(m_loudnessMeter);
 
 	emit processFinished();
 }
@@ -113,7 +133,7 @@ bool ProcessThread::init(void)
 	{
 		//Initialize job status
 		qDebug("Process thread %s has started.", m_jobId.toString().toLatin1().constData());
-		emit processStateInitialized(m_jobId, QFileInfo(m_audioFile.filePath()).fileName(), tr("Starting..."), ProgressModel::JobRunning);
+		emit processStateInitialized(m_jobId, m_audioFile.isTrack() ? m_audioFile.trackName() : QFileInfo(m_audioFile.filePath()).fileName(), tr("Starting..."), ProgressModel::JobRunning);
 
 		//Initialize log
 		handleMessage(QString().sprintf("LameXP v%u.%02u (Build #%u), compiled on %s at %s", lamexp_version_major(), lamexp_version_minor(), lamexp_version_build(), MUTILS_UTF8(MUtils::Version::app_build_date().toString(Qt::ISODate)), MUTILS_UTF8(MUtils::Version::app_build_time().toString(Qt::ISODate))));
@@ -150,11 +170,13 @@ bool ProcessThread::start(QThreadPool *const pool)
 			break;
 		case -1:
 			//File name already exists -> skipping!
+			reportStats("skipped", QLatin1String("Output file already exists"));
 			emit processStateChanged(m_jobId, tr("Skipped."), ProgressModel::JobSkipped);
 			emit processStateFinished(m_jobId, m_outFileName, -1);
 			break;
 		default:
 			//File name could not be generated
+			reportStats("not_found", QLatin1String("Output file name could not be generated"));
 			emit processStateChanged(m_jobId, tr("Not found!"), ProgressModel::JobFailed);
 			emit processStateFinished(m_jobId, m_outFileName, 0);
 			break;
@@ -200,52 +222,132 @@ void ProcessThread::processFile()
 		MUTILS_THROW("Object not initialized yet!");
 	}
 
+	QElapsedTimer jobTimer;
+	jobTimer.start();
+
+	m_jobStats.stages.clear();
+
 	QString sourceFile = m_audioFile.filePath();
 
+	//Cut the track out of the source first, if this is just one track of a larger image
+	//Tracks are always cut in a single pipelined pass, decoding the whole image to a file for every track would be quadratic
+	bool trimPending = m_audioFile.isTrack();
+	if(trimPending)
+	{
+		m_streamingMode = true;
+	}
+
 	//-----------------------------------------------------
 	// Decode source file
 	//-----------------------------------------------------
 
 	const AudioFileModel_TechInfo &formatInfo = m_audioFile.techInfo();
-	if(!m_filters.isEmpty() || !m_encoder->isFormatSupported(formatInfo.containerType(), formatInfo.containerProfile(), formatInfo.audioType(), formatInfo.audioProfile(), formatInfo.audioVersion()))
+	if(trimPending || !m_filters.isEmpty() || !m_encoder->isFormatSupported(formatInfo.containerType(), formatInfo.containerProfile(), formatInfo.audioType(), formatInfo.audioProfile(), formatInfo.audioVersion()))
 	{
 		m_currentStep = DecodingStep;
 		AbstractDecoder *decoder = DecoderRegistry::lookup(formatInfo.containerType(), formatInfo.containerProfile(), formatInfo.audioType(), formatInfo.audioProfile(), formatInfo.audioVersion());
 		
 		if(decoder)
 		{
-			QString tempFile = generateTempFileName();
+			QString program;
+			QStringList args;
+			AbstractDecoder::streamInfo_t streamInfo;
 
 			connect(decoder, SIGNAL(statusUpdated(int)), this, SLOT(handleUpdate(int)), Qt::DirectConnection);
 			connect(decoder, SIGNAL(messageLogged(QString)), this, SLOT(handleMessage(QString)), Qt::DirectConnection);
 
-			bSuccess = decoder->decode(sourceFile, tempFile, m_aborted);
-			MUTILS_DELETE(decoder);
+			//Read the source in place, if it already is in a format that all tools understand
+			if(decoder->isReadableInPlace())
+			{
+				MUTILS_DELETE(decoder);
+				handleMessage(tr("Source file is going to be read in place, no temporary file will be created.\n"));
+				handleMessage("\n-------------------------------\n");
+			}
+			//Decode in-process, if the decoder can deliver the samples itself
+			else if(decoder->openStream(sourceFile, streamInfo))
+			{
+				//The source stops at the end of the track by itself, so no "trim" stage is needed
+				quint64 firstFrame = 0, frameCount = 0;
+				if(trimPending)
+				{
+					TrimFilter::sampleRange(m_audioFile.trackOffset(), m_audioFile.trackLength(), streamInfo.samplerate, firstFrame, frameCount);
+					handleMessage((frameCount > 0U) ? QString().sprintf("Decoding the track from sample %llu, %llu samples.\n", firstFrame, frameCount) : QString().sprintf("Decoding the track from sample %llu, until the end.\n", firstFrame));
+					trimPending = false;
+				}
+
+				m_pipeline->setSource(new DecoderSource(decoder, streamInfo, firstFrame, frameCount));
+				decoder = NULL;
 
-			if(bSuccess)
+				handleMessage(tr("Source file is going to be decoded in-process, no temporary file will be created.\n"));
+				m_audioFile.techInfo().setContainerType(QString::fromLatin1("Wave"));
+				m_audioFile.techInfo().setAudioType(QString::fromLatin1("PCM"));
+				m_audioFile.techInfo().setAudioSamplerate(streamInfo.samplerate);
+				m_audioFile.techInfo().setAudioChannels(streamInfo.channels);
+				m_audioFile.techInfo().setAudioBitdepth(streamInfo.bitsPerSample);
+				handleMessage("\n-------------------------------\n");
+			}
+			//Let the decoder cut the track, if it can seek to the start of the track by itself
+			else if(trimPending && HAS_FORMAT(formatInfo) && createTrackStage(decoder, sourceFile, program, args))
 			{
-				sourceFile = tempFile;
+				m_pipeline->addStage(program, args);
+				MUTILS_DELETE(decoder);
+				trimPending = false;
+
+				handleMessage(tr("Decoder output is going to be streamed, no temporary file will be created.\n"));
 				m_audioFile.techInfo().setContainerType(QString::fromLatin1("Wave"));
 				m_audioFile.techInfo().setAudioType(QString::fromLatin1("PCM"));
+				handleMessage("\n-------------------------------\n");
+			}
+			//Stream the decoder output, if the audio properties are already known
+			else if(m_streamingMode && HAS_FORMAT(formatInfo) && decoder->createPipelineStage(sourceFile, program, args))
+			{
+				m_pipeline->addStage(program, args);
+				MUTILS_DELETE(decoder);
+
+				handleMessage(tr("Decoder output is going to be streamed, no temporary file will be created.\n"));
+				m_audioFile.techInfo().setContainerType(QString::fromLatin1("Wave"));
+				m_audioFile.techInfo().setAudioType(QString::fromLatin1("PCM"));
+				handleMessage("\n-------------------------------\n");
+			}
+			else
+			{
+				QString tempFile = generateTempFileName(useWave64(formatInfo) && decoder->supportsWave64());
+				beginStage(decoder, sourceFile);
+				bSuccess = decoder->decode(sourceFile, tempFile, m_aborted);
+				endStage(tempFile);
+				MUTILS_DELETE(decoder);
 
-				if(QFileInfo(sourceFile).size() >= 4294967296i64)
+				if(bSuccess)
 				{
-					handleMessage(tr("WARNING: Decoded file size exceeds 4 GB, problems might occur!\n"));
-				}
+					sourceFile = tempFile;
+					m_audioFile.techInfo().setContainerType(QString::fromLatin1("Wave"));
+					m_audioFile.techInfo().setAudioType(QString::fromLatin1("PCM"));
 
-				handleMessage("\n-------------------------------\n");
+					if((!IS_WAVE64(sourceFile)) && (QFileInfo(sourceFile).size() >= 4294967296i64))
+					{
+						handleMessage(tr("WARNING: Decoded file size exceeds 4 GB, problems might occur!\n"));
+					}
+
+					handleMessage("\n-------------------------------\n");
+				}
 			}
 		}
 		else
 		{
 			if(QFileInfo(m_outFileName).exists() && (QFileInfo(m_outFileName).size() < 512)) QFile::remove(m_outFileName);
 			handleMessage(QString("%1\n%2\n\n%3\t%4\n%5\t%6").arg(tr("The format of this file is NOT supported:"), m_audioFile.filePath(), tr("Container Format:"), m_audioFile.containerInfo(), tr("Audio Format:"), m_audioFile.audioCompressInfo()));
+			reportStats("unsupported", QLatin1String("Format of the source file is not supported"), jobTimer.elapsed());
 			emit processStateChanged(m_jobId, tr("Unsupported!"), ProgressModel::JobFailed);
 			emit processStateFinished(m_jobId, m_outFileName, 0);
 			return;
 		}
 	}
 
+	if(trimPending)
+	{
+		m_filters.prepend(new TrimFilter(m_audioFile.trackOffset(), m_audioFile.trackLength()));
+	}
+
 	//-----------------------------------------------------
 	// Update audio properties after decode
 	//-----------------------------------------------------
@@ -254,12 +356,17 @@ void ProcessThread::processFile()
 	{
 		if(m_encoder->supportedSamplerates() || m_encoder->supportedBitdepths() || m_encoder->supportedChannelCount() || m_encoder->needsTimingInfo() || !m_filters.isEmpty())
 		{
-			m_currentStep = AnalyzeStep;
-			bSuccess = m_propDetect->detect(sourceFile, &m_audioFile.techInfo(), m_aborted);
+			if(m_pipeline->isEmpty())
+			{
+				m_currentStep = AnalyzeStep;
+				beginStage(m_propDetect, sourceFile);
+				bSuccess = m_propDetect->detect(sourceFile, &m_audioFile.techInfo(), m_aborted);
+				endStage();
+			}
 
 			if(bSuccess)
 			{
-				handleMessage("\n-------------------------------\n");
+				if(m_pipeline->isEmpty()) handleMessage("\n-------------------------------\n");
 
 				//Do we need to take care if Stereo downmix?
 				const unsigned int *const supportedChannelCount = m_encoder->supportedChannelCount();
@@ -279,27 +386,119 @@ void ProcessThread::processFile()
 		}
 	}
 
+	//-----------------------------------------------------
+	// Measure loudness on the way to the encoder
+	//-----------------------------------------------------
+
+	//The decoded audio is analyzed while it streams through, so the source does not have to be decoded a second time
+	//Tracks that still have to be cut by a filter and Wave64 files that would be passed on as they are can not be tapped
+	if(bSuccess && (!m_aborted) && m_measureLoudness && (!trimPending) && IS_WAVE(m_audioFile.techInfo()) && (!(m_pipeline->isEmpty() && IS_WAVE64(sourceFile))))
+	{
+		m_pipeline->addStage(m_loudnessMeter->createTap(), m_pipeline->isEmpty() ? sourceFile : QString());
+		handleMessage(tr("Loudness is going to be measured while the audio is being encoded.\n"));
+	}
+
 	//-----------------------------------------------------
 	// Apply all audio filters
 	//-----------------------------------------------------
 
 	while(bSuccess && (!m_filters.isEmpty()) && (!m_aborted))
 	{
-		QString tempFile = generateTempFileName();
 		AbstractFilter *poFilter = m_filters.takeFirst();
+		const bool endsEarly = trimPending;
 		m_currentStep = FilteringStep;
+		trimPending = false;
 
 		connect(poFilter, SIGNAL(statusUpdated(int)), this, SLOT(handleUpdate(int)), Qt::DirectConnection);
 		connect(poFilter, SIGNAL(messageLogged(QString)), this, SLOT(handleMessage(QString)), Qt::DirectConnection);
 
-		const AbstractFilter::FilterResult filterResult = poFilter->apply(sourceFile, tempFile, &m_audioFile.techInfo(), m_aborted);
+		//Run the filter in-process, if it has a native implementation
+		if(m_nativeFilters && poFilter->hasNativeStage(&m_audioFile.techInfo()))
+		{
+			bool analyzed = true;
+
+			//Filters that need to see the complete input analyze a file first, the pipeline output is written to a file only once
+			if(poFilter->needsAnalysis())
+			{
+				if(!m_pipeline->isEmpty())
+				{
+					QString tempFile = generateTempFileName();
+					beginStage(m_pipeline);
+					bSuccess = m_pipeline->flush(tempFile, m_aborted);
+					endStage(tempFile);
+					m_pipeline->clear();
+					handleMessage("\n-------------------------------\n");
+					if(!bSuccess)
+					{
+						delete poFilter;
+						break;
+					}
+					sourceFile = tempFile;
+				}
+
+				m_currentStep = AnalyzeStep;
+				beginStage(poFilter, sourceFile);
+				analyzed = (poFilter->analyzeInput(sourceFile, &m_audioFile.techInfo(), m_aborted) == AbstractFilter::FILTER_SUCCESS);
+				endStage();
+				m_currentStep = FilteringStep;
+				handleMessage("\n-------------------------------\n");
+			}
+
+			StreamProcessor *processor = NULL;
+			const AbstractFilter::FilterResult nativeResult = analyzed ? poFilter->createNativeStage(&m_audioFile.techInfo(), processor) : AbstractFilter::FILTER_FAILURE;
+			if(nativeResult != AbstractFilter::FILTER_FAILURE)
+			{
+				if(processor)
+				{
+					m_pipeline->addStage(processor, m_pipeline->isEmpty() ? sourceFile : QString());
+				}
+				delete poFilter;
+				continue;
+			}
+		}
+
+		//Fuse consecutive SoX filters into a single effects chain
+		while((!m_filters.isEmpty()) && (!(m_nativeFilters && m_filters.first()->hasNativeStage(&m_audioFile.techInfo()))) && poFilter->fuse(m_filters.first()))
+		{
+			m_filters.removeFirst();
+		}
+
+		const QString filterInput = m_pipeline->isEmpty() ? sourceFile : AbstractTool::PIPE_NAME();
+
+		//Append filter to the pipeline, unless it needs more than a single pass
+		if(m_streamingMode)
+		{
+			QString program;
+			QStringList args;
+			const AbstractFilter::FilterResult stageResult = poFilter->createPipelineStage(filterInput, &m_audioFile.techInfo(), program, args);
+			if(stageResult != AbstractFilter::FILTER_FAILURE)
+			{
+				if(stageResult == AbstractFilter::FILTER_SUCCESS)
+				{
+					m_pipeline->addStage(program, args, m_tempDirectory, endsEarly);
+				}
+				delete poFilter;
+				continue;
+			}
+		}
+
+		QString tempFile = generateTempFileName(useWave64(m_audioFile.techInfo()));
+
+		poFilter->setInputPipeline(m_pipeline->isEmpty() ? NULL : m_pipeline);
+		beginStage(poFilter, filterInput);
+		const AbstractFilter::FilterResult filterResult = poFilter->apply(filterInput, tempFile, &m_audioFile.techInfo(), m_aborted);
+		endStage((filterResult == AbstractFilter::FILTER_SUCCESS) ? tempFile : QString());
+		poFilter->setInputPipeline(NULL);
+
 		switch (filterResult)
 		{
 		case AbstractFilter::FILTER_SUCCESS:
 			sourceFile = tempFile;
+			m_pipeline->clear();
 			break;
 		case AbstractFilter::FILTER_FAILURE:
 			bSuccess = false;
+			m_pipeline->clear();
 			break;
 		}
 
@@ -311,10 +510,39 @@ void ProcessThread::processFile()
 	// Encode audio file
 	//-----------------------------------------------------
 
+	//Encoders read Wave64 intermediates through SoX, which converts them to a Wave stream
+	if(bSuccess && (!m_aborted) && m_pipeline->isEmpty() && IS_WAVE64(sourceFile))
+	{
+		handleMessage(tr("Intermediate file is in Wave64 format, it is going to be streamed to the encoder.\n"));
+		m_pipeline->addStage(lamexp_tools_lookup("sox.exe"), QStringList() << "-V3" << "-S" << "--temp" << "." << QDir::toNativeSeparators(sourceFile) << "-t" << "wav" << AbstractTool::PIPE_NAME(), m_tempDirectory);
+	}
+
+	//Write the pipeline output to a file, if the encoder can not read from a pipe; files beyond the RIFF limit are written as RF64
+	if(bSuccess && (!m_aborted) && (!m_pipeline->isEmpty()) && (!m_encoder->supportsPipeInput()))
+	{
+		QString tempFile = generateTempFileName();
+		m_currentStep = FilteringStep;
+		beginStage(m_pipeline);
+		bSuccess = m_pipeline->flush(tempFile, m_aborted);
+		endStage(tempFile);
+		if(bSuccess)
+		{
+			sourceFile = tempFile;
+		}
+		m_pipeline->clear();
+		handleMessage("\n-------------------------------\n");
+	}
+
 	if(bSuccess && (!m_aborted))
 	{
 		m_currentStep = EncodingStep;
-		bSuccess = m_encoder->encode(sourceFile, m_audioFile.metaInfo(), m_audioFile.techInfo().duration(), m_audioFile.techInfo().audioChannels(), m_outFileName, m_aborted);
+		m_encoder->setInputPipeline(m_pipeline->isEmpty() ? NULL : m_pipeline);
+		m_encoder->setTemporarySource(m_pipeline->isEmpty() && m_tempFiles.contains(sourceFile));
+		beginStage(m_encoder, (m_pipeline->isEmpty() ? sourceFile : AbstractTool::PIPE_NAME()));
+		bSuccess = m_encoder->encode((m_pipeline->isEmpty() ? sourceFile : AbstractTool::PIPE_NAME()), m_audioFile.metaInfo(), m_audioFile.techInfo().duration(), m_audioFile.techInfo().audioChannels(), m_outFileName, m_aborted);
+		endStage(m_outFileName);
+		m_encoder->setInputPipeline(NULL);
+		m_pipeline->clear();
 	}
 
 	//Clean-up
@@ -343,8 +571,29 @@ void ProcessThread::processFile()
 		updateFileTime(m_audioFile.filePath(), m_outFileName);
 	}
 
+	//Log where the time went
+	if(MUTILS_BOOLIFY(m_aborted))
+	{
+		reportStats("aborted", QString(), jobTimer.elapsed());
+	}
+	else
+	{
+		const QString reason = ((!bSuccess) && (!m_jobStats.stages.isEmpty())) ? QString("%1 step has failed").arg(m_jobStats.stages.last().name) : QString();
+		reportStats((bSuccess ? "done" : "failed"), reason, jobTimer.elapsed());
+	}
+
 	MUtils::OS::sleep_ms(12);
 
+	//Report the loudness before the result, so it is known by the time the job is finished
+	if(bSuccess && (!m_aborted) && m_measureLoudness && (m_loudnessMeter->frames() > 0U))
+	{
+		loudness_t loudness;
+		loudness.loudness = m_loudnessMeter->integratedLoudness();
+		loudness.truePeak = m_loudnessMeter->truePeak();
+		loudness.blockEnergies = m_loudnessMeter->blockEnergies();
+		emit processLoudnessMeasured(m_jobId, loudness);
+	}
+
 	//Report result
 	emit processStateChanged(m_jobId, (MUTILS_BOOLIFY(m_aborted) ? tr("Aborted!") : (bSuccess ? tr("Done.") : tr("Failed!"))), ((bSuccess && (!m_aborted)) ? ProgressModel::JobComplete : ProgressModel::JobFailed));
 	emit processStateFinished(m_jobId, m_outFileName, (bSuccess ? 1 : 0));
@@ -461,7 +710,8 @@ int ProcessThread::generateOutFileName(QString &outFileName)
 	const QString fileExt = m_renameFileExt.isEmpty() ? QString::fromUtf8(m_encoder->toEncoderInfo()->extension()) : m_renameFileExt;
 
 	//Generate file name
-	const QString fileName = MUtils::clean_file_name(QString("%1.%2").arg(applyRegularExpression(applyRenamePattern(sourceFile.completeBaseName(), m_audioFile.metaInfo())), fileExt), true);
+	const QString baseName = m_audioFile.isTrack() ? m_audioFile.trackName() : sourceFile.completeBaseName();
+	const QString fileName = MUtils::clean_file_name(QString("%1.%2").arg(applyRegularExpression(applyRenamePattern(baseName, m_audioFile.metaInfo())), fileExt), true);
 
 	//Generate full output path
 	outFileName = targetDir.absoluteFilePath(fileName);
@@ -537,18 +787,45 @@ QString ProcessThread::applyRegularExpression(const QString &baseName)
 	return fileName.trimmed().isEmpty() ? baseName : fileName;
 }
 
-QString ProcessThread::generateTempFileName(void)
+QString ProcessThread::generateTempFileName(const bool wave64)
 {
-	const QString tempFileName = MUtils::make_temp_file(m_tempDirectory, "wav", true);
+	const QString tempFileName = MUtils::make_temp_file(m_tempDirectory, wave64 ? "w64" : "wav", true);
 	if(tempFileName.isEmpty())
 	{
-		return QString("%1/~whoops%2.wav").arg(m_tempDirectory, QString::number(MUtils::next_rand_u32()));
+		return QString("%1/~whoops%2.%3").arg(m_tempDirectory, QString::number(MUtils::next_rand_u32()), wave64 ? "w64" : "wav");
 	}
 
 	m_tempFiles << tempFileName;
 	return tempFileName;
 }
 
+bool ProcessThread::useWave64(const AudioFileModel_TechInfo &formatInfo)
+{
+	//Wave64 intermediates are fed to the encoder through a pipe, or are converted to RF64 for encoders that can not read from a pipe
+	quint64 projectedSize = 0U;
+	if(WaveProperties::useWave64(formatInfo, &projectedSize))
+	{
+		handleMessage(tr("Projected size of intermediate file is %1 MB, going to use Wave64 format.\n").arg(QString::number(projectedSize / 1048576ui64)));
+		return true;
+	}
+
+	return false;
+}
+
+bool ProcessThread::createTrackStage(AbstractDecoder *const decoder, const QString &sourceFile, QString &program, QStringList &args)
+{
+	quint64 firstFrame, frameCount;
+	TrimFilter::sampleRange(m_audioFile.trackOffset(), m_audioFile.trackLength(), m_audioFile.techInfo().audioSamplerate(), firstFrame, frameCount);
+
+	if(decoder->createTrackStage(sourceFile, firstFrame, frameCount, program, args))
+	{
+		handleMessage((frameCount > 0U) ? QString().sprintf("Decoding the track from sample %llu, %llu samples.\n", firstFrame, frameCount) : QString().sprintf("Decoding the track from sample %llu, until the end.\n", firstFrame));
+		return true;
+	}
+
+	return false;
+}
+
 bool ProcessThread::insertDownsampleFilter(const unsigned int *const supportedSamplerates, const unsigned int *const supportedBitdepths)
 {
 	int targetSampleRate = 0, targetBitDepth = 0;
@@ -704,6 +981,111 @@ bool ProcessThread::updateFileTime(const QString &originalFile, const QString &m
 	return success;
 }
 
+/*
+ * Remember the counters at the start of a step, so that only what happens during the step is accounted to it
+ */
+void ProcessThread::beginStage(const AbstractTool *const tool, const QString &inputFile)
+{
+	m_stageTool = tool;
+	m_stageInputFile = inputFile;
+	m_stageStart = sampleCounters(tool);
+
+	switch(m_currentStep)
+	{
+	case DecodingStep:  m_stageStart.name = QLatin1String("Decode");  break;
+	case AnalyzeStep:   m_stageStart.name = QLatin1String("Analyze"); break;
+	case FilteringStep: m_stageStart.name = QLatin1String("Filter");  break;
+	case EncodingStep:  m_stageStart.name = QLatin1String("Encode");  break;
+	default:            m_stageStart.name = QLatin1String("Unknown"); break;
+	}
+
+	m_stageTimer.start();
+}
+
+/*
+ * Files that were read or written by the step are counted by their size, otherwise the bytes pumped by the pipeline are counted
+ */
+void ProcessThread::endStage(const QString &outputFile)
+{
+	const qint64 wallTime = m_stageTimer.elapsed();
+	const stageStats_t counters = sampleCounters(m_stageTool);
+
+	stageStats_t stats;
+	stats.name = m_stageStart.name;
+	stats.wallTime = wallTime;
+	stats.userTime = counters.userTime - m_stageStart.userTime;
+	stats.kernelTime = counters.kernelTime - m_stageStart.kernelTime;
+	stats.bytesIn = ((!m_stageInputFile.isEmpty()) && (!AbstractTool::IS_PIPE(m_stageInputFile))) ? QFileInfo(m_stageInputFile).size() : (counters.bytesIn - m_stageStart.bytesIn);
+	stats.bytesOut = ((!outputFile.isEmpty()) && (!AbstractTool::IS_PIPE(outputFile))) ? QFileInfo(outputFile).size() : (counters.bytesOut - m_stageStart.bytesOut);
+	stats.exitCode = m_stageTool ? m_stageTool->getLastExitCode() : 0;
+
+	m_jobStats.stages << stats;
+	m_stageTool = NULL;
+}
+
+/*
+ * The pipeline may be running alongside of any tool, so its counters are always included
+ */
+ProcessThread::stageStats_t ProcessThread::sampleCounters(const AbstractTool *const tool)
+{
+	stageStats_t counters;
+	counters.wallTime = 0i64;
+	counters.exitCode = 0;
+	m_pipeline->getProcessTimes(counters.userTime, counters.kernelTime);
+	counters.bytesIn = m_pipeline->bytesIn();
+	counters.bytesOut = m_pipeline->bytesOut();
+
+	if(tool && (tool != m_pipeline))
+	{
+		quint64 userTime, kernelTime;
+		tool->getProcessTimes(userTime, kernelTime);
+		counters.userTime += userTime;
+		counters.kernelTime += kernelTime;
+	}
+
+	return counters;
+}
+
+void ProcessThread::logStats(void)
+{
+	static const double MEGABYTE = 1048576.0;
+
+	handleMessage("\n-------------------------------\n");
+	handleMessage(QString().sprintf("%-8s %10s %10s %10s %12s %12s %10s", "Step", "Wall [s]", "User [s]", "Kernel [s]", "In [MB]", "Out [MB]", "Realtime"));
+
+	quint64 userTime = 0ui64, kernelTime = 0ui64;
+	for(QList<stageStats_t>::ConstIterator iter = m_jobStats.stages.constBegin(); iter != m_jobStats.stages.constEnd(); iter++)
+	{
+		handleMessage(QString().sprintf("%-8s %10.3f %10.3f %10.3f %12.2f %12.2f %9.1fx", MUTILS_UTF8(iter->name), double(iter->wallTime) / 1000.0, double(iter->userTime) / 1000.0, double(iter->kernelTime) / 1000.0, double(iter->bytesIn) / MEGABYTE, double(iter->bytesOut) / MEGABYTE, realtimeFactor(m_jobStats.duration, iter->wallTime)));
+		userTime += iter->userTime;
+		kernelTime += iter->kernelTime;
+	}
+
+	handleMessage(QString().sprintf("%-8s %10.3f %10.3f %10.3f %12s %12s %9.1fx", "Total", double(m_jobStats.wallTime) / 1000.0, double(userTime) / 1000.0, double(kernelTime) / 1000.0, "-", "-", realtimeFactor(m_jobStats.duration, m_jobStats.wallTime)));
+}
+
+/*
+ * Every job reports its statistics exactly once, including the jobs that were skipped or failed early
+ */
+void ProcessThread::reportStats(const char *const result, const QString &reason, const qint64 wallTime)
+{
+	m_jobStats.sourceFile = m_audioFile.filePath();
+	m_jobStats.outputFile = m_outFileName;
+	m_jobStats.result = QString::fromLatin1(result);
+	m_jobStats.reason = reason;
+	m_jobStats.sourceSize = QFileInfo(m_audioFile.filePath()).size();
+	m_jobStats.outputSize = (m_jobStats.result.compare(QLatin1String("done")) == 0) ? QFileInfo(m_outFileName).size() : 0ui64;
+	m_jobStats.duration = m_audioFile.isTrack() ? m_audioFile.trackLength() : static_cast<double>(m_audioFile.techInfo().duration());
+	m_jobStats.wallTime = wallTime;
+
+	if(!m_jobStats.stages.isEmpty())
+	{
+		logStats();
+	}
+
+	emit processStatsCollected(m_jobId, m_jobStats);
+}
+
 ////////////////////////////////////////////////////////////
 // PUBLIC FUNCTIONS
 ////////////////////////////////////////////////////////////
@@ -758,6 +1140,29 @@ void ProcessThread::setKeepDateTime(const bool &keepDateTime)
 	m_keepDateTime = keepDateTime;
 }
 
+void ProcessThread::setStreamingMode(const bool &streaming)
+{
+	m_streamingMode = streaming;
+}
+
+void ProcessThread::setNativeFilters(const bool &nativeFilters)
+{
+	m_nativeFilters = nativeFilters;
+}
+
+void ProcessThread::setMeasureLoudness(const bool &measureLoudness)
+{
+	m_measureLoudness = measureLoudness;
+}
+
+/*
+ * Seconds of audio that are processed per second of wall time, zero if either one is unknown
+ */
+double ProcessThread::realtimeFactor(const double &duration, const qint64 &wallTime)
+{
+	return ((duration > 0.0) && (wallTime > 0i64)) ? ((duration * 1000.0) / static_cast<double>(wallTime)) : 0.0;
+}
+
 ////////////////////////////////////////////////////////////
 // EVENTS
 ////////////////////////////////////////////////////////////
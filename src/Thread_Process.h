@@ -25,12 +25,18 @@
 #include <QRunnable>
 #include <QUuid>
 #include <QStringList>
+#include <QElapsedTimer>
+#include <QVector>
 
 #include "Model_AudioFile.h"
 #include "Encoder_Abstract.h"
 
 class AbstractFilter;
+class AbstractDecoder;
+class AbstractTool;
 class WaveProperties;
+class LoudnessMeter;
+class StreamPipeline;
 class QThreadPool;
 class QCoreApplication;
 
@@ -41,6 +47,44 @@ class ProcessThread: public QObject, public QRunnable
 public:
 	ProcessThread(const AudioFileModel &audioFile, const QString &outputDirectory, const QString &tempDirectory, AbstractEncoder *encoder, const bool prependRelativeSourcePath);
 	~ProcessThread(void);
+
+	//Timing and I/O of a single step of the job
+	typedef struct
+	{
+		QString name;
+		qint64 wallTime;		//milliseconds
+		quint64 userTime;		//milliseconds, CPU time of the child processes
+		quint64 kernelTime;		//milliseconds, CPU time of the child processes
+		quint64 bytesIn;
+		quint64 bytesOut;
+		int exitCode;			//of the last process the step has run
+	}
+	stageStats_t;
+
+	typedef struct
+	{
+		QString sourceFile;
+		QString outputFile;
+		QString result;			//"done", "failed", "aborted", "skipped", "unsupported" or "not_found"
+		QString reason;
+		quint64 sourceSize;
+		quint64 outputSize;
+		double duration;		//seconds of audio
+		qint64 wallTime;		//milliseconds
+		QList<stageStats_t> stages;
+	}
+	jobStats_t;
+
+	//Loudness of the audio that was fed to the encoder, measured on the way
+	typedef struct
+	{
+		double loudness;		//LUFS
+		double truePeak;		//linear
+		QVector<double> blockEnergies;
+	}
+	loudness_t;
+
+	static double realtimeFactor(const double &duration, const qint64 &wallTime);
 	
 	bool init(void);
 	bool start(QThreadPool *const pool);
@@ -51,6 +95,9 @@ public:
 	void setRenameFileExt(const QString &fileExtension);
 	void setOverwriteMode(const bool &bSkipExistingFile, const bool &bReplacesExisting = false);
 	void setKeepDateTime(const bool &keepDateTime);
+	void setStreamingMode(const bool &streaming);
+	void setNativeFilters(const bool &nativeFilters);
+	void setMeasureLoudness(const bool &measureLoudness);
 	void addFilter(AbstractFilter *filter);
 
 public slots:
@@ -65,6 +112,8 @@ signals:
 	void processStateChanged(const QUuid &jobId, const QString &newStatus, int newState);
 	void processStateFinished(const QUuid &jobId, const QString &outFileName, int success);
 	void processMessageLogged(const QUuid &jobId, const QString &line);
+	void processStatsCollected(const QUuid &jobId, const ProcessThread::jobStats_t &stats);
+	void processLoudnessMeasured(const QUuid &jobId, const ProcessThread::loudness_t &loudness);
 	void processFinished(void);
 
 protected:
@@ -91,10 +140,17 @@ private:
 	int generateOutFileName(QString &outFileName);
 	QString applyRenamePattern(const QString &baseName, const AudioFileModel_MetaInfo &metaInfo);
 	QString applyRegularExpression(const QString &baseName);
-	QString generateTempFileName(void);
+	QString generateTempFileName(const bool wave64 = false);
+	bool useWave64(const AudioFileModel_TechInfo &formatInfo);
+	bool createTrackStage(AbstractDecoder *const decoder, const QString &sourceFile, QString &program, QStringList &args);
 	bool insertDownmixFilter(const unsigned int *const supportedChannels);
 	bool insertDownsampleFilter(const unsigned int *const supportedSamplerates, const unsigned int *const supportedBitdepths);
 	bool updateFileTime(const QString &originalFile, const QString &modifiedFile);
+	void beginStage(const AbstractTool *const tool, const QString &inputFile = QString());
+	void endStage(const QString &outputFile = QString());
+	stageStats_t sampleCounters(const AbstractTool *const tool);
+	void logStats(void);
+	void reportStats(const char *const result, const QString &reason, const qint64 wallTime = 0i64);
 
 	QAtomicInt m_aborted;
 	QAtomicInt m_initialized;
@@ -114,6 +170,19 @@ private:
 	QString m_renameFileExt;
 	int m_overwriteMode;
 	bool m_keepDateTime;
+	bool m_streamingMode;
+	bool m_nativeFilters;
+	bool m_measureLoudness;
 	WaveProperties *m_propDetect;
+	LoudnessMeter *m_loudnessMeter;
+	StreamPipeline *m_pipeline;
 	QString m_outFileName;
+	jobStats_t m_jobStats;
+	QElapsedTimer m_stageTimer;
+	const AbstractTool *m_stageTool;
+	QString m_stageInputFile;
+	stageStats_t m_stageStart;
 };
+
+Q_DECLARE_METATYPE(ProcessThread::jobStats_t)
+Q_DECLARE_METATYPE(ProcessThread::loudness_t)
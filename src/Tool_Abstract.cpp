@@ -24,11 +24,13 @@
 
 //Internal
 #include "Global.h"
+#include "Tool_StreamPipeline.h"
 
 //MUtils
 #include <MUtils/Global.h>
 #include <MUtils/OSSupport.h>
 #include <MUtils/JobObject.h>
+#include <MUtils/CPUFeatures.h>
 
 //Qt
 #include <QProcess>
@@ -38,6 +40,14 @@
 #include <QDir>
 #include <QElapsedTimer>
 
+//CRT
+#include <math.h>
+
+//Windows includes
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
 /*
  * Static Objects
  */
@@ -55,18 +65,29 @@ QMutex AbstractTool::s_createObjectMutex;
  */
 quint64 AbstractTool::s_referenceCounter = 0ui64;
 
+/*
+ * Launch limiter
+ */
+double  AbstractTool::s_startProcessTokens = 0.0;
+quint32 AbstractTool::s_startProcessBurst = 1U;
+quint64 AbstractTool::s_startProcessCount = 0ui64;
+qint64  AbstractTool::s_startProcessWaitTotal = 0i64;
+qint64  AbstractTool::s_startProcessWaitMax = 0i64;
+
 /*
  * Const
  */
-static const qint64 START_DELAY = 64i64;	//in milliseconds
+static const qint64 START_DELAY = 64i64;	//in milliseconds, refill period of the whole bucket
+static const quint32 MAX_BURST = 32U;
 
 /*
  * Constructor
  */
 AbstractTool::AbstractTool(void)
 :
-	m_firstLaunch(true)
-
+	m_firstLaunch(true),
+	m_inputPipeline(NULL),
+	m_lastExitCode(0)
 {
 	QMutexLocker lock(&s_createObjectMutex);
 
@@ -74,6 +95,9 @@ AbstractTool::AbstractTool(void)
 	{
 		s_jobObjectInstance.reset(new MUtils::JobObject());
 		s_startProcessTimer.reset(new QElapsedTimer());
+		s_startProcessTimer->start();
+		s_startProcessBurst = qBound(1U, static_cast<quint32>(MUtils::CPUFetaures::detect().count), MAX_BURST);
+		s_startProcessTokens = static_cast<double>(s_startProcessBurst);
 		if(!MUtils::OS::setup_timer_resolution())
 		{
 			qWarning("Failed to setup system timer resolution!");
@@ -86,6 +110,11 @@ AbstractTool::AbstractTool(void)
  */
 AbstractTool::~AbstractTool(void)
 {
+	while(!m_processHandles.isEmpty())
+	{
+		CloseHandle(m_processHandles.takeFirst());
+	}
+
 	QMutexLocker lock(&s_createObjectMutex);
 
 	if(--s_referenceCounter == 0)
@@ -104,22 +133,43 @@ AbstractTool::~AbstractTool(void)
  */
 bool AbstractTool::startProcess(QProcess &process, const QString &program, const QStringList &args, const QString &workingDir)
 {
-	QMutexLocker lock(&s_startProcessMutex);
-	
-	if((!s_startProcessTimer.isNull()) && s_startProcessTimer->isValid())
+	return startProcess(process, program, args, workingDir, [](QProcess& /*process*/) {});
+}
+
+/*
+ * Initialize and launch process object (with custom setup)
+ */
+bool AbstractTool::startProcess(QProcess &process, const QString &program, const QStringList &args, const QString &workingDir, std::function<void(QProcess &process)> &&setup)
+{
+	//Launch the input pipeline first, it will be feeding into this process
+	if(m_inputPipeline)
 	{
-		qint64 elapsed = s_startProcessTimer->elapsed();
-		while(elapsed < START_DELAY)
+		if(!m_inputPipeline->attach(process))
 		{
-			lock.unlock();
-			MUtils::OS::sleep_ms((size_t)(START_DELAY - elapsed));
-			lock.relock();
-			elapsed = s_startProcessTimer->elapsed();
+			emit messageLogged("Failed to create the input pipeline :-(");
+			return false;
 		}
 	}
 
+	QElapsedTimer waitTimer;
+	waitTimer.start();
+
+	//Process creation remains serialized, so that no child inherits the pipe handles of another one
+	QMutexLocker lock(&s_startProcessMutex);
+	acquireStartToken(lock);
+
+	const qint64 waited = waitTimer.elapsed();
+	s_startProcessCount++;
+	s_startProcessWaitTotal += waited;
+	s_startProcessWaitMax = qMax(s_startProcessWaitMax, waited);
+	if(waited >= START_DELAY)
+	{
+		qDebug("Process launch was delayed by %lld ms.", waited);
+	}
+
 	emit messageLogged(commandline2string(program, args) + "\n");
 	MUtils::init_process(process, workingDir.isEmpty() ? QFileInfo(program).absolutePath() : workingDir);
+	setup(process);
 
 	process.start(program, args);
 	
@@ -134,6 +184,14 @@ bool AbstractTool::startProcess(QProcess &process, const QString &program, const
 		}
 
 		MUtils::OS::change_process_priority(&process, -1);
+
+		//Keep our own handle, so the CPU time can still be queried after the process has been destroyed
+		HANDLE processHandle = NULL;
+		const PROCESS_INFORMATION *const processInfo = process.pid();
+		if(processInfo && DuplicateHandle(GetCurrentProcess(), processInfo->hProcess, GetCurrentProcess(), &processHandle, PROCESS_QUERY_INFORMATION, FALSE, 0))
+		{
+			m_processHandles << processHandle;
+		}
 		
 		if(m_firstLaunch)
 		{
@@ -141,7 +199,6 @@ bool AbstractTool::startProcess(QProcess &process, const QString &program, const
 			m_firstLaunch = false;
 		}
 		
-		s_startProcessTimer->start();
 		return true;
 	}
 
@@ -152,10 +209,76 @@ bool AbstractTool::startProcess(QProcess &process, const QString &program, const
 	process.kill();
 	process.waitForFinished(-1);
 
-	s_startProcessTimer->start();
+	if(m_inputPipeline)
+	{
+		m_inputPipeline->detach(true);
+	}
+
 	return false;
 }
 
+/*
+ * Take a token from the launch bucket, the bucket refills completely every START_DELAY milliseconds
+ */
+void AbstractTool::acquireStartToken(QMutexLocker &lock)
+{
+	if(s_startProcessTimer.isNull() || (!s_startProcessTimer->isValid()))
+	{
+		return;
+	}
+
+	const double tokensPerMillisecond = static_cast<double>(s_startProcessBurst) / static_cast<double>(START_DELAY);
+
+	forever
+	{
+		s_startProcessTokens = qMin(static_cast<double>(s_startProcessBurst), s_startProcessTokens + (static_cast<double>(s_startProcessTimer->restart()) * tokensPerMillisecond));
+		if(s_startProcessTokens >= 1.0)
+		{
+			s_startProcessTokens -= 1.0;
+			return;
+		}
+		const size_t delay = qMax(size_t(1), static_cast<size_t>(ceil((1.0 - s_startProcessTokens) / tokensPerMillisecond)));
+		lock.unlock();
+		MUtils::OS::sleep_ms(delay);
+		lock.relock();
+	}
+}
+
+/*
+ * Process launch statistics
+ */
+void AbstractTool::getStartProcessStats(quint64 &count, qint64 &totalWait, qint64 &maximumWait)
+{
+	QMutexLocker lock(&s_startProcessMutex);
+	count = s_startProcessCount;
+	totalWait = s_startProcessWaitTotal;
+	maximumWait = s_startProcessWaitMax;
+}
+
+void AbstractTool::resetStartProcessStats(void)
+{
+	QMutexLocker lock(&s_startProcessMutex);
+	s_startProcessCount = 0ui64;
+	s_startProcessWaitTotal = s_startProcessWaitMax = 0i64;
+}
+
+/*
+ * CPU time of all processes launched by this tool, FILETIME is in 100 ns units
+ */
+void AbstractTool::getProcessTimes(quint64 &userTime, quint64 &kernelTime) const
+{
+	userTime = kernelTime = 0ui64;
+	for(QList<void*>::ConstIterator iter = m_processHandles.constBegin(); iter != m_processHandles.constEnd(); iter++)
+	{
+		FILETIME creationTime, exitTime, kernelFileTime, userFileTime;
+		if(GetProcessTimes((*iter), &creationTime, &exitTime, &kernelFileTime, &userFileTime))
+		{
+			userTime   += ((quint64(userFileTime.dwHighDateTime) << 32) | quint64(userFileTime.dwLowDateTime)) / 10000ui64;
+			kernelTime += ((quint64(kernelFileTime.dwHighDateTime) << 32) | quint64(kernelFileTime.dwLowDateTime)) / 10000ui64;
+		}
+	}
+}
+
 /*
 * Wait for process to terminate while processing its output
 */
@@ -171,9 +294,13 @@ AbstractTool::result_t AbstractTool::awaitProcess(QProcess &process, QAtomicInt
 {
 	bool bTimeout = false;
 	bool bAborted = false;
+	bool bPipeErr = false;
 
 	QString lastText;
 
+	QElapsedTimer idleTimer;
+	idleTimer.start();
+
 	while (process.state() != QProcess::NotRunning)
 	{
 		if (CHECK_FLAG(abortFlag))
@@ -184,7 +311,26 @@ AbstractTool::result_t AbstractTool::awaitProcess(QProcess &process, QAtomicInt
 			break;
 		}
 
-		process.waitForReadyRead(m_processTimeoutInterval);
+		if (m_inputPipeline)
+		{
+			//Keep servicing the input pipeline, while we are waiting for output
+			const bool bReadyRead = process.waitForReadyRead(m_pipelineServiceInterval);
+			const bool bPipeBusy = m_inputPipeline->service();
+			if (bReadyRead || bPipeBusy)
+			{
+				idleTimer.restart();
+			}
+			//The process may stay quiet while the pipeline is busy, it only times out once the idle timer has expired
+			if ((!bReadyRead) && (process.state() == QProcess::Running) && (!idleTimer.hasExpired(m_processTimeoutInterval)))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			process.waitForReadyRead(m_processTimeoutInterval);
+		}
+
 		if (!process.bytesAvailable() && process.state() == QProcess::Running)
 		{
 			process.kill();
@@ -222,15 +368,21 @@ AbstractTool::result_t AbstractTool::awaitProcess(QProcess &process, QAtomicInt
 		process.waitForFinished(-1);
 	}
 
+	if (m_inputPipeline)
+	{
+		bPipeErr = !m_inputPipeline->detach(bAborted || bTimeout);
+	}
+
+	m_lastExitCode = process.exitCode();
 	if (exitCode)
 	{
-		*exitCode = process.exitCode();
+		*exitCode = m_lastExitCode;
 	}
 
 	emit messageLogged(QString().sprintf("\nExited with code: 0x%04X", process.exitCode()));
 	if (!(bAborted || bTimeout)) emit statusUpdated(100);
 
-	if (bAborted || bTimeout || (process.exitCode() != EXIT_SUCCESS))
+	if (bAborted || bTimeout || bPipeErr || (process.exitCode() != EXIT_SUCCESS))
 	{
 		return bAborted ? RESULT_ABORTED : (bTimeout ? RESULT_TIMEOUT : RESULT_FAILURE);
 	}
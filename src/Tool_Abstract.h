@@ -24,11 +24,14 @@
 
 #include <MUtils\Global.h>
 #include <QObject>
+#include <QList>
 #include <functional>
 
 class QMutex;
+class QMutexLocker;
 class QProcess;
 class QElapsedTimer;
+class StreamPipeline;
 
 namespace MUtils
 {
@@ -42,6 +45,27 @@ class AbstractTool : public QObject
 public:
 	AbstractTool(void);
 	~AbstractTool(void);
+
+	//Streaming support
+	void setInputPipeline(StreamPipeline *const pipeline) { m_inputPipeline = pipeline; }
+
+	static __forceinline QString PIPE_NAME(void)
+	{
+		return QString::fromLatin1("-");
+	}
+
+	static __forceinline bool IS_PIPE(const QString &fileName)
+	{
+		return (fileName.compare(QLatin1String("-")) == 0);
+	}
+
+	//Process launch statistics
+	static void getStartProcessStats(quint64 &count, qint64 &totalWait, qint64 &maximumWait);
+	static void resetStartProcessStats(void);
+
+	//CPU time of all processes launched by this tool (in milliseconds)
+	void getProcessTimes(quint64 &userTime, quint64 &kernelTime) const;
+	int getLastExitCode(void) const { return m_lastExitCode; }
 	
 signals:
 	void statusUpdated(int progress);
@@ -49,6 +73,7 @@ signals:
 
 protected:
 	static const int m_processTimeoutInterval = 600000;
+	static const int m_pipelineServiceInterval = 125;
 
 	typedef enum
 	{
@@ -72,6 +97,7 @@ protected:
 	static QString commandline2string(const QString &program, const QStringList &arguments);
 
 	bool startProcess(QProcess &process, const QString &program, const QStringList &args, const QString &workingDir = QString());
+	bool startProcess(QProcess &process, const QString &program, const QStringList &args, const QString &workingDir, std::function<void(QProcess &process)> &&setup);
 	result_t awaitProcess(QProcess &process, QAtomicInt &abortFlag, int *const exitCode = NULL);
 	result_t awaitProcess(QProcess &process, QAtomicInt &abortFlag, std::function<bool(const QString &text)> &&handler, int *const exitCode = NULL);
 
@@ -84,5 +110,16 @@ private:
 
 	static quint64 s_referenceCounter;
 
+	static double  s_startProcessTokens;
+	static quint32 s_startProcessBurst;
+	static quint64 s_startProcessCount;
+	static qint64  s_startProcessWaitTotal;
+	static qint64  s_startProcessWaitMax;
+
+	static void acquireStartToken(QMutexLocker &lock);
+
 	bool m_firstLaunch;
+	StreamPipeline *m_inputPipeline;
+	QList<void*> m_processHandles;
+	int m_lastExitCode;
 };
@@ -0,0 +1,550 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Tool_LoudnessMeter.h"
+
+//Internal
+#include "Global.h"
+#include "Filter_Native.h"
+#include "Tool_StreamPipeline.h"
+
+//MUtils
+#include <MUtils/Global.h>
+#include <MUtils/CPUFeatures.h>
+
+//Qt
+#include <QFile>
+#include <QDir>
+
+//CRT
+#include <math.h>
+#include <limits>
+#include <xmmintrin.h>
+
+#define READ_BUFFER_SIZE 1048576
+#define TRUE_PEAK_TAPS 12
+#define GATE_ABSOLUTE -70.0
+#define GATE_RELATIVE -10.0
+#define SPEAKER_MASK_LFE 0x008U
+#define SPEAKER_MASK_SURROUND 0x630U /*back and side, left and right*/
+
+static const double PI = 3.14159265358979323846;
+
+////////////////////////////////////////////////////////////
+// Analysis Processor
+////////////////////////////////////////////////////////////
+
+class LoudnessMeter_Processor : public NativeProcessor
+{
+public:
+	typedef struct
+	{
+		double b0, b1, b2, a1, a2;
+	}
+	biquad_t;
+
+	LoudnessMeter_Processor(void)
+	:
+		m_channels(0),
+		m_factor(1),
+		m_subBlockSize(0),
+		m_subBlockFill(0),
+		m_subBlockCount(0),
+		m_subBlockEnergy(0.0),
+		m_truePeak(0.0),
+		m_frames(0)
+	{
+		m_useSSE = ((MUtils::CPUFetaures::detect().features & MUtils::CPUFetaures::FLAG_SSE) != 0);
+		memset(m_recentEnergy, 0, sizeof(m_recentEnergy));
+	}
+
+	QVector<double> m_samplePeak;
+	QVector<double> m_sumSquares;
+	QVector<double> m_blockEnergies;
+	double m_truePeak;
+	quint64 m_frames;
+
+protected:
+	virtual bool configure(const format_t &input, format_t& /*output*/)
+	{
+		const double rate = static_cast<double>(input.samplerate);
+		m_channels = input.channels;
+
+		//K-weighting, pre-filter (high shelf)
+		{
+			const double K = tan(PI * 1681.974450955533 / rate), Q = 0.7071752369554196;
+			const double Vh = pow(10.0, 3.999843853973347 / 20.0), Vb = pow(Vh, 0.4996667741545416);
+			const double a0 = 1.0 + (K / Q) + (K * K);
+			m_preFilter.b0 = (Vh + (Vb * K / Q) + (K * K)) / a0;
+			m_preFilter.b1 = (2.0 * ((K * K) - Vh)) / a0;
+			m_preFilter.b2 = (Vh - (Vb * K / Q) + (K * K)) / a0;
+			m_preFilter.a1 = (2.0 * ((K * K) - 1.0)) / a0;
+			m_preFilter.a2 = (1.0 - (K / Q) + (K * K)) / a0;
+		}
+
+		//K-weighting, RLB filter (high pass)
+		{
+			const double K = tan(PI * 38.13547087602444 / rate), Q = 0.5003270373238773;
+			const double a0 = 1.0 + (K / Q) + (K * K);
+			m_rlbFilter.b0 = 1.0;
+			m_rlbFilter.b1 = -2.0;
+			m_rlbFilter.b2 = 1.0;
+			m_rlbFilter.a1 = (2.0 * ((K * K) - 1.0)) / a0;
+			m_rlbFilter.a2 = (1.0 - (K / Q) + (K * K)) / a0;
+		}
+
+		//Channel weights, the LFE channel is ignored and the surround channels are boosted
+		m_weights.resize(m_channels);
+		if(input.channelMask)
+		{
+			quint32 speakers = input.channelMask;
+			for(int c = 0; c < m_channels; c++)
+			{
+				const quint32 speaker = speakers & (~speakers + 1U); /*lowest remaining position*/
+				speakers &= ~speaker;
+				m_weights[c] = (speaker == SPEAKER_MASK_LFE) ? 0.0 : ((speaker & SPEAKER_MASK_SURROUND) ? 1.41 : 1.0);
+			}
+		}
+		else
+		{
+			//Without a channel mask, an LFE channel is only assumed for the 5.1 and 7.1 layouts
+			const int lfeChannel = ((m_channels == 6) || (m_channels == 8)) ? 3 : -1;
+			for(int c = 0; c < m_channels; c++)
+			{
+				m_weights[c] = (c < 3) ? 1.0 : ((c == lfeChannel) ? 0.0 : 1.41);
+			}
+		}
+
+		m_filterState.fill(0.0, 4 * m_channels);
+		m_samplePeak.fill(0.0, m_channels);
+		m_sumSquares.fill(0.0, m_channels);
+		m_subBlockSize = qMax(1U, input.samplerate / 10U);
+
+		//True peak, polyphase interpolation filter (windowed sinc)
+		m_factor = (input.samplerate < 96000U) ? 4 : ((input.samplerate < 192000U) ? 2 : 1);
+		if(m_factor > 1)
+		{
+			const int length = m_factor * TRUE_PEAK_TAPS;
+			const double center = static_cast<double>(length - 1) / 2.0;
+			m_coeffs.resize(length);
+			for(int p = 0; p < m_factor; p++)
+			{
+				double sum = 0.0;
+				for(int j = 0; j < TRUE_PEAK_TAPS; j++)
+				{
+					const int k = p + (m_factor * j);
+					const double x = (static_cast<double>(k) - center) / static_cast<double>(m_factor);
+					const double sinc = (fabs(x) < 1e-9) ? 1.0 : (sin(PI * x) / (PI * x));
+					const double window = 0.5 - (0.5 * cos((2.0 * PI * (static_cast<double>(k) + 0.5)) / static_cast<double>(length)));
+					sum += (m_coeffs[(p * TRUE_PEAK_TAPS) + j] = static_cast<float>(sinc * window));
+				}
+				for(int j = 0; j < TRUE_PEAK_TAPS; j++)
+				{
+					m_coeffs[(p * TRUE_PEAK_TAPS) + j] = static_cast<float>(m_coeffs[(p * TRUE_PEAK_TAPS) + j] / sum);
+				}
+			}
+			m_history.fill(0.0f, 2 * TRUE_PEAK_TAPS * m_channels);
+			m_historyPos.fill(0, m_channels);
+		}
+
+		return true;
+	}
+
+	virtual bool processBlock(block_t &block)
+	{
+		const int frames = block.isEmpty() ? 0 : block.first().count();
+		int offset = 0;
+
+		while(offset < frames)
+		{
+			const int count = qMin(frames - offset, m_subBlockSize - m_subBlockFill);
+			for(int c = 0; c < m_channels; c++)
+			{
+				analyzeChannel(c, block[c].constData() + offset, count);
+			}
+			offset += count;
+			if((m_subBlockFill += count) >= m_subBlockSize)
+			{
+				finishSubBlock();
+			}
+		}
+
+		m_frames += frames;
+		return true;
+	}
+
+	virtual bool producesOutput(void) const
+	{
+		return false;
+	}
+
+private:
+	void analyzeChannel(const int c, const float *const data, const int count)
+	{
+		double *const state = m_filterState.data() + (4 * c);
+		double peak = m_samplePeak[c], sumSquares = 0.0, energy = 0.0;
+
+		for(int i = 0; i < count; i++)
+		{
+			const double x = data[i];
+			peak = qMax(peak, fabs(x));
+			sumSquares += x * x;
+
+			//Transposed direct form II
+			const double y = (m_preFilter.b0 * x) + state[0];
+			state[0] = (m_preFilter.b1 * x) - (m_preFilter.a1 * y) + state[1];
+			state[1] = (m_preFilter.b2 * x) - (m_preFilter.a2 * y);
+			const double z = (m_rlbFilter.b0 * y) + state[2];
+			state[2] = (m_rlbFilter.b1 * y) - (m_rlbFilter.a1 * z) + state[3];
+			state[3] = (m_rlbFilter.b2 * y) - (m_rlbFilter.a2 * z);
+			energy += z * z;
+		}
+
+		m_samplePeak[c] = peak;
+		m_sumSquares[c] += sumSquares;
+		m_subBlockEnergy += m_weights[c] * energy;
+
+		m_truePeak = qMax(m_truePeak, (m_factor > 1) ? interpolatedPeak(c, data, count) : peak);
+	}
+
+	double interpolatedPeak(const int c, const float *const data, const int count)
+	{
+		float *const history = m_history.data() + (2 * TRUE_PEAK_TAPS * c);
+		const float *const coeffs = m_coeffs.constData();
+		int pos = m_historyPos[c];
+		float peak = 0.0f;
+
+		for(int i = 0; i < count; i++)
+		{
+			//The history is stored twice, so the newest TRUE_PEAK_TAPS samples are always contiguous
+			pos = (pos > 0) ? (pos - 1) : (TRUE_PEAK_TAPS - 1);
+			history[pos] = history[pos + TRUE_PEAK_TAPS] = data[i];
+			const float *const window = history + pos;
+
+			for(int p = 0; p < m_factor; p++)
+			{
+				const float *const phase = coeffs + (p * TRUE_PEAK_TAPS);
+				float value;
+				if(m_useSSE)
+				{
+					__m128 acc = _mm_mul_ps(_mm_loadu_ps(window), _mm_loadu_ps(phase));
+					acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(window + 4), _mm_loadu_ps(phase + 4)));
+					acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(window + 8), _mm_loadu_ps(phase + 8)));
+					acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+					acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+					value = _mm_cvtss_f32(acc);
+				}
+				else
+				{
+					value = 0.0f;
+					for(int j = 0; j < TRUE_PEAK_TAPS; j++)
+					{
+						value += window[j] * phase[j];
+					}
+				}
+				peak = qMax(peak, static_cast<float>(fabs(value)));
+			}
+		}
+
+		m_historyPos[c] = pos;
+		return peak;
+	}
+
+	void finishSubBlock(void)
+	{
+		//Gating blocks are 400 ms long and overlap by 75%
+		m_recentEnergy[(m_subBlockCount++) % 4] = m_subBlockEnergy;
+		if(m_subBlockCount >= 4)
+		{
+			m_blockEnergies << ((m_recentEnergy[0] + m_recentEnergy[1] + m_recentEnergy[2] + m_recentEnergy[3]) / (4.0 * static_cast<double>(m_subBlockSize)));
+		}
+		m_subBlockEnergy = 0.0;
+		m_subBlockFill = 0;
+	}
+
+	bool m_useSSE;
+	int m_channels;
+	int m_factor;
+	int m_subBlockSize;
+	int m_subBlockFill;
+	quint64 m_subBlockCount;
+	double m_subBlockEnergy;
+	double m_recentEnergy[4];
+	biquad_t m_preFilter;
+	biquad_t m_rlbFilter;
+	QVector<double> m_weights;
+	QVector<double> m_filterState;
+	QVector<float> m_coeffs;
+	QVector<float> m_history;
+	QVector<int> m_historyPos;
+};
+
+////////////////////////////////////////////////////////////
+// Analysis Tap
+////////////////////////////////////////////////////////////
+
+/*
+ * Forwards the WAV stream unchanged and analyzes it on the way, the results are handed to the meter at the end of the stream.
+ * A stream that can not be analyzed is still forwarded, the meter simply gets no results.
+ */
+class LoudnessMeter_Tap : public StreamProcessor
+{
+public:
+	LoudnessMeter_Tap(LoudnessMeter *const meter)
+	:
+		m_meter(meter),
+		m_failed(false)
+	{
+	}
+
+	virtual bool begin(const bool &fileInput)
+	{
+		m_failed = (!m_processor.begin(fileInput));
+		return true;
+	}
+
+	virtual bool process(const char *const data, const qint64 size, QByteArray &output)
+	{
+		output.append(data, static_cast<int>(size));
+		if((!m_failed) && (!m_processor.process(data, size, m_discard)))
+		{
+			qWarning("LoudnessMeter: Failed to analyze the stream, loudness will not be available!");
+			m_failed = true;
+		}
+		return true;
+	}
+
+	virtual bool finish(QByteArray& /*output*/)
+	{
+		if((!m_failed) && m_processor.finish(m_discard))
+		{
+			m_meter->takeResults(m_processor);
+		}
+		return true;
+	}
+
+private:
+	LoudnessMeter *const m_meter;
+	LoudnessMeter_Processor m_processor;
+	QByteArray m_discard;
+	bool m_failed;
+};
+
+////////////////////////////////////////////////////////////
+// Constructor & Destructor
+////////////////////////////////////////////////////////////
+
+LoudnessMeter::LoudnessMeter(void)
+:
+	m_truePeak(0.0),
+	m_frames(0)
+{
+}
+
+LoudnessMeter::~LoudnessMeter(void)
+{
+}
+
+////////////////////////////////////////////////////////////
+// Public Functions
+////////////////////////////////////////////////////////////
+
+bool LoudnessMeter::analyze(const QString &sourceFile, QAtomicInt &abortFlag)
+{
+	QFile file(sourceFile);
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		emit messageLogged(QString("Failed to open input file for analysis: %1").arg(QDir::toNativeSeparators(sourceFile)));
+		return false;
+	}
+
+	emit messageLogged(QString("Analyzing input file: %1\n").arg(QDir::toNativeSeparators(sourceFile)));
+
+	LoudnessMeter_Processor processor;
+	QByteArray discard;
+	int prevProgress = -1;
+
+	if(!processor.begin(true))
+	{
+		return false;
+	}
+
+	while(!file.atEnd())
+	{
+		if(CHECK_FLAG(abortFlag))
+		{
+			emit messageLogged("\nABORTED BY USER !!!");
+			return false;
+		}
+
+		const QByteArray buffer = file.read(READ_BUFFER_SIZE);
+		if(buffer.isEmpty() || (!processor.process(buffer.constData(), buffer.size(), discard)))
+		{
+			emit messageLogged("Failed to analyze the input file :-(");
+			return false;
+		}
+
+		const int newProgress = static_cast<int>((100i64 * file.pos()) / qMax(1i64, file.size()));
+		if(newProgress > prevProgress)
+		{
+			emit statusUpdated(newProgress);
+			prevProgress = NEXT_PROGRESS(newProgress);
+		}
+	}
+
+	if(!processor.finish(discard))
+	{
+		emit messageLogged("Failed to analyze the input file :-(");
+		return false;
+	}
+
+	takeResults(processor);
+	return true;
+}
+
+/*
+ * Analyze the WAV stream of a decoder process, the decoded audio is never written to the disk
+ */
+bool LoudnessMeter::analyze(const QString &program, const QStringList &args, QAtomicInt &abortFlag)
+{
+	StreamPipeline pipeline;
+	pipeline.addStage(program, args);
+	return analyze(pipeline, abortFlag);
+}
+
+/*
+ * Analyze the WAV stream of an in-process decoder, takes ownership of the source
+ */
+bool LoudnessMeter::analyze(StreamSource *const source, QAtomicInt &abortFlag)
+{
+	StreamPipeline pipeline;
+	pipeline.setSource(source);
+	return analyze(pipeline, abortFlag);
+}
+
+/*
+ * Create a pipeline stage that analyzes the stream on its way to the next stage, the pipeline takes ownership of the stage.
+ * The results become available once the pipeline has been flushed or detached, the meter must outlive the pipeline.
+ */
+StreamProcessor *LoudnessMeter::createTap(void)
+{
+	m_frames = 0;
+	return new LoudnessMeter_Tap(this);
+}
+
+double LoudnessMeter::samplePeak(void) const
+{
+	double peak = 0.0;
+	for(QVector<double>::ConstIterator iter = m_samplePeak.constBegin(); iter != m_samplePeak.constEnd(); iter++)
+	{
+		peak = qMax(peak, *iter);
+	}
+	return peak;
+}
+
+double LoudnessMeter::integratedLoudness(void) const
+{
+	return integratedLoudness(m_blockEnergies);
+}
+
+/*
+ * Gated loudness according to ITU-R BS.1770, also works for the combined blocks of several files (album loudness)
+ */
+double LoudnessMeter::integratedLoudness(const QVector<double> &blockEnergies)
+{
+	const double absoluteGate = pow(10.0, (GATE_ABSOLUTE + 0.691) / 10.0);
+
+	double sum = 0.0;
+	quint64 count = 0;
+	for(QVector<double>::ConstIterator iter = blockEnergies.constBegin(); iter != blockEnergies.constEnd(); iter++)
+	{
+		if(*iter > absoluteGate)
+		{
+			sum += *iter;
+			count++;
+		}
+	}
+
+	if(count < 1)
+	{
+		return -std::numeric_limits<double>::infinity();
+	}
+
+	const double relativeGate = qMax(absoluteGate, (sum / static_cast<double>(count)) * pow(10.0, GATE_RELATIVE / 10.0));
+
+	sum = 0.0;
+	count = 0;
+	for(QVector<double>::ConstIterator iter = blockEnergies.constBegin(); iter != blockEnergies.constEnd(); iter++)
+	{
+		if(*iter > relativeGate)
+		{
+			sum += *iter;
+			count++;
+		}
+	}
+
+	return (count > 0) ? (-0.691 + (10.0 * log10(sum / static_cast<double>(count)))) : -std::numeric_limits<double>::infinity();
+}
+
+double LoudnessMeter::toDecibel(const double &value)
+{
+	return (value > 0.0) ? (20.0 * log10(value)) : -std::numeric_limits<double>::infinity();
+}
+
+////////////////////////////////////////////////////////////
+// Private Functions
+////////////////////////////////////////////////////////////
+
+bool LoudnessMeter::analyze(StreamPipeline &pipeline, QAtomicInt &abortFlag)
+{
+	LoudnessMeter_Processor *const processor = new LoudnessMeter_Processor();
+
+	connect(&pipeline, SIGNAL(messageLogged(QString)), this, SIGNAL(messageLogged(QString)), Qt::DirectConnection);
+	connect(&pipeline, SIGNAL(statusUpdated(int)), this, SIGNAL(statusUpdated(int)), Qt::DirectConnection);
+	pipeline.addStage(processor);
+
+	if(!pipeline.flush(QString(), abortFlag))
+	{
+		emit messageLogged("Failed to analyze the decoded stream :-(");
+		return false;
+	}
+
+	//The processor is owned by the pipeline, so the results must be taken before it goes away
+	takeResults(*processor);
+	return true;
+}
+
+void LoudnessMeter::takeResults(const LoudnessMeter_Processor &processor)
+{
+	m_frames = processor.m_frames;
+	m_samplePeak = processor.m_samplePeak;
+	m_meanSquare = processor.m_sumSquares;
+	for(int c = 0; c < m_meanSquare.count(); c++)
+	{
+		m_meanSquare[c] /= static_cast<double>(qMax(1ui64, m_frames));
+	}
+	m_truePeak = qMax(processor.m_truePeak, samplePeak());
+	m_blockEnergies = processor.m_blockEnergies;
+
+	emit messageLogged(QString().sprintf("Sample peak: %.2f dBFS, True peak: %.2f dBTP, Integrated loudness: %.1f LUFS", toDecibel(samplePeak()), toDecibel(m_truePeak), integratedLoudness()));
+	emit statusUpdated(100);
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Tool_Abstract.h"
+
+#include <QVector>
+#include <QStringList>
+
+class LoudnessMeter_Processor;
+class LoudnessMeter_Tap;
+class StreamPipeline;
+class StreamSource;
+
+/*
+ * Native analysis of a WAV file: sample peak, true peak (ITU-R BS.1770) and EBU R128 integrated loudness.
+ * The WAV stream may also come from a decoder, in which case the audio is discarded after the analysis.
+ */
+class LoudnessMeter : public AbstractTool
+{
+	Q_OBJECT
+
+public:
+	LoudnessMeter(void);
+	~LoudnessMeter(void);
+
+	bool analyze(const QString &sourceFile, QAtomicInt &abortFlag);
+	bool analyze(const QString &program, const QStringList &args, QAtomicInt &abortFlag);
+	bool analyze(StreamSource *const source, QAtomicInt &abortFlag);
+	StreamProcessor *createTap(void);
+
+	inline unsigned int channels(void) const { return m_samplePeak.count(); }
+	inline quint64 frames(void) const { return m_frames; }
+	inline double samplePeak(const unsigned int channel) const { return m_samplePeak.at(channel); }
+	inline double meanSquare(const unsigned int channel) const { return m_meanSquare.at(channel); }
+	inline double truePeak(void) const { return m_truePeak; }
+	inline const QVector<double> &blockEnergies(void) const { return m_blockEnergies; }
+
+	double samplePeak(void) const;
+	double integratedLoudness(void) const;
+
+	static double integratedLoudness(const QVector<double> &blockEnergies);
+	static double toDecibel(const double &value);
+
+private:
+	friend class LoudnessMeter_Tap;
+
+	bool analyze(StreamPipeline &pipeline, QAtomicInt &abortFlag);
+	void takeResults(const LoudnessMeter_Processor &processor);
+
+	QVector<double> m_samplePeak;
+	QVector<double> m_meanSquare;
+	QVector<double> m_blockEnergies;
+	double m_truePeak;
+	quint64 m_frames;
+};
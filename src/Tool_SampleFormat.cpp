@@ -0,0 +1,557 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Tool_SampleFormat.h"
+
+//MUtils
+#include <MUtils/Global.h>
+#include <MUtils/CPUFeatures.h>
+
+//CRT
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+
+#define SCALE_U8  128.0f
+#define SCALE_S16 32768.0f
+#define SCALE_S24 8388608.0f
+#define SCALE_S32 2147483648.0f
+
+//Largest float values that still fit into the integer formats
+#define LIMIT_U8  127.0f
+#define LIMIT_S16 32767.0f
+#define LIMIT_S24 8388607.0f
+#define LIMIT_S32 2147483520.0f
+
+////////////////////////////////////////////////////////////
+// CPU Dispatch
+////////////////////////////////////////////////////////////
+
+typedef struct
+{
+	bool sse2;
+	bool avx;
+	bool avx2;
+}
+cpu_flags_t;
+
+static cpu_flags_t detectFlags(void)
+{
+	const MUtils::CPUFetaures::cpu_info_t cpuFeatures = MUtils::CPUFetaures::detect();
+	cpu_flags_t flags;
+	flags.sse2 = ((cpuFeatures.features & MUtils::CPUFetaures::FLAG_SSE2) != 0);
+	flags.avx  = ((cpuFeatures.features & MUtils::CPUFetaures::FLAG_AVX) != 0);
+	flags.avx2 = flags.avx && ((cpuFeatures.features & MUtils::CPUFetaures::FLAG_AVX2) != 0);
+	qDebug("SampleFormat: SSE2=%s, AVX=%s, AVX2=%s", MUTILS_BOOL2STR(flags.sse2), MUTILS_BOOL2STR(flags.avx), MUTILS_BOOL2STR(flags.avx2));
+	return flags;
+}
+
+static cpu_flags_t &activeFlags(void)
+{
+	static cpu_flags_t flags = detectFlags();
+	return flags;
+}
+
+static const cpu_flags_t &cpuFlags(void)
+{
+	return activeFlags();
+}
+
+/*
+ * Scalar counterpart of the SIMD code: min/max with the same operand order, so NaN clips to the lower
+ * limit, and round half to even, like CVTPS2DQ does with the default rounding mode
+ */
+static __forceinline qint32 clipAndRound(const float value, const float scale, const float limit)
+{
+	float x = value * scale;
+	x = (x > -scale) ? x : -scale;
+	x = (x < limit) ? x : limit;
+	return static_cast<qint32>(lrintf(x));
+}
+
+////////////////////////////////////////////////////////////
+// Integer to Float
+////////////////////////////////////////////////////////////
+
+static void decodeU8SSE2(const uchar *const src, float *const dst, const int count, int &i)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / SCALE_U8);
+	const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi32(128);
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m128i x = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)), zero);
+		_mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpacklo_epi16(x, zero), bias)), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpackhi_epi16(x, zero), bias)), scale));
+	}
+}
+
+static void decodeS16SSE2(const qint16 *const src, float *const dst, const int count, int &i)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / SCALE_S16);
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		_mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale));
+	}
+}
+
+static void decodeS16AVX2(const qint16 *const src, float *const dst, const int count, int &i)
+{
+	const __m256 scale = _mm256_set1_ps(1.0f / SCALE_S16);
+	for(; i + 16 <= count; i += 16)
+	{
+		const __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+		const __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)));
+		_mm256_storeu_ps(dst + i,     _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+		_mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+	}
+	_mm256_zeroupper();
+}
+
+/*
+ * Each 128-Bit lane takes four packed samples, the bytes are moved to the upper 24 bits of each
+ * 32-Bit element and then sign extended. Both loads read four bytes past the eight samples!
+ */
+static void decodeS24AVX2(const uchar *const src, float *const dst, const int count, int &i)
+{
+	const __m256 scale = _mm256_set1_ps(1.0f / SCALE_S24);
+	const __m256i shuffle = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+	for(; i + 10 <= count; i += 8)
+	{
+		const uchar *const ptr = src + (3 * i);
+		const __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))), _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 12)), 1);
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_shuffle_epi8(x, shuffle), 8)), scale));
+	}
+	_mm256_zeroupper();
+}
+
+static void decodeS32SSE2(const qint32 *const src, float *const dst, const int count, int &i)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / SCALE_S32);
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))), scale));
+	}
+}
+
+static void decodeS32AVX(const qint32 *const src, float *const dst, const int count, int &i)
+{
+	const __m256 scale = _mm256_set1_ps(1.0f / SCALE_S32);
+	for(; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))), scale));
+	}
+	_mm256_zeroupper();
+}
+
+static void decodeF64SSE2(const double *const src, float *const dst, const int count, int &i)
+{
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(src + i)), _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2))));
+	}
+}
+
+static void decodeF64AVX(const double *const src, float *const dst, const int count, int &i)
+{
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+	}
+	_mm256_zeroupper();
+}
+
+////////////////////////////////////////////////////////////
+// Float to Integer
+////////////////////////////////////////////////////////////
+
+static void encodeU8SSE2(const float *const src, uchar *const dst, const int count, int &i)
+{
+	const __m128 scale = _mm_set1_ps(SCALE_U8), lower = _mm_set1_ps(-SCALE_U8), upper = _mm_set1_ps(LIMIT_U8);
+	const __m128i bias = _mm_set1_epi16(128);
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i),     scale), lower), upper);
+		const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lower), upper);
+		const __m128i x = _mm_add_epi16(_mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)), bias);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(x, x));
+	}
+}
+
+static void encodeS16SSE2(const float *const src, qint16 *const dst, const int count, int &i)
+{
+	const __m128 scale = _mm_set1_ps(SCALE_S16), lower = _mm_set1_ps(-SCALE_S16), upper = _mm_set1_ps(LIMIT_S16);
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i),     scale), lower), upper);
+		const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lower), upper);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+	}
+}
+
+static void encodeS16AVX2(const float *const src, qint16 *const dst, const int count, int &i)
+{
+	const __m256 scale = _mm256_set1_ps(SCALE_S16), lower = _mm256_set1_ps(-SCALE_S16), upper = _mm256_set1_ps(LIMIT_S16);
+	for(; i + 16 <= count; i += 16)
+	{
+		const __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i),     scale), lower), upper);
+		const __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale), lower), upper);
+		const __m256i x = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(x, 0xD8)); /*packing works per lane*/
+	}
+	_mm256_zeroupper();
+}
+
+/*
+ * Inverse of the 24-Bit decoder, the upper lane is stored after the lower lane and overwrites its
+ * four padding bytes. The second store writes four bytes past the eight samples!
+ */
+static void encodeS24AVX2(const float *const src, uchar *const dst, const int count, int &i)
+{
+	const __m256 scale = _mm256_set1_ps(SCALE_S24), lower = _mm256_set1_ps(-SCALE_S24), upper = _mm256_set1_ps(LIMIT_S24);
+	const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	for(; i + 10 <= count; i += 8)
+	{
+		const __m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), lower), upper);
+		const __m256i packed = _mm256_shuffle_epi8(_mm256_cvtps_epi32(x), shuffle);
+		uchar *const ptr = dst + (3 * i);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(ptr),      _mm256_castsi256_si128(packed));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(ptr + 12), _mm256_extracti128_si256(packed, 1));
+	}
+	_mm256_zeroupper();
+}
+
+static void encodeS32SSE2(const float *const src, qint32 *const dst, const int count, int &i)
+{
+	const __m128 scale = _mm_set1_ps(SCALE_S32), lower = _mm_set1_ps(-SCALE_S32), upper = _mm_set1_ps(LIMIT_S32);
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128 x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lower), upper);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_cvtps_epi32(x));
+	}
+}
+
+static void encodeS32AVX(const float *const src, qint32 *const dst, const int count, int &i)
+{
+	const __m256 scale = _mm256_set1_ps(SCALE_S32), lower = _mm256_set1_ps(-SCALE_S32), upper = _mm256_set1_ps(LIMIT_S32);
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), lower), upper);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtps_epi32(x));
+	}
+	_mm256_zeroupper();
+}
+
+static void encodeF64SSE2(const float *const src, double *const dst, const int count, int &i)
+{
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(src + i);
+		_mm_storeu_pd(dst + i,     _mm_cvtps_pd(x));
+		_mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+	}
+}
+
+static void encodeF64AVX(const float *const src, double *const dst, const int count, int &i)
+{
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+	}
+	_mm256_zeroupper();
+}
+
+////////////////////////////////////////////////////////////
+// Format Info
+////////////////////////////////////////////////////////////
+
+SampleFormat::format_t SampleFormat::fromWaveFormat(const quint16 formatTag, const quint16 containerBits)
+{
+	switch(formatTag)
+	{
+	case 0x0001: /*WAVE_FORMAT_PCM*/
+		switch(containerBits)
+		{
+			case 8:  return FORMAT_U8;
+			case 16: return FORMAT_S16;
+			case 24: return FORMAT_S24;
+			case 32: return FORMAT_S32;
+		}
+		break;
+	case 0x0003: /*WAVE_FORMAT_IEEE_FLOAT*/
+		switch(containerBits)
+		{
+			case 32: return FORMAT_F32;
+			case 64: return FORMAT_F64;
+		}
+		break;
+	}
+
+	return FORMAT_UNKNOWN;
+}
+
+int SampleFormat::bytesPerSample(const format_t format)
+{
+	switch(format)
+	{
+		case FORMAT_U8:  return 1;
+		case FORMAT_S16: return 2;
+		case FORMAT_S24: return 3;
+		case FORMAT_S32: return 4;
+		case FORMAT_F32: return 4;
+		case FORMAT_F64: return 8;
+		default:         return 0;
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Sample Conversion
+////////////////////////////////////////////////////////////
+
+void SampleFormat::toFloat(const format_t format, const void *const src, float *const dst, const int count)
+{
+	const cpu_flags_t &cpu = cpuFlags();
+	int i = 0;
+
+	switch(format)
+	{
+	case FORMAT_U8:
+		{
+			const uchar *const ptr = static_cast<const uchar*>(src);
+			if(cpu.sse2) decodeU8SSE2(ptr, dst, count, i);
+			for(; i < count; i++)
+			{
+				dst[i] = static_cast<float>(static_cast<int>(ptr[i]) - 128) * (1.0f / SCALE_U8);
+			}
+		}
+		break;
+	case FORMAT_S16:
+		{
+			const qint16 *const ptr = static_cast<const qint16*>(src);
+			if(cpu.avx2) decodeS16AVX2(ptr, dst, count, i);
+			if(cpu.sse2) decodeS16SSE2(ptr, dst, count, i);
+			for(; i < count; i++)
+			{
+				dst[i] = static_cast<float>(ptr[i]) * (1.0f / SCALE_S16);
+			}
+		}
+		break;
+	case FORMAT_S24:
+		{
+			const uchar *const ptr = static_cast<const uchar*>(src);
+			if(cpu.avx2) decodeS24AVX2(ptr, dst, count, i);
+			for(; i < count; i++)
+			{
+				const uchar *const sample = ptr + (3 * i);
+				const qint32 value = static_cast<qint32>((quint32(sample[0]) << 8) | (quint32(sample[1]) << 16) | (quint32(sample[2]) << 24)) >> 8;
+				dst[i] = static_cast<float>(value) * (1.0f / SCALE_S24);
+			}
+		}
+		break;
+	case FORMAT_S32:
+		{
+			const qint32 *const ptr = static_cast<const qint32*>(src);
+			if(cpu.avx)  decodeS32AVX(ptr, dst, count, i);
+			if(cpu.sse2) decodeS32SSE2(ptr, dst, count, i);
+			for(; i < count; i++)
+			{
+				dst[i] = static_cast<float>(ptr[i]) * (1.0f / SCALE_S32);
+			}
+		}
+		break;
+	case FORMAT_F32:
+		memcpy(dst, src, count * sizeof(float));
+		break;
+	case FORMAT_F64:
+		{
+			const double *const ptr = static_cast<const double*>(src);
+			if(cpu.avx)  decodeF64AVX(ptr, dst, count, i);
+			if(cpu.sse2) decodeF64SSE2(ptr, dst, count, i);
+			for(; i < count; i++)
+			{
+				dst[i] = static_cast<float>(ptr[i]);
+			}
+		}
+		break;
+	default:
+		qWarning("SampleFormat: Unknown sample format!");
+		memset(dst, 0, count * sizeof(float));
+		break;
+	}
+}
+
+void SampleFormat::fromFloat(const format_t format, const float *const src, void *const dst, const int count)
+{
+	const cpu_flags_t &cpu = cpuFlags();
+	int i = 0;
+
+	switch(format)
+	{
+	case FORMAT_U8:
+		{
+			uchar *const ptr = static_cast<uchar*>(dst);
+			if(cpu.sse2) encodeU8SSE2(src, ptr, count, i);
+			for(; i < count; i++)
+			{
+				ptr[i] = static_cast<uchar>(clipAndRound(src[i], SCALE_U8, LIMIT_U8) + 128);
+			}
+		}
+		break;
+	case FORMAT_S16:
+		{
+			qint16 *const ptr = static_cast<qint16*>(dst);
+			if(cpu.avx2) encodeS16AVX2(src, ptr, count, i);
+			if(cpu.sse2) encodeS16SSE2(src, ptr, count, i);
+			for(; i < count; i++)
+			{
+				ptr[i] = static_cast<qint16>(clipAndRound(src[i], SCALE_S16, LIMIT_S16));
+			}
+		}
+		break;
+	case FORMAT_S24:
+		{
+			uchar *const ptr = static_cast<uchar*>(dst);
+			if(cpu.avx2) encodeS24AVX2(src, ptr, count, i);
+			for(; i < count; i++)
+			{
+				const qint32 value = clipAndRound(src[i], SCALE_S24, LIMIT_S24);
+				uchar *const sample = ptr + (3 * i);
+				sample[0] = static_cast<uchar>(value & 0xFF);
+				sample[1] = static_cast<uchar>((value >> 8) & 0xFF);
+				sample[2] = static_cast<uchar>((value >> 16) & 0xFF);
+			}
+		}
+		break;
+	case FORMAT_S32:
+		{
+			qint32 *const ptr = static_cast<qint32*>(dst);
+			if(cpu.avx)  encodeS32AVX(src, ptr, count, i);
+			if(cpu.sse2) encodeS32SSE2(src, ptr, count, i);
+			for(; i < count; i++)
+			{
+				ptr[i] = clipAndRound(src[i], SCALE_S32, LIMIT_S32);
+			}
+		}
+		break;
+	case FORMAT_F32:
+		memcpy(dst, src, count * sizeof(float));
+		break;
+	case FORMAT_F64:
+		{
+			double *const ptr = static_cast<double*>(dst);
+			if(cpu.avx)  encodeF64AVX(src, ptr, count, i);
+			if(cpu.sse2) encodeF64SSE2(src, ptr, count, i);
+			for(; i < count; i++)
+			{
+				ptr[i] = static_cast<double>(src[i]);
+			}
+		}
+		break;
+	default:
+		qWarning("SampleFormat: Unknown sample format!");
+		break;
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Channel Layout
+////////////////////////////////////////////////////////////
+
+void SampleFormat::deinterleave(const float *const src, float *const *const dst, const int channels, const int frames)
+{
+	if(channels == 1)
+	{
+		memcpy(dst[0], src, frames * sizeof(float));
+		return;
+	}
+
+	int i = 0;
+	if((channels == 2) && cpuFlags().sse2)
+	{
+		float *const left = dst[0], *const right = dst[1];
+		for(; i + 4 <= frames; i += 4)
+		{
+			const __m128 a = _mm_loadu_ps(src + (2 * i)), b = _mm_loadu_ps(src + (2 * i) + 4);
+			_mm_storeu_ps(left + i,  _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	}
+
+	for(int c = 0; c < channels; c++)
+	{
+		float *const plane = dst[c];
+		for(int k = i; k < frames; k++)
+		{
+			plane[k] = src[(k * channels) + c];
+		}
+	}
+}
+
+void SampleFormat::interleave(const float *const *const src, float *const dst, const int channels, const int frames)
+{
+	if(channels == 1)
+	{
+		memcpy(dst, src[0], frames * sizeof(float));
+		return;
+	}
+
+	int i = 0;
+	if((channels == 2) && cpuFlags().sse2)
+	{
+		const float *const left = src[0], *const right = src[1];
+		for(; i + 4 <= frames; i += 4)
+		{
+			const __m128 l = _mm_loadu_ps(left + i), r = _mm_loadu_ps(right + i);
+			_mm_storeu_ps(dst + (2 * i),     _mm_unpacklo_ps(l, r));
+			_mm_storeu_ps(dst + (2 * i) + 4, _mm_unpackhi_ps(l, r));
+		}
+	}
+
+	for(int c = 0; c < channels; c++)
+	{
+		const float *const plane = src[c];
+		for(int k = i; k < frames; k++)
+		{
+			dst[(k * channels) + c] = plane[k];
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Code Path
+////////////////////////////////////////////////////////////
+
+SampleFormat::simd_t SampleFormat::simdLevel(void)
+{
+	const cpu_flags_t &cpu = cpuFlags();
+	return cpu.avx2 ? SIMD_AVX2 : (cpu.avx ? SIMD_AVX : (cpu.sse2 ? SIMD_SSE2 : SIMD_NONE));
+}
+
+void SampleFormat::setSimdLevel(const simd_t level)
+{
+	const cpu_flags_t detected = detectFlags();
+	cpu_flags_t &flags = activeFlags();
+	flags.sse2 = detected.sse2 && (level >= SIMD_SSE2);
+	flags.avx  = detected.avx  && (level >= SIMD_AVX);
+	flags.avx2 = detected.avx2 && (level >= SIMD_AVX2);
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QtGlobal>
+
+/*
+ * Conversion between the PCM sample formats of WAV streams and float samples, the SIMD code path
+ * (SSE2, AVX or AVX2) is selected once at runtime. Float samples are in the range -1.0 to +1.0,
+ * conversions to integer formats clip samples that are out of range. All code paths produce
+ * bit-identical results, see "etc/Tests" for the test that checks this.
+ */
+class SampleFormat
+{
+public:
+	typedef enum
+	{
+		FORMAT_U8 = 0,
+		FORMAT_S16 = 1,
+		FORMAT_S24 = 2,
+		FORMAT_S32 = 3,
+		FORMAT_F32 = 4,
+		FORMAT_F64 = 5,
+		FORMAT_UNKNOWN = -1
+	}
+	format_t;
+
+	typedef enum
+	{
+		SIMD_NONE = 0,
+		SIMD_SSE2 = 1,
+		SIMD_AVX = 2,
+		SIMD_AVX2 = 3
+	}
+	simd_t;
+
+	static format_t fromWaveFormat(const quint16 formatTag, const quint16 containerBits);
+	static int bytesPerSample(const format_t format);
+
+	//Contiguous samples
+	static void toFloat(const format_t format, const void *const src, float *const dst, const int count);
+	static void fromFloat(const format_t format, const float *const src, void *const dst, const int count);
+
+	//Interleaved frames to planar channels and back
+	static void deinterleave(const float *const src, float *const *const dst, const int channels, const int frames);
+	static void interleave(const float *const *const src, float *const dst, const int channels, const int frames);
+
+	//Restrict the code path to a lower instruction set than the CPU supports, not thread-safe (for testing only)
+	static simd_t simdLevel(void);
+	static void setSimdLevel(const simd_t level);
+
+private:
+	SampleFormat(void) {}
+	~SampleFormat(void) {}
+};
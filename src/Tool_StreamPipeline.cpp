@@ -0,0 +1,654 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Tool_StreamPipeline.h"
+
+//Internal
+#include "Global.h"
+#include "Tool_WaveProperties.h"
+
+//MUtils
+#include <MUtils/Global.h>
+
+//Qt
+#include <QProcess>
+#include <QRegExp>
+#include <QElapsedTimer>
+#include <QFile>
+
+#define PUMP_BLOCK_SIZE 262144
+#define PUMP_HIGH_WATER 8388608
+
+/*
+ * Forwards the output of a source to the next stage, when that stage is a process
+ */
+class PassThroughProcessor : public StreamProcessor
+{
+public:
+	virtual bool begin(const bool& /*fileInput*/)
+	{
+		return true;
+	}
+
+	virtual bool process(const char *const data, const qint64 size, QByteArray &output)
+	{
+		output.append(data, static_cast<int>(size));
+		return true;
+	}
+
+	virtual bool finish(QByteArray& /*output*/)
+	{
+		return true;
+	}
+};
+
+StreamPipeline::StreamPipeline(void)
+:
+	m_sink(NULL),
+	m_inputFile(NULL),
+	m_source(NULL),
+	m_outputFile(NULL),
+	m_processorFailed(false),
+	m_prevProgress(-1),
+	m_bytesIn(0ui64),
+	m_bytesOut(0ui64)
+{
+}
+
+StreamPipeline::~StreamPipeline(void)
+{
+	clear();
+}
+
+/*
+ * Append a new stage to the pipeline, the stage must write its output to "stdout"
+ */
+void StreamPipeline::addStage(const QString &program, const QStringList &args, const QString &workingDir, const bool endsEarly)
+{
+	if(!m_processes.isEmpty())
+	{
+		qWarning("StreamPipeline: Cannot add stages while the pipeline is running!");
+		return;
+	}
+
+	stage_t stage;
+	stage.program = program;
+	stage.args = args;
+	stage.workingDir = workingDir;
+	stage.processor = NULL;
+	stage.endsEarly = endsEarly;
+	m_stages << stage;
+}
+
+/*
+ * Append a new in-process stage to the pipeline, takes ownership of the processor
+ */
+void StreamPipeline::addStage(StreamProcessor *const processor, const QString &inputFile)
+{
+	if(!m_processes.isEmpty())
+	{
+		qWarning("StreamPipeline: Cannot add stages while the pipeline is running!");
+		delete processor;
+		return;
+	}
+
+	stage_t stage;
+	stage.processor = processor;
+	stage.inputFile = inputFile;
+	stage.endsEarly = false;
+	m_stages << stage;
+}
+
+/*
+ * Let the pipeline start with an in-process source, takes ownership of the source
+ */
+void StreamPipeline::setSource(StreamSource *const source)
+{
+	if(!m_stages.isEmpty())
+	{
+		qWarning("StreamPipeline: The source must be set before any stages are added!");
+		delete source;
+		return;
+	}
+
+	//The pipeline pumps the source into the first in-process stage
+	stage_t stage;
+	stage.processor = new PassThroughProcessor();
+	stage.endsEarly = false;
+	m_stages << stage;
+	m_source = source;
+}
+
+/*
+ * Remove all stages from the pipeline
+ */
+void StreamPipeline::clear(void)
+{
+	detach(true);
+	while(!m_stages.isEmpty())
+	{
+		delete m_stages.takeFirst().processor;
+	}
+	MUTILS_DELETE(m_source);
+}
+
+/*
+ * Launch all stages, the last stage will be feeding into the given "sink" process
+ */
+bool StreamPipeline::attach(QProcess &sink)
+{
+	return launch(&sink, QString());
+}
+
+/*
+ * Launch all stages, the last stage will be writing its output to the given file.
+ * The output of a final in-process stage is discarded, if no file is given.
+ */
+bool StreamPipeline::flush(const QString &outputFile, QAtomicInt &abortFlag)
+{
+	if(!launch(NULL, outputFile))
+	{
+		return false;
+	}
+
+	bool bTimeout = false;
+	bool bAborted = false;
+
+	QElapsedTimer idleTimer;
+	idleTimer.start();
+
+	while(isRunning())
+	{
+		if(CHECK_FLAG(abortFlag))
+		{
+			bAborted = true;
+			emit messageLogged("\nABORTED BY USER !!!");
+			break;
+		}
+		if(service(m_pipelineServiceInterval))
+		{
+			idleTimer.restart();
+		}
+		else if(idleTimer.hasExpired(m_processTimeoutInterval))
+		{
+			qWarning("Pipeline process timed out <-- killing!");
+			emit messageLogged("\nPROCESS TIMEOUT !!!");
+			bTimeout = true;
+			break;
+		}
+	}
+
+	bool success = detach(bAborted || bTimeout);
+
+	//The stream was written with placeholder sizes, since its length was not known in advance
+	if(success && (!outputFile.isEmpty()) && (!WaveProperties::updateHeader(outputFile)))
+	{
+		qWarning("StreamPipeline: Failed to update the Wave header of the output file!");
+		emit messageLogged("Failed to update the Wave header of the output file :-(");
+		success = false;
+	}
+
+	if(success)
+	{
+		emit statusUpdated(100);
+	}
+
+	return success;
+}
+
+/*
+ * Read the diagnostic output of all stages, returns true if any output was received
+ */
+bool StreamPipeline::service(const int timeout)
+{
+	bool bActive = false, bWaited = false;
+	QRegExp regExp("\\b(\\d+)(\\.\\d+)*%");
+
+	for(int i = 0; i < m_processes.count(); i++)
+	{
+		QProcess *const process = m_processes.at(i);
+		if(!process)
+		{
+			continue; /*in-process stage*/
+		}
+
+		//Do not read more output of a process, while the in-process stages it feeds can not keep up
+		QProcess *const congested = congestedTarget(i);
+		if(congested)
+		{
+			//Buffered output is pumped right away, only a stage further down the pipeline is worth waiting for
+			if((congested != process) && (!bWaited) && (congested->state() != QProcess::NotRunning))
+			{
+				congested->waitForBytesWritten(timeout);
+				bWaited = true;
+			}
+		}
+		else if(process->state() != QProcess::NotRunning)
+		{
+			process->waitForReadyRead(bWaited ? 0 : timeout);
+			bWaited = true;
+		}
+
+		//A process that feeds an in-process stage is waiting on its standard output
+		const bool feedsProcessor = isProcessor(i + 1);
+		if(feedsProcessor)
+		{
+			process->setReadChannel(QProcess::StandardError);
+		}
+
+		while(process->bytesAvailable() > 0)
+		{
+			QByteArray line = process->readLine();
+			line.replace('\r', char(0x20)).replace('\b', char(0x20)).replace('\t', char(0x20));
+			const QString text = QString::fromUtf8(line.constData()).simplified();
+			if(!text.isEmpty())
+			{
+				bActive = true;
+				if((i == 0) && (regExp.lastIndexIn(text) >= 0))
+				{
+					//Only the first stage knows the overall progress
+					qint32 newProgress;
+					if(MUtils::regexp_parse_int32(regExp, newProgress) && (newProgress > m_prevProgress))
+					{
+						emit statusUpdated(newProgress);
+						m_prevProgress = NEXT_PROGRESS(newProgress);
+					}
+					continue;
+				}
+				emit messageLogged(text);
+			}
+		}
+
+		if(feedsProcessor)
+		{
+			process->setReadChannel(QProcess::StandardOutput);
+		}
+	}
+
+	//Pump the data through all in-process stages
+	for(int i = 0; i < m_processes.count(); i++)
+	{
+		if(m_runningProcessors.contains(i) && (!isProcessor(i - 1)))
+		{
+			if(pump(i))
+			{
+				bActive = true;
+			}
+		}
+	}
+
+	return bActive;
+}
+
+/*
+ * Wait for all stages to terminate, returns true if all of them have completed successfully
+ */
+bool StreamPipeline::detach(const bool bAbort)
+{
+	bool success = (!bAbort);
+
+	if(m_processes.isEmpty())
+	{
+		return success;
+	}
+
+	for(int i = 0; i < m_processes.count(); i++)
+	{
+		QProcess *const process = m_processes.at(i);
+		if(!process)
+		{
+			continue; /*in-process stage*/
+		}
+		if(bAbort)
+		{
+			process->kill();
+		}
+		else if(!process->waitForFinished(m_processTimeoutInterval / 40))
+		{
+			qWarning("Pipeline stage did not terminate <-- killing!");
+			process->kill();
+			success = false;
+		}
+		process->waitForFinished(-1);
+	}
+
+	if(!m_runningProcessors.isEmpty())
+	{
+		if(!bAbort)
+		{
+			qWarning("In-process pipeline stage did not complete!");
+		}
+		m_runningProcessors.clear();
+		success = false;
+	}
+
+	service();
+
+	if(m_processorFailed)
+	{
+		success = false;
+	}
+
+	//A stage that feeds a stage, which stops reading early and did complete, fails on the broken pipe
+	QList<bool> tolerated;
+	for(int i = 0; i < m_processes.count(); i++)
+	{
+		QProcess *const next = ((i + 1) < m_processes.count()) ? m_processes.at(i + 1) : NULL;
+		tolerated << (next && m_stages.at(i + 1).endsEarly && (next->exitStatus() == QProcess::NormalExit) && (next->exitCode() == EXIT_SUCCESS));
+	}
+
+	while(!m_processes.isEmpty())
+	{
+		const bool bTolerated = tolerated.takeFirst();
+		QProcess *const process = m_processes.takeFirst();
+		if(!process)
+		{
+			if(!bAbort)
+			{
+				emit messageLogged(QString().sprintf("\nPipeline stage #%d completed in-process", m_stages.count() - m_processes.count()));
+			}
+			continue;
+		}
+		if(((process->exitStatus() != QProcess::NormalExit) || (process->exitCode() != EXIT_SUCCESS)) && (!bTolerated))
+		{
+			success = false;
+		}
+		if(!bAbort)
+		{
+			emit messageLogged(QString().sprintf("\nPipeline stage #%d exited with code: 0x%04X", m_stages.count() - m_processes.count(), process->exitCode()));
+		}
+		MUTILS_DELETE(process);
+	}
+
+	MUTILS_DELETE(m_inputFile);
+	MUTILS_DELETE(m_outputFile);
+	m_sink = NULL;
+
+	return success;
+}
+
+/*
+ * Create and start the processes for all stages
+ */
+bool StreamPipeline::launch(QProcess *const sink, const QString &outputFile)
+{
+	if(!m_processes.isEmpty())
+	{
+		qWarning("StreamPipeline: Pipeline is already running!");
+		return false;
+	}
+
+	m_prevProgress = -1;
+	m_processorFailed = false;
+	m_sink = sink;
+
+	for(int i = 0; i < m_stages.count(); i++)
+	{
+		m_processes << (m_stages.at(i).processor ? NULL : new QProcess());
+	}
+
+	for(int i = 0; i < m_stages.count(); i++)
+	{
+		const stage_t &stage = m_stages.at(i);
+
+		//Set up the in-process stage, the first stage reads from a file and the last stage writes to the sink or to a file
+		if(stage.processor)
+		{
+			if((i == 0) && m_source)
+			{
+				if(!m_source->open())
+				{
+					qWarning("StreamPipeline: Failed to open the source of the pipeline!");
+					detach(true);
+					return false;
+				}
+			}
+			else if((i == 0) && (!m_inputFile))
+			{
+				m_inputFile = new QFile(stage.inputFile);
+				if(stage.inputFile.isEmpty() || (!m_inputFile->open(QIODevice::ReadOnly)))
+				{
+					qWarning("StreamPipeline: Failed to open input file for in-process stage!");
+					detach(true);
+					return false;
+				}
+			}
+			if(((i + 1) >= m_stages.count()) && (!sink) && (!outputFile.isEmpty()))
+			{
+				m_outputFile = new QFile(outputFile);
+				if(!m_outputFile->open(QIODevice::WriteOnly | QIODevice::Truncate))
+				{
+					qWarning("StreamPipeline: Failed to open output file for in-process stage!");
+					detach(true);
+					return false;
+				}
+			}
+			if(!stage.processor->begin(i == 0))
+			{
+				detach(true);
+				return false;
+			}
+			m_runningProcessors.insert(i);
+			continue;
+		}
+
+		QProcess *const next = ((i + 1) < m_processes.count()) ? m_processes.at(i + 1) : sink;
+		const bool feedsProcessor = isProcessor(i + 1);
+
+		const bool started = startProcess(*m_processes.at(i), stage.program, stage.args, stage.workingDir, [next, feedsProcessor, &outputFile](QProcess &process)
+		{
+			//Keep the diagnostic output separate from the audio data
+			process.setProcessChannelMode(QProcess::SeparateChannels);
+			if(feedsProcessor)
+			{
+				process.setReadChannel(QProcess::StandardOutput);
+				process.setReadBufferSize(PUMP_HIGH_WATER); /*the process is stalled, once the buffer is full*/
+			}
+			else if(next)
+			{
+				process.setReadChannel(QProcess::StandardError);
+				process.setStandardOutputProcess(next);
+			}
+			else
+			{
+				process.setReadChannel(QProcess::StandardError);
+				process.setStandardOutputFile(outputFile);
+			}
+		});
+
+		if(!started)
+		{
+			detach(true);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Pump the available data through a run of consecutive in-process stages, returns true if any data was moved
+ */
+bool StreamPipeline::pump(const int first)
+{
+	int last = first;
+	while(isProcessor(last + 1))
+	{
+		last++;
+	}
+
+	QProcess *const source = (first > 0) ? m_processes.at(first - 1) : NULL;
+	QProcess *const target = ((last + 1) < m_processes.count()) ? m_processes.at(last + 1) : m_sink;
+
+	bool bActive = false;
+	qint64 pumped = 0;
+
+	while(m_runningProcessors.contains(first) && (pumped < PUMP_HIGH_WATER))
+	{
+		if(target && (target->bytesToWrite() >= PUMP_HIGH_WATER))
+		{
+			break; /*the next stage is busy*/
+		}
+
+		QByteArray data;
+		bool eof = false, success = true;
+
+		if(source)
+		{
+			data = source->read(PUMP_BLOCK_SIZE);
+			eof = data.isEmpty() && (source->state() == QProcess::NotRunning) && (source->bytesAvailable() < 1);
+		}
+		else if(m_source)
+		{
+			success = m_source->read(data, PUMP_BLOCK_SIZE, eof);
+			const int newProgress = m_source->progress();
+			if(newProgress > m_prevProgress)
+			{
+				emit statusUpdated(newProgress);
+				m_prevProgress = NEXT_PROGRESS(newProgress);
+			}
+		}
+		else
+		{
+			data = m_inputFile->read(PUMP_BLOCK_SIZE);
+			eof = m_inputFile->atEnd();
+			success = (!data.isEmpty()) || eof;
+			if(m_inputFile->size() > 0)
+			{
+				const int newProgress = static_cast<int>((100i64 * m_inputFile->pos()) / m_inputFile->size());
+				if(newProgress > m_prevProgress)
+				{
+					emit statusUpdated(newProgress);
+					m_prevProgress = NEXT_PROGRESS(newProgress);
+				}
+			}
+		}
+
+		if(data.isEmpty() && (!eof) && success)
+		{
+			break; /*no input available yet*/
+		}
+
+		pumped += data.size();
+		m_bytesIn += data.size();
+		bActive = true;
+
+		for(int i = first; (i <= last) && success; i++)
+		{
+			QByteArray output;
+			success = m_stages.at(i).processor->process(data.constData(), data.size(), output);
+			if(success && eof)
+			{
+				success = m_stages.at(i).processor->finish(output);
+			}
+			data = output;
+		}
+
+		if(success && (!data.isEmpty()))
+		{
+			success = (target ? target->write(data) : (m_outputFile ? m_outputFile->write(data) : data.size())) == data.size();
+			m_bytesOut += data.size();
+		}
+
+		if(!success)
+		{
+			qWarning("StreamPipeline: In-process stage has failed!");
+			emit messageLogged("In-process pipeline stage has failed :-(");
+			m_processorFailed = true;
+			for(int i = 0; i < first; i++)
+			{
+				if(m_processes.at(i))
+				{
+					m_processes.at(i)->kill();
+				}
+			}
+		}
+
+		if(eof || (!success))
+		{
+			for(int i = first; i <= last; i++)
+			{
+				m_runningProcessors.remove(i);
+			}
+			if(target)
+			{
+				target->closeWriteChannel();
+			}
+			else if(m_outputFile)
+			{
+				m_outputFile->close();
+			}
+		}
+	}
+
+	return bActive;
+}
+
+/*
+ * Check whether the in-process stages after the process with the given index are backed up, returns the stage that is holding them up.
+ * If only the output of the process has not been pumped yet, the process itself is returned.
+ */
+QProcess *StreamPipeline::congestedTarget(const int index) const
+{
+	if(!isProcessor(index + 1))
+	{
+		return NULL;
+	}
+
+	int last = index + 1;
+	while(isProcessor(last + 1))
+	{
+		last++;
+	}
+
+	QProcess *const target = ((last + 1) < m_processes.count()) ? m_processes.at(last + 1) : m_sink;
+	if(target && (target->bytesToWrite() >= PUMP_HIGH_WATER))
+	{
+		return target;
+	}
+
+	QProcess *const process = m_processes.at(index);
+	return (process->bytesAvailable() >= PUMP_HIGH_WATER) ? process : NULL;
+}
+
+/*
+ * Check whether the stage with the given index runs in-process
+ */
+bool StreamPipeline::isProcessor(const int index) const
+{
+	return (index >= 0) && (index < m_stages.count()) && (m_stages.at(index).processor != NULL);
+}
+
+/*
+ * Check whether any stage is still running
+ */
+bool StreamPipeline::isRunning(void) const
+{
+	for(QList<QProcess*>::ConstIterator iter = m_processes.constBegin(); iter != m_processes.constEnd(); iter++)
+	{
+		if((*iter) && ((*iter)->state() != QProcess::NotRunning))
+		{
+			return true;
+		}
+	}
+	return !m_runningProcessors.isEmpty();
+}
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// LameXP - Audio Encoder Front-End
+// Copyright (C) 2004-2025 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU GENERAL PUBLIC LICENSE as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version; always including the non-optional
+// LAMEXP GNU GENERAL PUBLIC LICENSE ADDENDUM. See "License.txt" file!
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Tool_Abstract.h"
+
+#include <QList>
+#include <QStringList>
+#include <QSet>
+
+class QProcess;
+class QFile;
+
+/*
+ * An in-process stage, consumes the WAV stream of the previous stage and produces a new WAV stream.
+ * The first stage of a pipeline reads its input from a file, the WAV stream of a file is trusted.
+ */
+class StreamProcessor
+{
+public:
+	virtual ~StreamProcessor(void) {}
+
+	virtual bool begin(const bool &fileInput) = 0;
+	virtual bool process(const char *const data, const qint64 size, QByteArray &output) = 0;
+	virtual bool finish(QByteArray &output) = 0;
+};
+
+/*
+ * An in-process source, produces the WAV stream for the first stage of a pipeline instead of a file
+ */
+class StreamSource
+{
+public:
+	virtual ~StreamSource(void) {}
+
+	virtual bool open(void) = 0;
+	virtual bool read(QByteArray &data, const qint64 maxSize, bool &eof) = 0;
+	virtual int progress(void) const = 0;
+};
+
+/*
+ * A chain of processes, each one writing a WAV stream to the standard input of the next one.
+ * Stages may also run in-process, in which case the pipeline pumps the data through them.
+ * The pipeline either feeds into the "sink" process of another tool or is flushed to a file.
+ */
+class StreamPipeline : public AbstractTool
+{
+	Q_OBJECT
+
+public:
+	StreamPipeline(void);
+	~StreamPipeline(void);
+
+	void addStage(const QString &program, const QStringList &args, const QString &workingDir = QString(), const bool endsEarly = false);
+	void addStage(StreamProcessor *const processor, const QString &inputFile = QString());
+	void setSource(StreamSource *const source);
+	void clear(void);
+
+	inline bool isEmpty(void) const { return m_stages.isEmpty(); }
+	inline int stageCount(void) const { return m_stages.count(); }
+
+	bool attach(QProcess &sink);
+	bool detach(const bool bAbort = false);
+	bool service(const int timeout = 0);
+	bool flush(const QString &outputFile, QAtomicInt &abortFlag);
+
+	//Bytes that went into and came out of the in-process stages, since the pipeline was created
+	inline quint64 bytesIn(void) const { return m_bytesIn; }
+	inline quint64 bytesOut(void) const { return m_bytesOut; }
+
+private:
+	typedef struct
+	{
+		QString program;
+		QStringList args;
+		QString workingDir;
+		StreamProcessor *processor;
+		QString inputFile;
+		bool endsEarly;		//Stops reading before the end of its input, e.g. "trim"
+	}
+	stage_t;
+
+	bool launch(QProcess *const sink, const QString &outputFile);
+	bool isRunning(void) const;
+	bool isProcessor(const int index) const;
+	QProcess *congestedTarget(const int index) const;
+	bool pump(const int first);
+
+	QList<stage_t> m_stages;
+	QList<QProcess*> m_processes;
+	QSet<int> m_runningProcessors;
+	QProcess *m_sink;
+	QFile *m_inputFile;
+	StreamSource *m_source;
+	QFile *m_outputFile;
+	bool m_processorFailed;
+	int m_prevProgress;
+	quint64 m_bytesIn;
+	quint64 m_bytesOut;
+};
@@ -32,6 +32,35 @@
 //Qt
 #include <QDir>
 #include <QProcess>
+#include <QFile>
+#include <QtEndian>
+
+//CRT
+#include <string.h>
+#include <limits.h>
+
+#define WAVE_FORMAT_PCM        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+//Size of the "ds64" chunk without a table, the "JUNK" chunk of a new header reserves the same size
+#define DS64_SIZE 28U
+
+#define IS_VALID(X) (((X) != 0U) && ((X) != UINT_MAX))
+
+//Projected size above which intermediate files are written as Wave64 (leaves some headroom below the RIFF limit)
+static const quint64 RIFF_SIZE_LIMIT = 3758096384ui64;
+
+//Wave64 GUID's
+static const unsigned char W64_GUID_RIFF[16] = { 0x72, 0x69, 0x66, 0x66, 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00 };
+static const unsigned char W64_GUID_WAVE[16] = { 0x77, 0x61, 0x76, 0x65, 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+static const unsigned char W64_GUID_FMT [16] = { 0x66, 0x6D, 0x74, 0x20, 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+static const unsigned char W64_GUID_DATA[16] = { 0x64, 0x61, 0x74, 0x61, 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+
+static inline bool isChunkId(const char *const id, const bool wave64, const char *const fourCC, const void *const guid)
+{
+	return (memcmp(id, wave64 ? guid : fourCC, wave64 ? 16 : 4) == 0);
+}
 
 WaveProperties::WaveProperties(void)
 :
@@ -49,6 +78,11 @@ WaveProperties::~WaveProperties(void)
 
 bool WaveProperties::detect(const QString &sourceFile, AudioFileModel_TechInfo *info, QAtomicInt &abortFlag)
 {
+	if(detectNative(sourceFile, info))
+	{
+		return true;
+	}
+
 	QProcess process;
 	QStringList args;
 
@@ -124,3 +158,325 @@ bool WaveProperties::detect(const QString &sourceFile, AudioFileModel_TechInfo *
 	
 	return (result == RESULT_SUCCESS);
 }
+
+bool WaveProperties::detectNative(const QString &sourceFile, AudioFileModel_TechInfo *info)
+{
+	QFile file(sourceFile);
+	header_t header;
+
+	if(!(file.open(QIODevice::ReadOnly) && parseHeader(file, header)))
+	{
+		return false;
+	}
+
+	const bool isFloat = (header.formatTag == WAVE_FORMAT_IEEE_FLOAT);
+
+	info->setAudioSamplerate(header.samplerate);
+	info->setAudioChannels(header.channels);
+	info->setAudioBitdepth((isFloat && (header.bitsPerSample == 32)) ? AudioFileModel::BITDEPTH_IEEE_FLOAT32 : header.bitsPerSample);
+	info->setDuration(static_cast<unsigned int>((header.frameCount + (header.samplerate / 2U)) / header.samplerate));
+
+	emit messageLogged(QString("Wave header: %1 Hz, %2 channel(s), %3-Bit %4, %5 samples").arg(QString::number(header.samplerate), QString::number(header.channels), QString::number(header.bitsPerSample), QString(isFloat ? "Float" : "PCM"), QString::number(header.frameCount)));
+	emit statusUpdated(100);
+
+	return true;
+}
+
+bool WaveProperties::parseHeader(QIODevice &file, header_t &header)
+{
+	char signature[40];
+	if(file.read(signature, 12) != 12)
+	{
+		return false;
+	}
+
+	const bool rf64 = (memcmp(signature, "RF64", 4) == 0);
+	const bool wave64 = (memcmp(signature, W64_GUID_RIFF, 12) == 0);
+
+	if(wave64)
+	{
+		if((file.read(signature + 12, 28) != 28) || memcmp(signature, W64_GUID_RIFF, 16) || memcmp(signature + 24, W64_GUID_WAVE, 16))
+		{
+			return false; /*not a Wave64 file*/
+		}
+	}
+	else if((memcmp(signature, "RIFF", 4) && (!rf64)) || memcmp(signature + 8, "WAVE", 4))
+	{
+		return false; /*not a RIFF Wave file*/
+	}
+
+	header.formatChunk.clear();
+	header.dataOffset = -1;
+	quint64 ds64DataSize = 0;
+
+	while(header.dataOffset < 0)
+	{
+		char chunkHeader[24];
+		const qint64 chunkStart = file.pos();
+		const qint64 headerSize = wave64 ? 24 : 8;
+		if(file.read(chunkHeader, headerSize) != headerSize)
+		{
+			return false;
+		}
+
+		quint64 chunkSize = wave64 ? qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(chunkHeader + 16)) : qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(chunkHeader + 4));
+		if(wave64)
+		{
+			if(chunkSize < 24U)
+			{
+				return false;
+			}
+			chunkSize -= 24U; /*Wave64 sizes include the chunk header*/
+		}
+		const qint64 nextChunk = wave64 ? ((chunkStart + 24 + static_cast<qint64>(chunkSize) + 7) & ~7i64) : (chunkStart + 8 + static_cast<qint64>(chunkSize + (chunkSize & 1U)));
+
+		if(isChunkId(chunkHeader, wave64, "fmt ", W64_GUID_FMT))
+		{
+			if((chunkSize < 16U) || (chunkSize > 1024U))
+			{
+				return false;
+			}
+			header.formatChunk = file.read(static_cast<qint64>(chunkSize));
+			if(static_cast<quint64>(header.formatChunk.size()) != chunkSize)
+			{
+				return false;
+			}
+		}
+		else if(rf64 && (memcmp(chunkHeader, "ds64", 4) == 0))
+		{
+			const QByteArray ds64 = file.read(static_cast<qint64>(qMin(chunkSize, 24ui64)));
+			if(ds64.size() < 24)
+			{
+				return false;
+			}
+			ds64DataSize = qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(ds64.constData() + 8));
+		}
+		else if(isChunkId(chunkHeader, wave64, "data", W64_GUID_DATA))
+		{
+			header.dataOffset = file.pos();
+			const quint64 available = static_cast<quint64>(qMax(0i64, file.size() - header.dataOffset));
+			if((!wave64) && ((chunkSize == 0U) || (chunkSize == 0xFFFFFFFFU)))
+			{
+				chunkSize = rf64 ? ds64DataSize : 0U;
+			}
+			header.dataSize = chunkSize;
+			header.frameCount = (chunkSize > 0U) ? qMin(available, chunkSize) : available;
+			break;
+		}
+
+		if(!file.seek(nextChunk))
+		{
+			return false;
+		}
+	}
+
+	if(header.formatChunk.isEmpty())
+	{
+		return false; /*data before format*/
+	}
+
+	const uchar *const fmt = reinterpret_cast<const uchar*>(header.formatChunk.constData());
+	header.formatTag = qFromLittleEndian<quint16>(fmt);
+	header.channels = qFromLittleEndian<quint16>(fmt + 2);
+	header.samplerate = qFromLittleEndian<quint32>(fmt + 4);
+	header.blockAlign = qFromLittleEndian<quint16>(fmt + 12);
+	header.bitsPerSample = qFromLittleEndian<quint16>(fmt + 14);
+	header.channelMask = 0U;
+
+	//Resolve the actual format of WAVE_FORMAT_EXTENSIBLE files
+	if(header.formatTag == WAVE_FORMAT_EXTENSIBLE)
+	{
+		if(header.formatChunk.size() < 40)
+		{
+			return false;
+		}
+		const quint16 validBits = qFromLittleEndian<quint16>(fmt + 18);
+		header.channelMask = qFromLittleEndian<quint32>(fmt + 20);
+		header.formatTag = qFromLittleEndian<quint16>(fmt + 24);
+		if((validBits > 0) && (validBits < header.bitsPerSample))
+		{
+			header.bitsPerSample = validBits;
+		}
+	}
+
+	if(((header.formatTag != WAVE_FORMAT_PCM) && (header.formatTag != WAVE_FORMAT_IEEE_FLOAT)) || (header.channels < 1) || (header.samplerate < 1) || (header.blockAlign < 1) || (header.bitsPerSample < 1))
+	{
+		return false; /*unsupported format*/
+	}
+
+	header.frameCount /= header.blockAlign;
+	return true;
+}
+
+/*
+ * Decoded files that would exceed the size limit of a RIFF file are written as Wave64
+ */
+bool WaveProperties::useWave64(const AudioFileModel_TechInfo &formatInfo, quint64 *const projectedSize)
+{
+	if((!IS_VALID(formatInfo.audioSamplerate())) || (!IS_VALID(formatInfo.audioChannels())) || (formatInfo.duration() == 0))
+	{
+		return false;
+	}
+
+	//Assume 32-Bit samples, if the bit depth is unknown (e.g. lossy sources) or floating point
+	const quint64 bytesPerSample = (IS_VALID(formatInfo.audioBitdepth()) && (formatInfo.audioBitdepth() <= 64U)) ? ((static_cast<quint64>(formatInfo.audioBitdepth()) + 7ui64) / 8ui64) : 4ui64;
+	const quint64 size = static_cast<quint64>(formatInfo.duration() + 1U) * formatInfo.audioSamplerate() * formatInfo.audioChannels() * bytesPerSample;
+
+	if(projectedSize)
+	{
+		*projectedSize = size;
+	}
+
+	return (size >= RIFF_SIZE_LIMIT);
+}
+
+/*
+ * The "JUNK" chunk reserves the space of a "ds64" chunk, so that the file can be turned into RF64 in place, if it grows beyond the RIFF limit
+ */
+QByteArray WaveProperties::makeHeader(const QByteArray &formatChunk, const quint64 dataSize)
+{
+	QByteArray header;
+	uchar value[4];
+
+	const quint32 formatSize = static_cast<quint32>(formatChunk.size());
+	const quint64 riffSize = 4U + (8U + DS64_SIZE) + 8U + formatSize + (formatSize & 1U) + 8U + dataSize + (dataSize & 1U);
+	const bool unknownSize = (riffSize > 0xFFFFFFFFui64);
+
+	header.append("RIFF", 4);
+	qToLittleEndian<quint32>(unknownSize ? 0xFFFFFFFFU : static_cast<quint32>(riffSize), value); header.append(reinterpret_cast<const char*>(value), 4);
+	header.append("WAVE", 4);
+	header.append("JUNK", 4);
+	qToLittleEndian<quint32>(DS64_SIZE, value); header.append(reinterpret_cast<const char*>(value), 4);
+	header.append(QByteArray(static_cast<int>(DS64_SIZE), '\0'));
+	header.append("fmt ", 4);
+	qToLittleEndian<quint32>(formatSize, value); header.append(reinterpret_cast<const char*>(value), 4);
+	header.append(formatChunk);
+	if(formatSize & 1U) header.append('\0');
+	header.append("data", 4);
+	qToLittleEndian<quint32>(unknownSize ? 0xFFFFFFFFU : static_cast<quint32>(dataSize), value); header.append(reinterpret_cast<const char*>(value), 4);
+
+	return header;
+}
+
+/*
+ * Replace the sizes of a RIFF Wave file, that was written as a stream, by the actual sizes of the file.
+ * Files that exceed the RIFF limit are converted to RF64. Only the header is rewritten, if the file starts with the "JUNK" chunk
+ * written by makeHeader(), otherwise the data has to be moved.
+ */
+bool WaveProperties::updateHeader(const QString &fileName)
+{
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadWrite))
+	{
+		return false;
+	}
+
+	char signature[4];
+	if((file.read(signature, 4) != 4) || memcmp(signature, "RIFF", 4))
+	{
+		return true; /*only RIFF files are written with placeholder sizes*/
+	}
+
+	header_t header;
+	if(!(file.seek(0) && parseHeader(file, header)))
+	{
+		return false;
+	}
+
+	const quint64 dataSize = static_cast<quint64>(file.size() - header.dataOffset);
+	const quint64 riffSize = static_cast<quint64>(header.dataOffset) - 8U + dataSize + (dataSize & 1U);
+	uchar value[8];
+
+	if(riffSize <= 0xFFFFFFFFui64)
+	{
+		if(dataSize & 1U)
+		{
+			if(!(file.seek(file.size()) && file.putChar('\0')))
+			{
+				return false;
+			}
+		}
+		qToLittleEndian<quint32>(static_cast<quint32>(riffSize), value);
+		if(!(file.seek(4) && (file.write(reinterpret_cast<const char*>(value), 4) == 4)))
+		{
+			return false;
+		}
+		qToLittleEndian<quint32>(static_cast<quint32>(dataSize), value);
+		return file.seek(header.dataOffset - 4) && (file.write(reinterpret_cast<const char*>(value), 4) == 4);
+	}
+
+	//Turn the placeholder into the "ds64" chunk
+	char placeholder[8];
+	if(file.seek(12) && (file.read(placeholder, 8) == 8) && (memcmp(placeholder, "JUNK", 4) == 0) && (qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(placeholder + 4)) == DS64_SIZE))
+	{
+		if(dataSize & 1U)
+		{
+			if(!(file.seek(file.size()) && file.putChar('\0')))
+			{
+				return false;
+			}
+		}
+		QByteArray ds64Header;
+		ds64Header.append("RF64", 4);
+		ds64Header.append("\xFF\xFF\xFF\xFF", 4);
+		ds64Header.append("WAVE", 4);
+		ds64Header.append("ds64", 4);
+		qToLittleEndian<quint32>(DS64_SIZE, value); ds64Header.append(reinterpret_cast<const char*>(value), 4);
+		qToLittleEndian<quint64>(riffSize, value); ds64Header.append(reinterpret_cast<const char*>(value), 8);
+		qToLittleEndian<quint64>(dataSize, value); ds64Header.append(reinterpret_cast<const char*>(value), 8);
+		qToLittleEndian<quint64>(dataSize / header.blockAlign, value); ds64Header.append(reinterpret_cast<const char*>(value), 8);
+		qToLittleEndian<quint32>(0U, value); ds64Header.append(reinterpret_cast<const char*>(value), 4);
+		if(!(file.seek(0) && (file.write(ds64Header) == ds64Header.size())))
+		{
+			return false;
+		}
+		return file.seek(header.dataOffset - 4) && (file.write("\xFF\xFF\xFF\xFF", 4) == 4);
+	}
+
+	//Build the RF64 header, all sizes are taken from the "ds64" chunk
+	const quint32 formatSize = static_cast<quint32>(header.formatChunk.size());
+	const quint64 rf64Size = 4U + (8U + 28U) + 8U + formatSize + (formatSize & 1U) + 8U + dataSize + (dataSize & 1U);
+	QByteArray rf64Header;
+	rf64Header.append("RF64", 4);
+	rf64Header.append("\xFF\xFF\xFF\xFF", 4);
+	rf64Header.append("WAVE", 4);
+	rf64Header.append("ds64", 4);
+	qToLittleEndian<quint32>(28U, value); rf64Header.append(reinterpret_cast<const char*>(value), 4);
+	qToLittleEndian<quint64>(rf64Size, value); rf64Header.append(reinterpret_cast<const char*>(value), 8);
+	qToLittleEndian<quint64>(dataSize, value); rf64Header.append(reinterpret_cast<const char*>(value), 8);
+	qToLittleEndian<quint64>(dataSize / header.blockAlign, value); rf64Header.append(reinterpret_cast<const char*>(value), 8);
+	qToLittleEndian<quint32>(0U, value); rf64Header.append(reinterpret_cast<const char*>(value), 4);
+	rf64Header.append("fmt ", 4);
+	qToLittleEndian<quint32>(formatSize, value); rf64Header.append(reinterpret_cast<const char*>(value), 4);
+	rf64Header.append(header.formatChunk);
+	if(formatSize & 1U) rf64Header.append('\0');
+	rf64Header.append("data", 4);
+	rf64Header.append("\xFF\xFF\xFF\xFF", 4);
+
+	QFile rf64File(QString("%1.rf64").arg(fileName));
+	if(!(rf64File.open(QIODevice::WriteOnly | QIODevice::Truncate) && (rf64File.write(rf64Header) == rf64Header.size()) && file.seek(header.dataOffset)))
+	{
+		rf64File.remove();
+		return false;
+	}
+
+	while(!file.atEnd())
+	{
+		const QByteArray buffer = file.read(1048576);
+		if(buffer.isEmpty() || (rf64File.write(buffer) != buffer.size()))
+		{
+			rf64File.remove();
+			return false;
+		}
+	}
+
+	if((dataSize & 1U) && (!rf64File.putChar('\0')))
+	{
+		rf64File.remove();
+		return false;
+	}
+
+	file.close();
+	rf64File.close();
+	return file.remove() && rf64File.rename(fileName);
+}
@@ -24,6 +24,7 @@
 #include "Tool_Abstract.h"
 
 class AudioFileModel_TechInfo;
+class QIODevice;
 
 class WaveProperties : public AbstractTool
 {
@@ -35,6 +36,28 @@ public:
 
 	bool detect(const QString &sourceFile, AudioFileModel_TechInfo *info, QAtomicInt &abortFlag);
 
+	typedef struct
+	{
+		QByteArray formatChunk;
+		quint16 formatTag;
+		quint16 channels;
+		quint32 samplerate;
+		quint16 blockAlign;
+		quint16 bitsPerSample;
+		quint32 channelMask;	//Speaker positions, zero if not specified
+		qint64 dataOffset;
+		quint64 dataSize;	//Declared size of the data chunk, zero if unknown
+		quint64 frameCount;
+	}
+	header_t;
+
+	static bool parseHeader(QIODevice &file, header_t &header);
+	static QByteArray makeHeader(const QByteArray &formatChunk, const quint64 dataSize);
+	static bool updateHeader(const QString &fileName);
+	static bool useWave64(const AudioFileModel_TechInfo &formatInfo, quint64 *const projectedSize = NULL);
+
 private:
+	bool detectNative(const QString &sourceFile, AudioFileModel_TechInfo *info);
+
 	const QString m_binary;
 };